@@ -33,16 +33,28 @@ namespace Arieo
         {
             vmaUnmapMemory(m_vma_alloator, m_vma_allocation);
         }
+
+        // Storage buffer index in the bindless heap, UINT32_MAX when not registered.
+        std::uint32_t getBindlessIndex() const
+        {
+            return m_bindless_index;
+        }
     private:
         friend class VulkanDevice;
         friend class VulkanCommandBuffer;
         friend class VulkanDescriptorSet;
         friend class VulkanImage;
+        friend class VulkanBarrierBatch;
+        friend class VulkanReadbackManager;
+        friend class VulkanDescriptorSetResources;
+        friend class VulkanDescriptorBufferSet;
+        friend class VulkanDescriptorBufferPool;
 
         VkBuffer m_vk_buffer;
 
         VmaAllocator m_vma_alloator;
         VmaAllocation m_vma_allocation;
+        std::uint32_t m_bindless_index = UINT32_MAX;
     };
 }
 
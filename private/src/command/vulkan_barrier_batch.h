@@ -0,0 +1,162 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include "../buffer/vulkan_buffer.h"
+#include "../image/vulkan_image.h"
+namespace Arieo
+{
+    // Collects synchronization2 barriers so they can be recorded with a single
+    // vkCmdPipelineBarrier2 / vkCmdSetEvent2 / vkCmdWaitEvents2 call.
+    class VulkanBarrierBatch final
+    {
+    public:
+        void addMemoryBarrier(
+            VkPipelineStageFlags2 src_stage_mask, VkAccessFlags2 src_access_mask,
+            VkPipelineStageFlags2 dst_stage_mask, VkAccessFlags2 dst_access_mask)
+        {
+            VkMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = src_stage_mask;
+            barrier.srcAccessMask = src_access_mask;
+            barrier.dstStageMask = dst_stage_mask;
+            barrier.dstAccessMask = dst_access_mask;
+            m_vk_memory_barriers.emplace_back(barrier);
+        }
+
+        void addBufferBarrier(
+            Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, VkDeviceSize offset, VkDeviceSize size,
+            VkPipelineStageFlags2 src_stage_mask, VkAccessFlags2 src_access_mask,
+            VkPipelineStageFlags2 dst_stage_mask, VkAccessFlags2 dst_access_mask)
+        {
+            VulkanBuffer* vulkan_buffer = buffer.castToInstance<VulkanBuffer>();
+
+            VkBufferMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+            barrier.srcStageMask = src_stage_mask;
+            barrier.srcAccessMask = src_access_mask;
+            barrier.dstStageMask = dst_stage_mask;
+            barrier.dstAccessMask = dst_access_mask;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = vulkan_buffer->m_vk_buffer;
+            barrier.offset = offset;
+            barrier.size = size;
+            m_vk_buffer_barriers.emplace_back(barrier);
+        }
+
+        void addImageBarrier(
+            Base::Interop::RawRef<Interface::RHI::IImage> image, const VkImageSubresourceRange& subresource_range,
+            VkImageLayout old_layout, VkImageLayout new_layout,
+            VkPipelineStageFlags2 src_stage_mask, VkAccessFlags2 src_access_mask,
+            VkPipelineStageFlags2 dst_stage_mask, VkAccessFlags2 dst_access_mask)
+        {
+            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
+
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = src_stage_mask;
+            barrier.srcAccessMask = src_access_mask;
+            barrier.dstStageMask = dst_stage_mask;
+            barrier.dstAccessMask = dst_access_mask;
+            barrier.oldLayout = old_layout;
+            barrier.newLayout = new_layout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = vulkan_image->m_vk_image;
+            barrier.subresourceRange = subresource_range;
+            m_vk_image_barriers.emplace_back(barrier);
+        }
+
+        // Derives stage and access masks from the layouts, for the common transfer/sampling/attachment transitions.
+        void addImageLayoutTransition(
+            Base::Interop::RawRef<Interface::RHI::IImage> image, const VkImageSubresourceRange& subresource_range,
+            VkImageLayout old_layout, VkImageLayout new_layout)
+        {
+            VkPipelineStageFlags2 src_stage_mask;
+            VkAccessFlags2 src_access_mask;
+            VkPipelineStageFlags2 dst_stage_mask;
+            VkAccessFlags2 dst_access_mask;
+            getLayoutStageAccessMask(old_layout, src_stage_mask, src_access_mask);
+            getLayoutStageAccessMask(new_layout, dst_stage_mask, dst_access_mask);
+
+            addImageBarrier(
+                image, subresource_range,
+                old_layout, new_layout,
+                src_stage_mask, src_access_mask,
+                dst_stage_mask, dst_access_mask
+            );
+        }
+
+        static void getLayoutStageAccessMask(VkImageLayout vk_image_layout, VkPipelineStageFlags2& stage_mask, VkAccessFlags2& access_mask)
+        {
+            switch(vk_image_layout)
+            {
+                case VK_IMAGE_LAYOUT_UNDEFINED:
+                case VK_IMAGE_LAYOUT_PREINITIALIZED:
+                    stage_mask = VK_PIPELINE_STAGE_2_NONE;
+                    access_mask = VK_ACCESS_2_NONE;
+                    break;
+                case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+                    stage_mask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT;
+                    access_mask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                    stage_mask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT;
+                    access_mask = VK_ACCESS_2_TRANSFER_READ_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                    stage_mask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+                    access_mask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+                    stage_mask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+                    access_mask = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+                    stage_mask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+                    access_mask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+                    stage_mask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                    access_mask = VK_ACCESS_2_NONE;
+                    break;
+                default:
+                    stage_mask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                    access_mask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+                    break;
+            }
+        }
+
+        bool isEmpty() const
+        {
+            return m_vk_memory_barriers.empty() && m_vk_buffer_barriers.empty() && m_vk_image_barriers.empty();
+        }
+
+        void clear()
+        {
+            m_vk_memory_barriers.clear();
+            m_vk_buffer_barriers.clear();
+            m_vk_image_barriers.clear();
+        }
+
+        // The returned structure points into this batch, keep the batch alive while it is in use.
+        VkDependencyInfo getDependencyInfo() const
+        {
+            VkDependencyInfo dependency_info{};
+            dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dependency_info.memoryBarrierCount = static_cast<uint32_t>(m_vk_memory_barriers.size());
+            dependency_info.pMemoryBarriers = m_vk_memory_barriers.data();
+            dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(m_vk_buffer_barriers.size());
+            dependency_info.pBufferMemoryBarriers = m_vk_buffer_barriers.data();
+            dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(m_vk_image_barriers.size());
+            dependency_info.pImageMemoryBarriers = m_vk_image_barriers.data();
+            return dependency_info;
+        }
+    private:
+        friend class VulkanCommandBuffer;
+
+        std::vector<VkMemoryBarrier2> m_vk_memory_barriers;
+        std::vector<VkBufferMemoryBarrier2> m_vk_buffer_barriers;
+        std::vector<VkImageMemoryBarrier2> m_vk_image_barriers;
+    };
+}
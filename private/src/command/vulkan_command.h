@@ -1,19 +1,27 @@
 #pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
+#include <algorithm>
 #include "../pipeline/vulkan_pipeline.h"
 #include "../framebuffer/vulkan_framebuffer.h"
 #include "../buffer/vulkan_buffer.h"
 #include "../descriptor/vulkan_descriptor.h"
+#include "../descriptor/vulkan_descriptor_buffer.h"
 #include "../image/vulkan_image.h"
+#include "../event/vulkan_event.h"
+#include "../device/vulkan_device_features.h"
+#include "vulkan_barrier_batch.h"
+#include "vulkan_command_state.h"
 namespace Arieo
 {
     class VulkanCommandBuffer final
         : public Interface::RHI::ICommandBuffer
     {
     public:
-        VulkanCommandBuffer(VkCommandBuffer&& vk_command_buffer)
-            : m_vk_command_buffer(std::move(vk_command_buffer))
+        VulkanCommandBuffer(VulkanDeviceFeatures& vulkan_device_features, VkCommandBufferLevel vk_command_buffer_level, VkCommandBuffer&& vk_command_buffer)
+            : m_vulkan_device_features(vulkan_device_features),
+            m_vk_command_buffer_level(vk_command_buffer_level),
+            m_vk_command_buffer(std::move(vk_command_buffer))
         {
 
         }
@@ -34,6 +42,38 @@ namespace Arieo
             {
                 Core::Logger::error("failed to begin recording command buffer");
             }
+            m_shadow_state.invalidate();
+        }
+
+        // Begins a secondary command buffer that continues the render pass of the pipeline inside frame_buffer,
+        // the primary has to begin that render pass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+        void beginSecondary(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, Base::Interop::RawRef<Interface::RHI::IFramebuffer> frame_buffer, std::uint32_t subpass = 0)
+        {
+            if(m_vk_command_buffer_level != VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+            {
+                Core::Logger::error("beginSecondary called on a primary command buffer");
+                return;
+            }
+
+            VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            VulkanFramebuffer* vulkan_framebuffer = frame_buffer.castToInstance<VulkanFramebuffer>();
+
+            VkCommandBufferInheritanceInfo inheritance_info{};
+            inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritance_info.renderPass = vulkan_pipeline->m_vk_render_pass;
+            inheritance_info.subpass = subpass;
+            inheritance_info.framebuffer = vulkan_framebuffer->m_vk_framebuffer;
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            begin_info.pInheritanceInfo = &inheritance_info;
+
+            if(vkBeginCommandBuffer(m_vk_command_buffer, &begin_info) != VK_SUCCESS)
+            {
+                Core::Logger::error("failed to begin recording secondary command buffer");
+            }
+            m_shadow_state.invalidate();
         }
 
         void end() override
@@ -45,6 +85,12 @@ namespace Arieo
         }
 
         void beginRenderPass(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, Base::Interop::RawRef<Interface::RHI::IFramebuffer> frame_buffer) override
+        {
+            beginRenderPass(pipeline, frame_buffer, VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only be filled by executeCommands.
+        void beginRenderPass(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, Base::Interop::RawRef<Interface::RHI::IFramebuffer> frame_buffer, VkSubpassContents vk_subpass_contents)
         {
             VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
             VulkanFramebuffer* vulkan_framebuffer = frame_buffer.castToInstance<VulkanFramebuffer>();
@@ -64,18 +110,174 @@ namespace Arieo
             renderpass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
             renderpass_info.pClearValues = clear_values.data();
 
-            vkCmdBeginRenderPass(m_vk_command_buffer, &renderpass_info, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdBeginRenderPass(m_vk_command_buffer, &renderpass_info, vk_subpass_contents);
+            m_render_pass_framebuffer = vulkan_framebuffer;
         }
         
         void endRenderPass() override
         {
             vkCmdEndRenderPass(m_vk_command_buffer);
+
+            // The render pass moved its attachments to their final layouts
+            if(m_render_pass_framebuffer != nullptr)
+            {
+                for(const VulkanFramebufferAttachment& attachment : m_render_pass_framebuffer->m_attachments)
+                {
+                    attachment.vulkan_image_view->m_vulkan_image.setSubresourceRangeLayout(attachment.vulkan_image_view->m_vk_subresource_range, attachment.vk_final_layout);
+                }
+                m_render_pass_framebuffer = nullptr;
+            }
+        }
+
+        // Render pass instance without render pass objects, required for shader object pipelines. Both attachments
+        // are cleared on load; the color view has to be in COLOR_ATTACHMENT_OPTIMAL and the optional depth view in
+        // DEPTH_STENCIL_ATTACHMENT_OPTIMAL layout, e.g. through pipelineBarrier and prepareDepthImage.
+        bool beginRendering(Base::Interop::RawRef<Interface::RHI::IImageView> color_view, Base::Interop::RawRef<Interface::RHI::IImageView> depth_view, const VkClearColorValue& clear_color = {{0.0f, 0.0f, 0.0f, 1.0f}})
+        {
+            if(m_vulkan_device_features.dynamic_rendering == false)
+            {
+                Core::Logger::error("beginRendering needs dynamic rendering, not supported by the device");
+                return false;
+            }
+
+            VulkanImageView* vulkan_color_view = color_view.castToInstance<VulkanImageView>();
+            VulkanImageView* vulkan_depth_view = depth_view.castToInstance<VulkanImageView>();
+            VkExtent3D extent = vulkan_color_view->getExtent();
+
+            VkRenderingAttachmentInfo color_attachment{};
+            color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            color_attachment.imageView = vulkan_color_view->m_vk_image_view;
+            color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            color_attachment.clearValue.color = clear_color;
+
+            VkRenderingInfo rendering_info{};
+            rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            rendering_info.renderArea.offset = {0, 0};
+            rendering_info.renderArea.extent = {extent.width, extent.height};
+            rendering_info.layerCount = 1;
+            rendering_info.colorAttachmentCount = 1;
+            rendering_info.pColorAttachments = &color_attachment;
+
+            VkRenderingAttachmentInfo depth_attachment{};
+            if(vulkan_depth_view != nullptr)
+            {
+                depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+                depth_attachment.imageView = vulkan_depth_view->m_vk_image_view;
+                depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+                depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                depth_attachment.clearValue.depthStencil = {1.0f, 0};
+                rendering_info.pDepthAttachment = &depth_attachment;
+                // Combined formats have to be given as stencil attachment too
+                if(vulkan_depth_view->m_vk_format == VK_FORMAT_D32_SFLOAT_S8_UINT
+                || vulkan_depth_view->m_vk_format == VK_FORMAT_D24_UNORM_S8_UINT
+                || vulkan_depth_view->m_vk_format == VK_FORMAT_D16_UNORM_S8_UINT)
+                {
+                    rendering_info.pStencilAttachment = &depth_attachment;
+                }
+            }
+
+            m_vulkan_device_features.vk_cmd_begin_rendering(m_vk_command_buffer, &rendering_info);
+
+            // The attachments stay in these layouts after endRendering
+            vulkan_color_view->m_vulkan_image.setSubresourceRangeLayout(vulkan_color_view->m_vk_subresource_range, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+            if(vulkan_depth_view != nullptr)
+            {
+                vulkan_depth_view->m_vulkan_image.setSubresourceRangeLayout(vulkan_depth_view->m_vk_subresource_range, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            }
+            return true;
+        }
+
+        void endRendering()
+        {
+            m_vulkan_device_features.vk_cmd_end_rendering(m_vk_command_buffer);
+        }
+
+        void executeCommands(const Base::Interop::RawRef<Interface::RHI::ICommandBuffer>* command_buffers, size_t command_buffer_count)
+        {
+            std::vector<VkCommandBuffer> vk_command_buffers;
+            vk_command_buffers.reserve(command_buffer_count);
+            for(size_t i = 0; i < command_buffer_count; i++)
+            {
+                VulkanCommandBuffer* vulkan_command_buffer = command_buffers[i].castToInstance<VulkanCommandBuffer>();
+                if(vulkan_command_buffer->m_vk_command_buffer_level != VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+                {
+                    Core::Logger::error("executeCommands only accepts secondary command buffers");
+                    continue;
+                }
+                vk_command_buffers.emplace_back(vulkan_command_buffer->m_vk_command_buffer);
+            }
+
+            if(vk_command_buffers.empty() == false)
+            {
+                vkCmdExecuteCommands(m_vk_command_buffer, static_cast<uint32_t>(vk_command_buffers.size()), vk_command_buffers.data());
+                // State set by the secondaries is undefined for the primary afterwards
+                m_shadow_state.invalidate();
+            }
         }
 
+        // Records the pipeline's raster state, topology and vertex input: all of it for shader object pipelines,
+        // the parts the device's extended dynamic state features cover for other pipelines. Change them
+        // afterwards with the setters below.
         void bindPipeline(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline) override
         {
             VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
-            vkCmdBindPipeline(m_vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_pipeline->m_vk_pipeline);
+            if(vulkan_pipeline->isShaderObject())
+            {
+                bindShaderObjects(vulkan_pipeline);
+            }
+            else
+            {
+                if(m_shadow_state.vk_pipeline == vulkan_pipeline->m_vk_pipeline)
+                {
+                    m_elision_counters.pipeline_binds++;
+                }
+                else
+                {
+                    vkCmdBindPipeline(m_vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_pipeline->m_vk_pipeline);
+                    m_shadow_state.vk_pipeline = vulkan_pipeline->m_vk_pipeline;
+                    m_shadow_state.vk_pipeline_layout = vulkan_pipeline->m_vk_pipeline_layout;
+                    m_bound_push_constant_ranges = &vulkan_pipeline->m_vk_push_constant_ranges;
+
+                    // The pipeline replaces bound shader objects, and its static state replaces their dynamic state.
+                    // Dynamic state set earlier stays, as every pipeline of the device leaves the same state dynamic.
+                    bool was_shader_object = m_shadow_state.vk_shaders[0] != VK_NULL_HANDLE;
+                    m_shadow_state.vk_shaders.fill(VK_NULL_HANDLE);
+                    m_shadow_state.is_shader_object_state_valid = false;
+                    if(was_shader_object
+                    || m_vulkan_device_features.extended_dynamic_state == false
+                    || m_vulkan_device_features.extended_dynamic_state2 == false
+                    || m_vulkan_device_features.extended_dynamic_state3 == false)
+                    {
+                        m_shadow_state.is_raster_state_valid = false;
+                    }
+                    if(was_shader_object || m_vulkan_device_features.extended_dynamic_state == false)
+                    {
+                        m_shadow_state.is_topology_valid = false;
+                    }
+                    if(was_shader_object || m_vulkan_device_features.vertex_input_dynamic_state == false)
+                    {
+                        m_shadow_state.vertex_layout = nullptr;
+                    }
+                }
+
+                if(m_vulkan_device_features.extended_dynamic_state)
+                {
+                    setPrimitiveTopology(vulkan_pipeline->m_vk_topology);
+                }
+                if(m_vulkan_device_features.vertex_input_dynamic_state)
+                {
+                    setVertexInput(vulkan_pipeline->m_vertex_layout);
+                }
+                if(m_vulkan_device_features.extended_dynamic_state
+                || m_vulkan_device_features.extended_dynamic_state2
+                || m_vulkan_device_features.extended_dynamic_state3)
+                {
+                    setRasterState(vulkan_pipeline->m_raster_state);
+                }
+            }
 
             VkViewport viewport{};
             viewport.x = 0.0f;
@@ -84,38 +286,297 @@ namespace Arieo
             viewport.height = static_cast<float>(vulkan_pipeline->m_vk_framebuffer_extent.height);
             viewport.minDepth = 0.0f;
             viewport.maxDepth = 1.0f;
-            vkCmdSetViewport(m_vk_command_buffer, 0, 1, &viewport);
+            setViewport(viewport);
 
             VkRect2D scissor{};
             scissor.offset = {0, 0};
             scissor.extent = {vulkan_pipeline->m_vk_framebuffer_extent.width, vulkan_pipeline->m_vk_framebuffer_extent.height};
-            vkCmdSetScissor(m_vk_command_buffer, 0, 1, &scissor);            
+            setScissor(scissor);
+        }
+
+        void setViewport(const VkViewport& viewport)
+        {
+            if(m_shadow_state.is_viewport_valid && VulkanCommandShadowState::isSameViewport(m_shadow_state.vk_viewport, viewport))
+            {
+                m_elision_counters.viewport_sets++;
+                return;
+            }
+            vkCmdSetViewport(m_vk_command_buffer, 0, 1, &viewport);
+            m_shadow_state.is_viewport_valid = true;
+            m_shadow_state.vk_viewport = viewport;
+        }
+
+        void setScissor(const VkRect2D& scissor)
+        {
+            if(m_shadow_state.is_scissor_valid && VulkanCommandShadowState::isSameScissor(m_shadow_state.vk_scissor, scissor))
+            {
+                m_elision_counters.scissor_sets++;
+                return;
+            }
+            vkCmdSetScissor(m_vk_command_buffer, 0, 1, &scissor);
+            m_shadow_state.is_scissor_valid = true;
+            m_shadow_state.vk_scissor = scissor;
+        }
+
+        // Records the fields the bound pipeline leaves dynamic, all of them for shader objects. For other pipelines
+        // cull mode, front face and depth test need extended_dynamic_state, rasterizer discard and primitive
+        // restart extended_dynamic_state2, polygon mode and blending extended_dynamic_state3; fields the pipeline
+        // bakes keep their baked value.
+        void setRasterState(const VulkanRasterState& raster_state)
+        {
+            // Only the fields that differ from the last recorded state reach the driver
+            const VulkanRasterState* previous_state = m_shadow_state.is_raster_state_valid ? &m_shadow_state.raster_state : nullptr;
+            if(previous_state != nullptr && *previous_state == raster_state)
+            {
+                m_elision_counters.dynamic_state_sets++;
+                return;
+            }
+
+            bool is_shader_object = m_shadow_state.vk_shaders[0] != VK_NULL_HANDLE;
+            bool is_state_dynamic = is_shader_object || m_vulkan_device_features.extended_dynamic_state;
+            bool is_state2_dynamic = is_shader_object || m_vulkan_device_features.extended_dynamic_state2;
+            bool is_state3_dynamic = is_shader_object || m_vulkan_device_features.extended_dynamic_state3;
+
+            if(is_state3_dynamic && (previous_state == nullptr || previous_state->polygon_mode != raster_state.polygon_mode))
+            {
+                m_vulkan_device_features.vk_cmd_set_polygon_mode(m_vk_command_buffer, raster_state.polygon_mode);
+            }
+            if(is_state_dynamic && (previous_state == nullptr || previous_state->cull_mode != raster_state.cull_mode))
+            {
+                m_vulkan_device_features.vk_cmd_set_cull_mode(m_vk_command_buffer, raster_state.cull_mode);
+            }
+            if(is_state_dynamic && (previous_state == nullptr || previous_state->front_face != raster_state.front_face))
+            {
+                m_vulkan_device_features.vk_cmd_set_front_face(m_vk_command_buffer, raster_state.front_face);
+            }
+            if(is_state2_dynamic && (previous_state == nullptr || previous_state->rasterizer_discard_enable != raster_state.rasterizer_discard_enable))
+            {
+                m_vulkan_device_features.vk_cmd_set_rasterizer_discard_enable(m_vk_command_buffer, raster_state.rasterizer_discard_enable ? VK_TRUE : VK_FALSE);
+            }
+            if(is_state2_dynamic && (previous_state == nullptr || previous_state->primitive_restart_enable != raster_state.primitive_restart_enable))
+            {
+                m_vulkan_device_features.vk_cmd_set_primitive_restart_enable(m_vk_command_buffer, raster_state.primitive_restart_enable ? VK_TRUE : VK_FALSE);
+            }
+            if(is_state_dynamic && (previous_state == nullptr || previous_state->depth_test_enable != raster_state.depth_test_enable))
+            {
+                m_vulkan_device_features.vk_cmd_set_depth_test_enable(m_vk_command_buffer, raster_state.depth_test_enable ? VK_TRUE : VK_FALSE);
+            }
+            if(is_state_dynamic && (previous_state == nullptr || previous_state->depth_write_enable != raster_state.depth_write_enable))
+            {
+                m_vulkan_device_features.vk_cmd_set_depth_write_enable(m_vk_command_buffer, raster_state.depth_write_enable ? VK_TRUE : VK_FALSE);
+            }
+            if(is_state_dynamic && (previous_state == nullptr || previous_state->depth_compare_op != raster_state.depth_compare_op))
+            {
+                m_vulkan_device_features.vk_cmd_set_depth_compare_op(m_vk_command_buffer, raster_state.depth_compare_op);
+            }
+            if(is_state3_dynamic && (previous_state == nullptr || previous_state->blend_enable != raster_state.blend_enable))
+            {
+                VkBool32 blend_enable = raster_state.blend_enable ? VK_TRUE : VK_FALSE;
+                m_vulkan_device_features.vk_cmd_set_color_blend_enable(m_vk_command_buffer, 0, 1, &blend_enable);
+            }
+            if(is_state3_dynamic && (previous_state == nullptr || std::memcmp(&previous_state->blend_equation, &raster_state.blend_equation, sizeof(VkColorBlendEquationEXT)) != 0))
+            {
+                m_vulkan_device_features.vk_cmd_set_color_blend_equation(m_vk_command_buffer, 0, 1, &raster_state.blend_equation);
+            }
+            if(is_state3_dynamic && (previous_state == nullptr || previous_state->color_write_mask != raster_state.color_write_mask))
+            {
+                m_vulkan_device_features.vk_cmd_set_color_write_mask(m_vk_command_buffer, 0, 1, &raster_state.color_write_mask);
+            }
+            m_shadow_state.is_raster_state_valid = true;
+            m_shadow_state.raster_state = raster_state;
+        }
+
+        // Single field versions of setRasterState, the other fields keep the value recorded by the last
+        // bindPipeline or setter. Same feature requirements as setRasterState.
+        void setCullMode(VkCullModeFlags cull_mode)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.cull_mode = cull_mode;
+            setRasterState(raster_state);
+        }
+
+        void setFrontFace(VkFrontFace front_face)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.front_face = front_face;
+            setRasterState(raster_state);
+        }
+
+        void setDepthTestEnable(bool depth_test_enable)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.depth_test_enable = depth_test_enable;
+            setRasterState(raster_state);
+        }
+
+        void setDepthWriteEnable(bool depth_write_enable)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.depth_write_enable = depth_write_enable;
+            setRasterState(raster_state);
+        }
+
+        void setDepthCompareOp(VkCompareOp depth_compare_op)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.depth_compare_op = depth_compare_op;
+            setRasterState(raster_state);
+        }
+
+        void setRasterizerDiscardEnable(bool rasterizer_discard_enable)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.rasterizer_discard_enable = rasterizer_discard_enable;
+            setRasterState(raster_state);
+        }
+
+        void setPrimitiveRestartEnable(bool primitive_restart_enable)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.primitive_restart_enable = primitive_restart_enable;
+            setRasterState(raster_state);
+        }
+
+        void setPolygonMode(VkPolygonMode polygon_mode)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.polygon_mode = polygon_mode;
+            setRasterState(raster_state);
+        }
+
+        void setColorBlend(bool blend_enable, const VkColorBlendEquationEXT& blend_equation)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.blend_enable = blend_enable;
+            raster_state.blend_equation = blend_equation;
+            setRasterState(raster_state);
+        }
+
+        void setColorWriteMask(VkColorComponentFlags color_write_mask)
+        {
+            VulkanRasterState raster_state = m_shadow_state.raster_state;
+            raster_state.color_write_mask = color_write_mask;
+            setRasterState(raster_state);
+        }
+
+        // Needs a shader object pipeline or extended_dynamic_state. Without shader objects the topology has to be
+        // of the same class as the pipeline's: points, lines, triangles or patches.
+        void setPrimitiveTopology(VkPrimitiveTopology vk_topology)
+        {
+            if(m_shadow_state.is_topology_valid && m_shadow_state.vk_topology == vk_topology)
+            {
+                m_elision_counters.dynamic_state_sets++;
+                return;
+            }
+            m_vulkan_device_features.vk_cmd_set_primitive_topology(m_vk_command_buffer, vk_topology);
+            m_shadow_state.is_topology_valid = true;
+            m_shadow_state.vk_topology = vk_topology;
+        }
+
+        // Needs a shader object pipeline or vertex_input_dynamic_state. The layout is compared by address, keep it
+        // alive while recording.
+        void setVertexInput(const VulkanVertexLayout& vertex_layout)
+        {
+            if(m_shadow_state.vertex_layout == &vertex_layout)
+            {
+                m_elision_counters.dynamic_state_sets++;
+                return;
+            }
+
+            std::vector<VkVertexInputBindingDescription2EXT> vk_binding_descs(vertex_layout.bindings.size());
+            for(size_t i = 0; i < vertex_layout.bindings.size(); i++)
+            {
+                vk_binding_descs[i].sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
+                vk_binding_descs[i].binding = vertex_layout.bindings[i].binding;
+                vk_binding_descs[i].stride = vertex_layout.bindings[i].stride;
+                vk_binding_descs[i].inputRate = vertex_layout.bindings[i].inputRate;
+                vk_binding_descs[i].divisor = 1;
+            }
+            std::vector<VkVertexInputAttributeDescription2EXT> vk_attribute_descs(vertex_layout.attributes.size());
+            for(size_t i = 0; i < vertex_layout.attributes.size(); i++)
+            {
+                vk_attribute_descs[i].sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
+                vk_attribute_descs[i].location = vertex_layout.attributes[i].location;
+                vk_attribute_descs[i].binding = vertex_layout.attributes[i].binding;
+                vk_attribute_descs[i].format = vertex_layout.attributes[i].format;
+                vk_attribute_descs[i].offset = vertex_layout.attributes[i].offset;
+            }
+            m_vulkan_device_features.vk_cmd_set_vertex_input(
+                m_vk_command_buffer,
+                static_cast<uint32_t>(vk_binding_descs.size()), vk_binding_descs.data(),
+                static_cast<uint32_t>(vk_attribute_descs.size()), vk_attribute_descs.data()
+            );
+            m_shadow_state.vertex_layout = &vertex_layout;
         }
 
         void bindVertexBuffer(Base::Interop::RawRef<Interface::RHI::IBuffer> vertext_buffer, uint32_t offset) override
         {
-            VulkanBuffer* vulkan_buffer = vertext_buffer.castToInstance<VulkanBuffer>();
+            VkDeviceSize vk_offset = offset;
+            bindVertexBuffers(0, &vertext_buffer, &vk_offset, 1);
+        }
+
+        // Binds buffers to consecutive vertex input bindings starting at first_binding, e.g. per-vertex and per-instance streams.
+        void bindVertexBuffers(std::uint32_t first_binding, const Base::Interop::RawRef<Interface::RHI::IBuffer>* vertex_buffers, const VkDeviceSize* offsets, std::uint32_t binding_count)
+        {
+            if(first_binding + binding_count > VulkanCommandShadowState::MAX_VERTEX_BINDINGS)
+            {
+                Core::Logger::error("Vertex buffer bindings {}..{} exceed the supported {} bindings", first_binding, first_binding + binding_count, VulkanCommandShadowState::MAX_VERTEX_BINDINGS);
+                return;
+            }
+
+            std::array<VkBuffer, VulkanCommandShadowState::MAX_VERTEX_BINDINGS> vk_buffers;
+            bool is_redundant = true;
+            for(std::uint32_t i = 0; i < binding_count; i++)
+            {
+                vk_buffers[i] = vertex_buffers[i].castToInstance<VulkanBuffer>()->m_vk_buffer;
+                is_redundant = is_redundant
+                    && m_shadow_state.vk_vertex_buffers[first_binding + i] == vk_buffers[i]
+                    && m_shadow_state.vk_vertex_buffer_offsets[first_binding + i] == offsets[i];
+            }
+
+            if(is_redundant)
+            {
+                m_elision_counters.vertex_buffer_binds++;
+                return;
+            }
+
+            for(std::uint32_t i = 0; i < binding_count; i++)
+            {
+                m_shadow_state.vk_vertex_buffers[first_binding + i] = vk_buffers[i];
+                m_shadow_state.vk_vertex_buffer_offsets[first_binding + i] = offsets[i];
+            }
 
-            VkBuffer vertex_buffers[] = {vulkan_buffer->m_vk_buffer};
-            VkDeviceSize offsets[] = {offset};
             vkCmdBindVertexBuffers(
-                m_vk_command_buffer, 0, 1, 
-                vertex_buffers, 
+                m_vk_command_buffer, first_binding, binding_count, 
+                vk_buffers.data(), 
                 offsets
             );
         }
 
         void bindIndexBuffer(Base::Interop::RawRef<Interface::RHI::IBuffer> vertext_buffer, uint32_t offset) override
         {
-            VulkanBuffer* vulkan_buffer = vertext_buffer.castToInstance<VulkanBuffer>();
+            bindIndexBuffer(vertext_buffer, offset, VK_INDEX_TYPE_UINT16);
+        }
+
+        void bindIndexBuffer(Base::Interop::RawRef<Interface::RHI::IBuffer> index_buffer, VkDeviceSize offset, VkIndexType vk_index_type)
+        {
+            VulkanBuffer* vulkan_buffer = index_buffer.castToInstance<VulkanBuffer>();
+            if(m_shadow_state.vk_index_buffer == vulkan_buffer->m_vk_buffer
+            && m_shadow_state.vk_index_buffer_offset == offset
+            && m_shadow_state.vk_index_type == vk_index_type)
+            {
+                m_elision_counters.index_buffer_binds++;
+                return;
+            }
+            m_shadow_state.vk_index_buffer = vulkan_buffer->m_vk_buffer;
+            m_shadow_state.vk_index_buffer_offset = offset;
+            m_shadow_state.vk_index_type = vk_index_type;
 
-            // VkBuffer vertexBuffers[] = {vulkan_buffer->m_vk_buffer};
-            // VkDeviceSize offsets[] = {0};
             vkCmdBindIndexBuffer(
                 m_vk_command_buffer,
                 vulkan_buffer->m_vk_buffer, 
                 offset,
-                VK_INDEX_TYPE_UINT16
+                vk_index_type
             );
         }
 
@@ -129,6 +590,79 @@ namespace Arieo
             vkCmdDrawIndexed(m_vk_command_buffer, index_count, instance_count, first_index, vertex_offset, first_instance);
         }
 
+        // draw_count commands of VkDrawIndirectCommand read from indirect_buffer, stride 0 means tightly packed.
+        void drawIndirect(Base::Interop::RawRef<Interface::RHI::IBuffer> indirect_buffer, VkDeviceSize offset, std::uint32_t draw_count, std::uint32_t stride = 0)
+        {
+            VkBuffer vk_buffer = indirect_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer;
+            stride = stride != 0 ? stride : sizeof(VkDrawIndirectCommand);
+            if(draw_count <= 1 || m_vulkan_device_features.multi_draw_indirect)
+            {
+                vkCmdDrawIndirect(m_vk_command_buffer, vk_buffer, offset, draw_count, stride);
+                return;
+            }
+
+            // Without multiDrawIndirect every draw needs its own call
+            for(std::uint32_t i = 0; i < draw_count; i++)
+            {
+                vkCmdDrawIndirect(m_vk_command_buffer, vk_buffer, offset + static_cast<VkDeviceSize>(i) * stride, 1, stride);
+            }
+        }
+
+        // draw_count commands of VkDrawIndexedIndirectCommand read from indirect_buffer, stride 0 means tightly packed.
+        void drawIndexedIndirect(Base::Interop::RawRef<Interface::RHI::IBuffer> indirect_buffer, VkDeviceSize offset, std::uint32_t draw_count, std::uint32_t stride = 0)
+        {
+            VkBuffer vk_buffer = indirect_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer;
+            stride = stride != 0 ? stride : sizeof(VkDrawIndexedIndirectCommand);
+            if(draw_count <= 1 || m_vulkan_device_features.multi_draw_indirect)
+            {
+                vkCmdDrawIndexedIndirect(m_vk_command_buffer, vk_buffer, offset, draw_count, stride);
+                return;
+            }
+
+            for(std::uint32_t i = 0; i < draw_count; i++)
+            {
+                vkCmdDrawIndexedIndirect(m_vk_command_buffer, vk_buffer, offset + static_cast<VkDeviceSize>(i) * stride, 1, stride);
+            }
+        }
+
+        // The GPU writes the number of draws into count_buffer, at most max_draw_count commands are consumed.
+        // Requires draw_indirect_count on the device, returns false when it is not available.
+        bool drawIndirectCount(Base::Interop::RawRef<Interface::RHI::IBuffer> indirect_buffer, VkDeviceSize offset, Base::Interop::RawRef<Interface::RHI::IBuffer> count_buffer, VkDeviceSize count_buffer_offset, std::uint32_t max_draw_count, std::uint32_t stride = 0)
+        {
+            if(m_vulkan_device_features.draw_indirect_count == false)
+            {
+                Core::Logger::error("drawIndirectCount is not supported by the device");
+                return false;
+            }
+
+            m_vulkan_device_features.vk_cmd_draw_indirect_count(
+                m_vk_command_buffer,
+                indirect_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer, offset,
+                count_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer, count_buffer_offset,
+                max_draw_count,
+                stride != 0 ? stride : sizeof(VkDrawIndirectCommand)
+            );
+            return true;
+        }
+
+        bool drawIndexedIndirectCount(Base::Interop::RawRef<Interface::RHI::IBuffer> indirect_buffer, VkDeviceSize offset, Base::Interop::RawRef<Interface::RHI::IBuffer> count_buffer, VkDeviceSize count_buffer_offset, std::uint32_t max_draw_count, std::uint32_t stride = 0)
+        {
+            if(m_vulkan_device_features.draw_indirect_count == false)
+            {
+                Core::Logger::error("drawIndexedIndirectCount is not supported by the device");
+                return false;
+            }
+
+            m_vulkan_device_features.vk_cmd_draw_indexed_indirect_count(
+                m_vk_command_buffer,
+                indirect_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer, offset,
+                count_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer, count_buffer_offset,
+                max_draw_count,
+                stride != 0 ? stride : sizeof(VkDrawIndexedIndirectCommand)
+            );
+            return true;
+        }
+
         void copyBuffer(Base::Interop::RawRef<Interface::RHI::IBuffer> src_buffer, Base::Interop::RawRef<Interface::RHI::IBuffer> dest_buffer, uint32_t size) override
         {
             VulkanBuffer* vulkan_src_buffer = src_buffer.castToInstance<VulkanBuffer>();
@@ -147,187 +681,897 @@ namespace Arieo
 
         void copyBufferToImage(Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, Base::Interop::RawRef<Interface::RHI::IImage> image) override
         {
-            VulkanBuffer* vulkan_buffer = buffer.castToInstance<VulkanBuffer>();
             VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
 
-            // Change Image layout befor copy
+            // Whole image upload covers every layer of mip 0, previous contents are discarded.
+            for(std::uint32_t array_layer = 0; array_layer < vulkan_image->m_array_layers; array_layer++)
             {
-                VkImageMemoryBarrier barrier{};
-                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-
-                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                vulkan_image->setSubresourceLayout(0, array_layer, VK_IMAGE_LAYOUT_UNDEFINED);
+            }
 
-                barrier.image = vulkan_image->m_vk_image;
-                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                barrier.subresourceRange.baseMipLevel = 0;
-                barrier.subresourceRange.levelCount = 1;
-                barrier.subresourceRange.baseArrayLayer = 0;
-                barrier.subresourceRange.layerCount = 1;
+            VulkanBufferImageCopyRegion region;
+            region.layer_count = vulkan_image->m_array_layers;
+            copyBufferToImage(buffer, image, &region, 1);
+        }
 
-                barrier.srcAccessMask = 0;
-                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        // Uploads only the given regions, subresources that are not touched keep their contents and layout.
+        void copyBufferToImage(Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, Base::Interop::RawRef<Interface::RHI::IImage> image, const VulkanBufferImageCopyRegion* regions, size_t region_count)
+        {
+            VulkanBuffer* vulkan_buffer = buffer.castToInstance<VulkanBuffer>();
+            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
 
-                vkCmdPipelineBarrier(
-                    m_vk_command_buffer,
-                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,
-                    0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &barrier
-                );
+            std::vector<VkBufferImageCopy> vk_regions;
+            vk_regions.reserve(region_count);
+            for(size_t i = 0; i < region_count; i++)
+            {
+                if(vulkan_image->isCopyRegionValid(regions[i]) == false)
+                {
+                    return;
+                }
+                vk_regions.emplace_back(makeBufferImageCopy(vulkan_image, regions[i]));
             }
 
-            // Copy image
+            // Change Image layout befor copy
             {
-                VkBufferImageCopy region = {};
-                region.bufferOffset = 0;
-                region.bufferRowLength = 0;
-                region.bufferImageHeight = 0;
-                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                region.imageSubresource.mipLevel = 0;
-                region.imageSubresource.baseArrayLayer = 0;
-                region.imageSubresource.layerCount = 1;
-                region.imageOffset = {0, 0, 0};
-                region.imageExtent = {vulkan_image->m_vk_image_extent.width, vulkan_image->m_vk_image_extent.height, 1};
-
-                vkCmdCopyBufferToImage(
-                    m_vk_command_buffer, 
-                    vulkan_buffer->m_vk_buffer,
-                    vulkan_image->m_vk_image,
-                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-                    1, 
-                    &region
-                );
+                VulkanBarrierBatch barrier_batch;
+                for(size_t i = 0; i < region_count; i++)
+                {
+                    transitionImageLayers(barrier_batch, image, regions[i].mip_level, regions[i].base_array_layer, regions[i].layer_count, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+                }
+                pipelineBarrier(barrier_batch);
             }
 
+            // Copy image
+            vkCmdCopyBufferToImage(
+                m_vk_command_buffer, 
+                vulkan_buffer->m_vk_buffer,
+                vulkan_image->m_vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
+                static_cast<uint32_t>(vk_regions.size()), 
+                vk_regions.data()
+            );
+
             // Chanage Image layout after copy
             {
-                VkImageMemoryBarrier barrier{};
-                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                barrier.image = vulkan_image->m_vk_image;
-                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                barrier.subresourceRange.baseMipLevel = 0;
-                barrier.subresourceRange.levelCount = 1;
-                barrier.subresourceRange.baseArrayLayer = 0;
-                barrier.subresourceRange.layerCount = 1;
-
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                vkCmdPipelineBarrier(
-                    m_vk_command_buffer,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,
-                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                    0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &barrier
-                );
+                VulkanBarrierBatch barrier_batch;
+                for(size_t i = 0; i < region_count; i++)
+                {
+                    transitionImageLayers(barrier_batch, image, regions[i].mip_level, regions[i].base_array_layer, regions[i].layer_count, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                }
+                pipelineBarrier(barrier_batch);
             }
         }
 
-        void prepareDepthImage(Base::Interop::RawRef<Interface::RHI::IImage> depth_image) override
+        // Reads the given regions back into a buffer. Touched subresources return to the layout they were in,
+        // the region layout of the buffer follows the same rules as copyBufferToImage.
+        void copyImageToBuffer(Base::Interop::RawRef<Interface::RHI::IImage> image, Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, const VulkanBufferImageCopyRegion* regions, size_t region_count)
         {
-            // VulkanImage* vulkan_depth_image = depth_image.castToInstance<VulkanImage>();
-            // Chanage Image layout after copy
-            {
-                VkImageMemoryBarrier barrier{};
-                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-                VulkanImage* vulkan_depth_image = depth_image.castToInstance<VulkanImage>();
-                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                barrier.image = vulkan_depth_image->m_vk_image;
-                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            VulkanBuffer* vulkan_buffer = buffer.castToInstance<VulkanBuffer>();
+            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
 
-                if(vulkan_depth_image->m_vk_image_format == VK_FORMAT_D32_SFLOAT_S8_UINT 
-                || vulkan_depth_image->m_vk_image_format == VK_FORMAT_D24_UNORM_S8_UINT 
-                )
+            std::vector<VkBufferImageCopy> vk_regions;
+            vk_regions.reserve(region_count);
+            for(size_t i = 0; i < region_count; i++)
+            {
+                if(vulkan_image->isCopyRegionValid(regions[i]) == false)
                 {
-                    barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+                    return;
                 }
+                vk_regions.emplace_back(makeBufferImageCopy(vulkan_image, regions[i]));
+            }
 
-                barrier.subresourceRange.baseMipLevel = 0;
-                barrier.subresourceRange.levelCount = 1;
-                barrier.subresourceRange.baseArrayLayer = 0;
-                barrier.subresourceRange.layerCount = 1;
+            // Remember the layouts to restore after the copy
+            std::vector<VkImageLayout> restore_layouts;
+            for(size_t i = 0; i < region_count; i++)
+            {
+                for(std::uint32_t array_layer = 0; array_layer < regions[i].layer_count; array_layer++)
+                {
+                    VkImageLayout restore_layout = vulkan_image->getSubresourceLayout(regions[i].mip_level, regions[i].base_array_layer + array_layer);
+                    if(restore_layout == VK_IMAGE_LAYOUT_UNDEFINED)
+                    {
+                        Core::Logger::warn("Image mip {} layer {} has not been written, its copy is undefined", regions[i].mip_level, regions[i].base_array_layer + array_layer);
+                    }
+                    restore_layouts.emplace_back(restore_layout);
+                }
+            }
+
+            // Change Image layout befor copy
+            {
+                VulkanBarrierBatch barrier_batch;
+                for(size_t i = 0; i < region_count; i++)
+                {
+                    transitionImageLayers(barrier_batch, image, regions[i].mip_level, regions[i].base_array_layer, regions[i].layer_count, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+                }
+                pipelineBarrier(barrier_batch);
+            }
 
-                barrier.srcAccessMask = 0;
-                barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            vkCmdCopyImageToBuffer(
+                m_vk_command_buffer,
+                vulkan_image->m_vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                vulkan_buffer->m_vk_buffer,
+                static_cast<uint32_t>(vk_regions.size()),
+                vk_regions.data()
+            );
 
-                vkCmdPipelineBarrier(
-                    m_vk_command_buffer,
-                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-                    0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &barrier
-                );
+            // Restore Image layout after copy, undefined contents stay in transfer source layout
+            {
+                VulkanBarrierBatch barrier_batch;
+                size_t restore_index = 0;
+                for(size_t i = 0; i < region_count; i++)
+                {
+                    for(std::uint32_t array_layer = 0; array_layer < regions[i].layer_count; array_layer++, restore_index++)
+                    {
+                        VkImageLayout restore_layout = restore_layouts[restore_index];
+                        if(restore_layout != VK_IMAGE_LAYOUT_UNDEFINED && restore_layout != VK_IMAGE_LAYOUT_PREINITIALIZED)
+                        {
+                            transitionImageLayers(barrier_batch, image, regions[i].mip_level, regions[i].base_array_layer + array_layer, 1, restore_layout);
+                        }
+                    }
+                }
+                pipelineBarrier(barrier_batch);
+            }
+        }
+
+        void prepareDepthImage(Base::Interop::RawRef<Interface::RHI::IImage> depth_image) override
+        {
+            VulkanImage* vulkan_depth_image = depth_image.castToInstance<VulkanImage>();
+
+            VkImageSubresourceRange subresource_range{};
+            subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            if(vulkan_depth_image->m_vk_image_format == VK_FORMAT_D32_SFLOAT_S8_UINT 
+            || vulkan_depth_image->m_vk_image_format == VK_FORMAT_D24_UNORM_S8_UINT 
+            )
+            {
+                subresource_range.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+            }
+            subresource_range.baseMipLevel = 0;
+            subresource_range.levelCount = 1;
+            subresource_range.baseArrayLayer = 0;
+            subresource_range.layerCount = 1;
+
+            VulkanBarrierBatch barrier_batch;
+            barrier_batch.addImageBarrier(
+                depth_image, subresource_range,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+            );
+            pipelineBarrier(barrier_batch);
+            vulkan_depth_image->setSubresourceLayout(0, 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        }
+
+        // Records every barrier of the batch with one call.
+        void pipelineBarrier(const VulkanBarrierBatch& barrier_batch)
+        {
+            if(barrier_batch.isEmpty())
+            {
+                return;
+            }
+
+            if(m_vulkan_device_features.synchronization2)
+            {
+                VkDependencyInfo dependency_info = barrier_batch.getDependencyInfo();
+                m_vulkan_device_features.vk_cmd_pipeline_barrier2(m_vk_command_buffer, &dependency_info);
+            }
+            else
+            {
+                recordLegacyBarriers(barrier_batch, nullptr);
+            }
+        }
+
+        // Split barrier: setEvent() right after the producer, waitEvent() with the same batch right before
+        // the consumer, so unrelated work recorded in between can overlap with the transition.
+        void setEvent(VulkanEvent* vulkan_event, const VulkanBarrierBatch& barrier_batch)
+        {
+            if(m_vulkan_device_features.synchronization2)
+            {
+                VkDependencyInfo dependency_info = barrier_batch.getDependencyInfo();
+                m_vulkan_device_features.vk_cmd_set_event2(m_vk_command_buffer, vulkan_event->m_vk_event, &dependency_info);
+            }
+            else
+            {
+                vkCmdSetEvent(m_vk_command_buffer, vulkan_event->m_vk_event, getLegacySrcStageMask(barrier_batch));
+            }
+        }
+
+        void waitEvent(VulkanEvent* vulkan_event, const VulkanBarrierBatch& barrier_batch)
+        {
+            if(m_vulkan_device_features.synchronization2)
+            {
+                VkDependencyInfo dependency_info = barrier_batch.getDependencyInfo();
+                m_vulkan_device_features.vk_cmd_wait_events2(m_vk_command_buffer, 1, &vulkan_event->m_vk_event, &dependency_info);
+            }
+            else
+            {
+                recordLegacyBarriers(barrier_batch, &vulkan_event->m_vk_event);
+            }
+        }
+
+        void resetEvent(VulkanEvent* vulkan_event, VkPipelineStageFlags2 stage_mask)
+        {
+            if(m_vulkan_device_features.synchronization2)
+            {
+                m_vulkan_device_features.vk_cmd_reset_event2(m_vk_command_buffer, vulkan_event->m_vk_event, stage_mask);
+            }
+            else
+            {
+                vkCmdResetEvent(m_vk_command_buffer, vulkan_event->m_vk_event, convertToLegacyStageMask(stage_mask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT));
             }
         }
 
         void bindDescriptorSets(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set) override
+        {
+            std::uint32_t first_set = 0;
+            bindDescriptorSets(pipeline, first_set, &descriptor_set, 1);
+        }
+
+        void bindDescriptorSets(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set, const std::uint32_t* dynamic_offsets, std::uint32_t dynamic_offset_count)
+        {
+            std::uint32_t first_set = 0;
+            bindDescriptorSets(pipeline, first_set, &descriptor_set, 1, dynamic_offsets, dynamic_offset_count);
+        }
+
+        // Binds descriptor_set_count sets starting at set index first_set, other set indices stay bound.
+        // dynamic_offsets holds one offset per *_DYNAMIC descriptor of the sets, in set and binding order.
+        // Binds with dynamic offsets are never elided since the offsets usually change every draw.
+        void bindDescriptorSets(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t first_set, const Base::Interop::RawRef<Interface::RHI::IDescriptorSet>* descriptor_sets, std::uint32_t descriptor_set_count, const std::uint32_t* dynamic_offsets = nullptr, std::uint32_t dynamic_offset_count = 0)
         {
             VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
-            VulkanDescriptorSet* vulkan_descriptor_set = descriptor_set.castToInstance<VulkanDescriptorSet>();
+            if(first_set + descriptor_set_count > vulkan_pipeline->m_vk_descriptor_set_layouts.size())
+            {
+                Core::Logger::error("Descriptor sets {}..{} are outside the pipeline layout", first_set, first_set + descriptor_set_count);
+                return;
+            }
+
+            if(vulkan_pipeline->m_is_descriptor_buffer)
+            {
+                if(dynamic_offset_count != 0)
+                {
+                    Core::Logger::error("Descriptor buffer sets take no dynamic offsets");
+                    return;
+                }
+                bindDescriptorBufferSets(vulkan_pipeline, first_set, descriptor_sets, descriptor_set_count);
+                return;
+            }
+
+            std::array<VkDescriptorSet, VulkanCommandShadowState::MAX_DESCRIPTOR_SETS> vk_descriptor_sets;
+            std::uint32_t expected_dynamic_offset_count = 0;
+            for(std::uint32_t i = 0; i < descriptor_set_count; i++)
+            {
+                VulkanDescriptorSet* vulkan_descriptor_set = descriptor_sets[i].castToInstance<VulkanDescriptorSet>();
+                vk_descriptor_sets[i] = vulkan_descriptor_set->m_vk_descriptor_set;
+                expected_dynamic_offset_count += vulkan_descriptor_set->getDynamicOffsetCount();
+            }
+            if(dynamic_offset_count != expected_dynamic_offset_count)
+            {
+                Core::Logger::error("Descriptor sets need {} dynamic offsets, {} given", expected_dynamic_offset_count, dynamic_offset_count);
+                return;
+            }
+
+            // Sets bound through another pipeline layout are treated as unknown
+            if(m_shadow_state.vk_descriptor_pipeline_layout != vulkan_pipeline->m_vk_pipeline_layout)
+            {
+                m_shadow_state.vk_descriptor_pipeline_layout = vulkan_pipeline->m_vk_pipeline_layout;
+                m_shadow_state.vk_descriptor_sets.fill(VK_NULL_HANDLE);
+            }
+
+            bool is_redundant = dynamic_offset_count == 0;
+            for(std::uint32_t i = 0; i < descriptor_set_count && is_redundant; i++)
+            {
+                is_redundant = m_shadow_state.vk_descriptor_sets[first_set + i] == vk_descriptor_sets[i];
+            }
+            if(is_redundant)
+            {
+                m_elision_counters.descriptor_set_binds++;
+                return;
+            }
+
+            for(std::uint32_t i = 0; i < descriptor_set_count; i++)
+            {
+                m_shadow_state.vk_descriptor_sets[first_set + i] = dynamic_offset_count == 0 ? vk_descriptor_sets[i] : VK_NULL_HANDLE;
+            }
+            // Binding descriptor sets drops the descriptor buffer bindings
+            m_shadow_state.descriptor_buffer_count = 0;
+            m_shadow_state.vk_descriptor_set_buffer_addresses.fill(0);
 
             vkCmdBindDescriptorSets(
                 m_vk_command_buffer, 
                 VK_PIPELINE_BIND_POINT_GRAPHICS, 
                 vulkan_pipeline->m_vk_pipeline_layout, 
-                0, 
-                1, 
-                &vulkan_descriptor_set->m_vk_descriptor_set, 
-                0, 
-                nullptr
+                first_set, 
+                descriptor_set_count, 
+                vk_descriptor_sets.data(), 
+                dynamic_offset_count, 
+                dynamic_offsets
             );
         }
+
+        // Pushes to the layout of the currently bound pipeline. As vkCmdPushConstants requires, each pushed byte
+        // has to lie in a declared range for every stage of stage_flags, and stage_flags has to include all stages
+        // of every range containing the byte.
+        void pushConstants(VkShaderStageFlags stage_flags, std::uint32_t offset, std::uint32_t size, const void* data)
+        {
+            if(m_shadow_state.vk_pipeline_layout == VK_NULL_HANDLE || m_bound_push_constant_ranges == nullptr)
+            {
+                Core::Logger::error("pushConstants needs a bound pipeline");
+                return;
+            }
+            if(size == 0)
+            {
+                Core::Logger::error("pushConstants needs a non-zero size");
+                return;
+            }
+
+            // Checked per range rather than per byte, in 64 bits so offset + size cannot wrap
+            const std::uint64_t push_begin = offset;
+            const std::uint64_t push_end = push_begin + size;
+            const std::vector<VkPushConstantRange>& push_constant_ranges = *m_bound_push_constant_ranges;
+            for(const VkPushConstantRange& push_constant_range : push_constant_ranges)
+            {
+                std::uint64_t range_begin = push_constant_range.offset;
+                std::uint64_t range_end = range_begin + push_constant_range.size;
+                bool is_overlapping = range_begin < push_end && push_begin < range_end;
+                if(is_overlapping && (push_constant_range.stageFlags & stage_flags) != push_constant_range.stageFlags)
+                {
+                    Core::Logger::error("Push constants {}+{} overlap a range of stages {:#x}, stage flags {:#x} have to include all of them",
+                        offset, size, push_constant_range.stageFlags, stage_flags);
+                    return;
+                }
+            }
+
+            // Every stage needs the whole span covered by the ranges declaring that stage, ranges may be split
+            for(VkShaderStageFlags remaining_stage_flags = stage_flags; remaining_stage_flags != 0; remaining_stage_flags &= remaining_stage_flags - 1)
+            {
+                VkShaderStageFlags stage_flag = remaining_stage_flags & (~remaining_stage_flags + 1);
+                std::uint64_t covered_end = push_begin;
+                bool is_extended = true;
+                while(covered_end < push_end && is_extended)
+                {
+                    is_extended = false;
+                    for(const VkPushConstantRange& push_constant_range : push_constant_ranges)
+                    {
+                        std::uint64_t range_begin = push_constant_range.offset;
+                        std::uint64_t range_end = range_begin + push_constant_range.size;
+                        if((push_constant_range.stageFlags & stage_flag) != 0 && range_begin <= covered_end && covered_end < range_end)
+                        {
+                            covered_end = range_end;
+                            is_extended = true;
+                        }
+                    }
+                }
+                if(covered_end < push_end)
+                {
+                    Core::Logger::error("Push constants {}+{} are outside the ranges of the bound pipeline for stage {:#x}", offset, size, stage_flag);
+                    return;
+                }
+            }
+
+            vkCmdPushConstants(m_vk_command_buffer, m_shadow_state.vk_pipeline_layout, stage_flags, offset, size, data);
+        }
+
+        template<typename T>
+        void pushConstants(VkShaderStageFlags stage_flags, std::uint32_t offset, const T& data)
+        {
+            pushConstants(stage_flags, offset, static_cast<std::uint32_t>(sizeof(T)), &data);
+        }
+
+        const VulkanCommandElisionCounters& getElisionCounters() const
+        {
+            return m_elision_counters;
+        }
+
+        void resetElisionCounters()
+        {
+            m_elision_counters = VulkanCommandElisionCounters{};
+        }
+
+        // Call after recording raw vkCmd* calls that change bound state behind the command buffer's back.
+        void invalidateShadowState()
+        {
+            m_shadow_state.invalidate();
+        }
     private:
+        // The region has passed VulkanImage::isCopyRegionValid.
+        static VkBufferImageCopy makeBufferImageCopy(VulkanImage* vulkan_image, const VulkanBufferImageCopyRegion& region)
+        {
+            VkBufferImageCopy vk_region = {};
+            vk_region.bufferOffset = region.buffer_offset;
+            vk_region.bufferRowLength = region.buffer_row_length;
+            vk_region.bufferImageHeight = region.buffer_image_height;
+            // Copies address a single aspect, depth wins for combined depth/stencil images.
+            vk_region.imageSubresource.aspectMask = (vulkan_image->m_vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : vulkan_image->m_vk_aspect_mask;
+            vk_region.imageSubresource.mipLevel = region.mip_level;
+            vk_region.imageSubresource.baseArrayLayer = region.base_array_layer;
+            vk_region.imageSubresource.layerCount = region.layer_count;
+            vk_region.imageOffset = region.image_offset;
+            vk_region.imageExtent = vulkan_image->getCopyExtent(region);
+            return vk_region;
+        }
+
+        // Adds transitions for one mip level of a layer range, neighbouring layers in the same layout share a barrier.
+        void transitionImageLayers(VulkanBarrierBatch& barrier_batch, Base::Interop::RawRef<Interface::RHI::IImage> image, std::uint32_t mip_level, std::uint32_t base_array_layer, std::uint32_t layer_count, VkImageLayout new_layout)
+        {
+            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
+            std::uint32_t end_array_layer = base_array_layer + layer_count;
+
+            std::uint32_t run_begin = base_array_layer;
+            while(run_begin < end_array_layer)
+            {
+                VkImageLayout old_layout = vulkan_image->getSubresourceLayout(mip_level, run_begin);
+                std::uint32_t run_end = run_begin + 1;
+                while(run_end < end_array_layer && vulkan_image->getSubresourceLayout(mip_level, run_end) == old_layout)
+                {
+                    run_end++;
+                }
+
+                if(old_layout != new_layout)
+                {
+                    VkImageSubresourceRange subresource_range{};
+                    subresource_range.aspectMask = vulkan_image->m_vk_aspect_mask;
+                    subresource_range.baseMipLevel = mip_level;
+                    subresource_range.levelCount = 1;
+                    subresource_range.baseArrayLayer = run_begin;
+                    subresource_range.layerCount = run_end - run_begin;
+                    barrier_batch.addImageLayoutTransition(image, subresource_range, old_layout, new_layout);
+                }
+
+                for(std::uint32_t array_layer = run_begin; array_layer < run_end; array_layer++)
+                {
+                    vulkan_image->setSubresourceLayout(mip_level, array_layer, new_layout);
+                }
+                run_begin = run_end;
+            }
+        }
+
+        // Stage and access bits below 2^32 share their values with the legacy enums,
+        // the split-out synchronization2 bits fold back into their legacy parents.
+        static VkPipelineStageFlags convertToLegacyStageMask(VkPipelineStageFlags2 stage_mask, VkPipelineStageFlags empty_stage_mask)
+        {
+            VkPipelineStageFlags legacy_stage_mask = static_cast<VkPipelineStageFlags>(stage_mask & 0xFFFFFFFFull);
+            if(stage_mask & (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT))
+            {
+                legacy_stage_mask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+            }
+            if(stage_mask & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT))
+            {
+                legacy_stage_mask |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            }
+            if(stage_mask & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT)
+            {
+                legacy_stage_mask |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+            }
+            return legacy_stage_mask == 0 ? empty_stage_mask : legacy_stage_mask;
+        }
+
+        static VkAccessFlags convertToLegacyAccessMask(VkAccessFlags2 access_mask)
+        {
+            VkAccessFlags legacy_access_mask = static_cast<VkAccessFlags>(access_mask & 0xFFFFFFFFull);
+            if(access_mask & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT))
+            {
+                legacy_access_mask |= VK_ACCESS_SHADER_READ_BIT;
+            }
+            if(access_mask & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)
+            {
+                legacy_access_mask |= VK_ACCESS_SHADER_WRITE_BIT;
+            }
+            return legacy_access_mask;
+        }
+
+        static VkPipelineStageFlags getLegacySrcStageMask(const VulkanBarrierBatch& barrier_batch)
+        {
+            VkPipelineStageFlags2 src_stage_mask = 0;
+            for(const VkMemoryBarrier2& barrier : barrier_batch.m_vk_memory_barriers) { src_stage_mask |= barrier.srcStageMask; }
+            for(const VkBufferMemoryBarrier2& barrier : barrier_batch.m_vk_buffer_barriers) { src_stage_mask |= barrier.srcStageMask; }
+            for(const VkImageMemoryBarrier2& barrier : barrier_batch.m_vk_image_barriers) { src_stage_mask |= barrier.srcStageMask; }
+            return convertToLegacyStageMask(src_stage_mask, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        }
+
+        // Fallback for devices without synchronization2, the per-barrier stage masks are merged into one call.
+        void recordLegacyBarriers(const VulkanBarrierBatch& barrier_batch, VkEvent* vk_wait_event)
+        {
+            VkPipelineStageFlags2 src_stage_mask = 0;
+            VkPipelineStageFlags2 dst_stage_mask = 0;
+
+            std::vector<VkMemoryBarrier> memory_barriers;
+            memory_barriers.reserve(barrier_batch.m_vk_memory_barriers.size());
+            for(const VkMemoryBarrier2& barrier2 : barrier_batch.m_vk_memory_barriers)
+            {
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = convertToLegacyAccessMask(barrier2.srcAccessMask);
+                barrier.dstAccessMask = convertToLegacyAccessMask(barrier2.dstAccessMask);
+                memory_barriers.emplace_back(barrier);
+                src_stage_mask |= barrier2.srcStageMask;
+                dst_stage_mask |= barrier2.dstStageMask;
+            }
+
+            std::vector<VkBufferMemoryBarrier> buffer_barriers;
+            buffer_barriers.reserve(barrier_batch.m_vk_buffer_barriers.size());
+            for(const VkBufferMemoryBarrier2& barrier2 : barrier_batch.m_vk_buffer_barriers)
+            {
+                VkBufferMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.srcAccessMask = convertToLegacyAccessMask(barrier2.srcAccessMask);
+                barrier.dstAccessMask = convertToLegacyAccessMask(barrier2.dstAccessMask);
+                barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+                barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+                barrier.buffer = barrier2.buffer;
+                barrier.offset = barrier2.offset;
+                barrier.size = barrier2.size;
+                buffer_barriers.emplace_back(barrier);
+                src_stage_mask |= barrier2.srcStageMask;
+                dst_stage_mask |= barrier2.dstStageMask;
+            }
+
+            std::vector<VkImageMemoryBarrier> image_barriers;
+            image_barriers.reserve(barrier_batch.m_vk_image_barriers.size());
+            for(const VkImageMemoryBarrier2& barrier2 : barrier_batch.m_vk_image_barriers)
+            {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = convertToLegacyAccessMask(barrier2.srcAccessMask);
+                barrier.dstAccessMask = convertToLegacyAccessMask(barrier2.dstAccessMask);
+                barrier.oldLayout = barrier2.oldLayout;
+                barrier.newLayout = barrier2.newLayout;
+                barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+                barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+                barrier.image = barrier2.image;
+                barrier.subresourceRange = barrier2.subresourceRange;
+                image_barriers.emplace_back(barrier);
+                src_stage_mask |= barrier2.srcStageMask;
+                dst_stage_mask |= barrier2.dstStageMask;
+            }
+
+            VkPipelineStageFlags legacy_src_stage_mask = convertToLegacyStageMask(src_stage_mask, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            VkPipelineStageFlags legacy_dst_stage_mask = convertToLegacyStageMask(dst_stage_mask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+            if(vk_wait_event != nullptr)
+            {
+                vkCmdWaitEvents(
+                    m_vk_command_buffer,
+                    1, vk_wait_event,
+                    legacy_src_stage_mask,
+                    legacy_dst_stage_mask,
+                    static_cast<uint32_t>(memory_barriers.size()), memory_barriers.data(),
+                    static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                    static_cast<uint32_t>(image_barriers.size()), image_barriers.data()
+                );
+            }
+            else
+            {
+                vkCmdPipelineBarrier(
+                    m_vk_command_buffer,
+                    legacy_src_stage_mask,
+                    legacy_dst_stage_mask,
+                    0,
+                    static_cast<uint32_t>(memory_barriers.size()), memory_barriers.data(),
+                    static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                    static_cast<uint32_t>(image_barriers.size()), image_barriers.data()
+                );
+            }
+        }
+
+        // Descriptor buffers are bound once and kept across calls, sets are selected by buffer index and offset.
+        void bindShaderObjects(VulkanPipeline* vulkan_pipeline)
+        {
+            // Stages are bound one by one, a stage shared with the previous pipeline stays bound
+            static constexpr std::array<VkShaderStageFlagBits, 2> vk_stages = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
+            for(size_t stage_index = 0; stage_index < vk_stages.size(); stage_index++)
+            {
+                if(m_shadow_state.vk_shaders[stage_index] == vulkan_pipeline->m_vk_shaders[stage_index])
+                {
+                    m_elision_counters.shader_binds++;
+                    continue;
+                }
+                m_vulkan_device_features.vk_cmd_bind_shaders(m_vk_command_buffer, 1, &vk_stages[stage_index], &vulkan_pipeline->m_vk_shaders[stage_index]);
+                m_shadow_state.vk_shaders[stage_index] = vulkan_pipeline->m_vk_shaders[stage_index];
+            }
+
+            // A pipeline only recorded the state its extended dynamic state features cover, the rest was baked
+            // and still has to be set for the shader objects
+            if(m_shadow_state.vk_pipeline != VK_NULL_HANDLE)
+            {
+                if(m_vulkan_device_features.extended_dynamic_state == false
+                || m_vulkan_device_features.extended_dynamic_state2 == false
+                || m_vulkan_device_features.extended_dynamic_state3 == false)
+                {
+                    m_shadow_state.is_raster_state_valid = false;
+                }
+                if(m_vulkan_device_features.extended_dynamic_state == false)
+                {
+                    m_shadow_state.is_topology_valid = false;
+                }
+                if(m_vulkan_device_features.vertex_input_dynamic_state == false)
+                {
+                    m_shadow_state.vertex_layout = nullptr;
+                }
+            }
+            m_shadow_state.vk_pipeline = VK_NULL_HANDLE;
+            m_shadow_state.vk_pipeline_layout = vulkan_pipeline->m_vk_pipeline_layout;
+            m_bound_push_constant_ranges = &vulkan_pipeline->m_vk_push_constant_ranges;
+
+            if(m_shadow_state.is_shader_object_state_valid == false)
+            {
+                recordShaderObjectState(vulkan_pipeline->m_vk_framebuffer_extent);
+            }
+            setPrimitiveTopology(vulkan_pipeline->m_vk_topology);
+            setVertexInput(vulkan_pipeline->m_vertex_layout);
+            setRasterState(vulkan_pipeline->m_raster_state);
+        }
+
+        // Everything a shader object draw needs that no setter covers, recorded once per command buffer
+        void recordShaderObjectState(const VkExtent3D& vk_extent)
+        {
+            // Stages the enabled features allow have to be bound explicitly, even when unused
+            const VkPhysicalDeviceFeatures& enabled_core_features = m_vulkan_device_features.getEnabledCoreFeatures();
+            std::vector<VkShaderStageFlagBits> vk_unused_stages;
+            if(enabled_core_features.tessellationShader == VK_TRUE)
+            {
+                vk_unused_stages.emplace_back(VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT);
+                vk_unused_stages.emplace_back(VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT);
+            }
+            if(enabled_core_features.geometryShader == VK_TRUE)
+            {
+                vk_unused_stages.emplace_back(VK_SHADER_STAGE_GEOMETRY_BIT);
+            }
+            if(vk_unused_stages.empty() == false)
+            {
+                std::vector<VkShaderEXT> vk_null_shaders(vk_unused_stages.size(), VK_NULL_HANDLE);
+                m_vulkan_device_features.vk_cmd_bind_shaders(m_vk_command_buffer, static_cast<uint32_t>(vk_unused_stages.size()), vk_unused_stages.data(), vk_null_shaders.data());
+            }
+
+            // The viewport count is dynamic too, later setViewport calls only change the viewport itself
+            VkViewport viewport{};
+            viewport.width = static_cast<float>(vk_extent.width);
+            viewport.height = static_cast<float>(vk_extent.height);
+            viewport.maxDepth = 1.0f;
+            VkRect2D scissor{};
+            scissor.extent = {vk_extent.width, vk_extent.height};
+            m_vulkan_device_features.vk_cmd_set_viewport_with_count(m_vk_command_buffer, 1, &viewport);
+            m_vulkan_device_features.vk_cmd_set_scissor_with_count(m_vk_command_buffer, 1, &scissor);
+            m_shadow_state.is_viewport_valid = true;
+            m_shadow_state.vk_viewport = viewport;
+            m_shadow_state.is_scissor_valid = true;
+            m_shadow_state.vk_scissor = scissor;
+
+            VkSampleMask sample_mask = ~0u;
+            m_vulkan_device_features.vk_cmd_set_rasterization_samples(m_vk_command_buffer, VK_SAMPLE_COUNT_1_BIT);
+            m_vulkan_device_features.vk_cmd_set_sample_mask(m_vk_command_buffer, VK_SAMPLE_COUNT_1_BIT, &sample_mask);
+            m_vulkan_device_features.vk_cmd_set_alpha_to_coverage_enable(m_vk_command_buffer, VK_FALSE);
+            m_vulkan_device_features.vk_cmd_set_depth_bias_enable(m_vk_command_buffer, VK_FALSE);
+            m_vulkan_device_features.vk_cmd_set_depth_bounds_test_enable(m_vk_command_buffer, VK_FALSE);
+            m_vulkan_device_features.vk_cmd_set_stencil_test_enable(m_vk_command_buffer, VK_FALSE);
+            vkCmdSetLineWidth(m_vk_command_buffer, 1.0f);
+            if(enabled_core_features.alphaToOne == VK_TRUE)
+            {
+                m_vulkan_device_features.vk_cmd_set_alpha_to_one_enable(m_vk_command_buffer, VK_FALSE);
+            }
+            if(enabled_core_features.logicOp == VK_TRUE)
+            {
+                m_vulkan_device_features.vk_cmd_set_logic_op_enable(m_vk_command_buffer, VK_FALSE);
+            }
+            if(enabled_core_features.depthClamp == VK_TRUE)
+            {
+                m_vulkan_device_features.vk_cmd_set_depth_clamp_enable(m_vk_command_buffer, VK_FALSE);
+            }
+            m_shadow_state.is_shader_object_state_valid = true;
+        }
+
+        void bindDescriptorBufferSets(VulkanPipeline* vulkan_pipeline, std::uint32_t first_set, const Base::Interop::RawRef<Interface::RHI::IDescriptorSet>* descriptor_sets, std::uint32_t descriptor_set_count)
+        {
+            std::uint32_t max_buffer_count = std::min<std::uint32_t>({
+                VulkanCommandShadowState::MAX_DESCRIPTOR_SETS,
+                m_vulkan_device_features.descriptor_buffer_properties.maxResourceDescriptorBufferBindings,
+                m_vulkan_device_features.descriptor_buffer_properties.maxSamplerDescriptorBufferBindings
+            });
+
+            // Sets bound through another pipeline layout are treated as unknown
+            if(m_shadow_state.vk_descriptor_pipeline_layout != vulkan_pipeline->m_vk_pipeline_layout)
+            {
+                m_shadow_state.vk_descriptor_pipeline_layout = vulkan_pipeline->m_vk_pipeline_layout;
+                m_shadow_state.vk_descriptor_set_buffer_addresses.fill(0);
+            }
+
+            // Sets of this call replace the live ones at their indices
+            std::array<VkDeviceAddress, VulkanCommandShadowState::MAX_DESCRIPTOR_SETS> vk_set_addresses = m_shadow_state.vk_descriptor_set_buffer_addresses;
+            std::array<VkDeviceSize, VulkanCommandShadowState::MAX_DESCRIPTOR_SETS> set_offsets = m_shadow_state.descriptor_set_buffer_offsets;
+            for(std::uint32_t i = 0; i < descriptor_set_count; i++)
+            {
+                VulkanDescriptorBufferSet* vulkan_descriptor_set = descriptor_sets[i].castToInstance<VulkanDescriptorBufferSet>();
+                vk_set_addresses[first_set + i] = vulkan_descriptor_set->m_vk_descriptor_buffer_address;
+                set_offsets[first_set + i] = vulkan_descriptor_set->m_offset;
+            }
+
+            // Buffers already bound are kept, new ones are appended while binding slots are left
+            std::array<VkDeviceAddress, VulkanCommandShadowState::MAX_DESCRIPTOR_SETS> vk_buffer_addresses = m_shadow_state.vk_descriptor_buffer_addresses;
+            std::uint32_t buffer_count = m_shadow_state.descriptor_buffer_count;
+            auto add_buffer = [&vk_buffer_addresses, &buffer_count, max_buffer_count](VkDeviceAddress vk_address)
+            {
+                auto end_iter = vk_buffer_addresses.begin() + buffer_count;
+                if(std::find(vk_buffer_addresses.begin(), end_iter, vk_address) != end_iter)
+                {
+                    return true;
+                }
+                if(buffer_count == max_buffer_count)
+                {
+                    return false;
+                }
+                vk_buffer_addresses[buffer_count++] = vk_address;
+                return true;
+            };
+
+            bool is_rebinding = false;
+            for(std::uint32_t set_index = first_set; set_index < first_set + descriptor_set_count && is_rebinding == false; set_index++)
+            {
+                is_rebinding = add_buffer(vk_set_addresses[set_index]) == false;
+            }
+
+            std::uint32_t offset_first_set = first_set;
+            std::uint32_t offset_set_count = descriptor_set_count;
+            if(is_rebinding)
+            {
+                // Out of binding slots. Rebinding renumbers the buffers, so every live set gets its offset again:
+                // the sets of this call first, then the other live sets as long as their buffers fit.
+                buffer_count = 0;
+                for(std::uint32_t set_index = first_set; set_index < first_set + descriptor_set_count; set_index++)
+                {
+                    if(add_buffer(vk_set_addresses[set_index]) == false)
+                    {
+                        Core::Logger::error("Descriptor sets {}..{} use more descriptor buffers than the {} the device can bind", first_set, first_set + descriptor_set_count, max_buffer_count);
+                        return;
+                    }
+                }
+
+                offset_first_set = 0;
+                offset_set_count = static_cast<std::uint32_t>(vulkan_pipeline->m_vk_descriptor_set_layouts.size());
+                for(std::uint32_t set_index = 0; set_index < VulkanCommandShadowState::MAX_DESCRIPTOR_SETS; set_index++)
+                {
+                    bool is_call_set = set_index >= first_set && set_index < first_set + descriptor_set_count;
+                    if(vk_set_addresses[set_index] == 0 || is_call_set)
+                    {
+                        continue;
+                    }
+                    if(set_index >= offset_set_count || add_buffer(vk_set_addresses[set_index]) == false)
+                    {
+                        Core::Logger::error("Descriptor set {} is unbound, its descriptor buffer no longer fits the binding slots", set_index);
+                        vk_set_addresses[set_index] = 0;
+                    }
+                }
+            }
+
+            if(buffer_count != m_shadow_state.descriptor_buffer_count
+            || std::equal(vk_buffer_addresses.begin(), vk_buffer_addresses.begin() + buffer_count, m_shadow_state.vk_descriptor_buffer_addresses.begin()) == false)
+            {
+                std::array<VkDescriptorBufferBindingInfoEXT, VulkanCommandShadowState::MAX_DESCRIPTOR_SETS> buffer_binding_infos{};
+                for(std::uint32_t i = 0; i < buffer_count; i++)
+                {
+                    buffer_binding_infos[i].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+                    buffer_binding_infos[i].address = vk_buffer_addresses[i];
+                    buffer_binding_infos[i].usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+                }
+                m_vulkan_device_features.vk_cmd_bind_descriptor_buffers(m_vk_command_buffer, buffer_count, buffer_binding_infos.data());
+                m_shadow_state.vk_descriptor_buffer_addresses = vk_buffer_addresses;
+                m_shadow_state.descriptor_buffer_count = buffer_count;
+            }
+
+            // One call per run of consecutive live sets, indices in between keep whatever they had
+            std::uint32_t run_begin = offset_first_set;
+            while(run_begin < offset_first_set + offset_set_count)
+            {
+                if(vk_set_addresses[run_begin] == 0)
+                {
+                    run_begin++;
+                    continue;
+                }
+                std::array<std::uint32_t, VulkanCommandShadowState::MAX_DESCRIPTOR_SETS> buffer_indices;
+                std::uint32_t run_end = run_begin;
+                for(; run_end < offset_first_set + offset_set_count && vk_set_addresses[run_end] != 0; run_end++)
+                {
+                    buffer_indices[run_end - run_begin] = static_cast<std::uint32_t>(std::find(vk_buffer_addresses.begin(), vk_buffer_addresses.begin() + buffer_count, vk_set_addresses[run_end]) - vk_buffer_addresses.begin());
+                }
+                m_vulkan_device_features.vk_cmd_set_descriptor_buffer_offsets(
+                    m_vk_command_buffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    vulkan_pipeline->m_vk_pipeline_layout,
+                    run_begin,
+                    run_end - run_begin,
+                    buffer_indices.data(),
+                    set_offsets.data() + run_begin
+                );
+                run_begin = run_end;
+            }
+            m_shadow_state.vk_descriptor_set_buffer_addresses = vk_set_addresses;
+            m_shadow_state.descriptor_set_buffer_offsets = set_offsets;
+
+            // Classic descriptor set bindings are gone once descriptor buffers are used
+            m_shadow_state.vk_descriptor_sets.fill(VK_NULL_HANDLE);
+        }
+
         friend class VulkanCommandPool;
         friend class VulkanRenderCommandQueue;
+        friend class VulkanReadbackManager;
 
+        VulkanDeviceFeatures& m_vulkan_device_features;
+        VkCommandBufferLevel m_vk_command_buffer_level;
         VkCommandBuffer m_vk_command_buffer;
+
+        VulkanCommandShadowState m_shadow_state;
+        VulkanCommandElisionCounters m_elision_counters;
+        const std::vector<VkPushConstantRange>* m_bound_push_constant_ranges = nullptr;
+        // Framebuffer of the render pass being recorded, its attachment layouts are tracked on endRenderPass
+        VulkanFramebuffer* m_render_pass_framebuffer = nullptr;
     };
 
     class VulkanCommandPool final
         : public Interface::RHI::ICommandPool
     {
     public:
-        VulkanCommandPool(VkDevice& vk_device, VkCommandPool&& vk_command_pool)
+        VulkanCommandPool(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, VkCommandPool&& vk_command_pool)
             : m_vk_device(vk_device),
+            m_vulkan_device_features(vulkan_device_features),
             m_vk_command_pool(std::move(vk_command_pool))
         {
 
         }
 
         Base::Interop::RawRef<Interface::RHI::ICommandBuffer> allocateCommandBuffer() override
+        {
+            return allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        }
+
+        Base::Interop::RawRef<Interface::RHI::ICommandBuffer> allocateCommandBuffer(VkCommandBufferLevel vk_command_buffer_level)
         {
             VkCommandBufferAllocateInfo alloc_info{};
             alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
             alloc_info.commandPool = m_vk_command_pool;
-            alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            alloc_info.level = vk_command_buffer_level;
             alloc_info.commandBufferCount = 1;
 
             VkCommandBuffer vk_command_buffer;
             if (vkAllocateCommandBuffers(m_vk_device, &alloc_info, &vk_command_buffer) != VK_SUCCESS) 
             {
                 Core::Logger::error("failed to allocate command buffers!");
+                return nullptr;
             } 
             
-            return Base::Interop::RawRef<Interface::RHI::ICommandBuffer>::createAs<VulkanCommandBuffer>(std::move(vk_command_buffer));
+            return Base::Interop::RawRef<Interface::RHI::ICommandBuffer>::createAs<VulkanCommandBuffer>(m_vulkan_device_features, vk_command_buffer_level, std::move(vk_command_buffer));
+        }
+
+        // One vkAllocateCommandBuffers call for the whole batch.
+        std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>> allocateCommandBuffers(std::uint32_t count, VkCommandBufferLevel vk_command_buffer_level)
+        {
+            std::vector<VkCommandBuffer> vk_command_buffers(count);
+
+            VkCommandBufferAllocateInfo alloc_info{};
+            alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            alloc_info.commandPool = m_vk_command_pool;
+            alloc_info.level = vk_command_buffer_level;
+            alloc_info.commandBufferCount = count;
+
+            std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>> command_buffers;
+            if (vkAllocateCommandBuffers(m_vk_device, &alloc_info, vk_command_buffers.data()) != VK_SUCCESS) 
+            {
+                Core::Logger::error("failed to allocate {} command buffers!", count);
+                return command_buffers;
+            }
+
+            command_buffers.reserve(count);
+            for(VkCommandBuffer& vk_command_buffer : vk_command_buffers)
+            {
+                command_buffers.emplace_back(Base::Interop::RawRef<Interface::RHI::ICommandBuffer>::createAs<VulkanCommandBuffer>(m_vulkan_device_features, vk_command_buffer_level, std::move(vk_command_buffer)));
+            }
+            return command_buffers;
+        }
+
+        // Returns every command buffer of the pool to the initial state at once.
+        void reset()
+        {
+            VkResult result = vkResetCommandPool(m_vk_device, m_vk_command_pool, 0);
+            if(result != VK_SUCCESS)
+            {
+                Core::Logger::error("failed to reset command pool: {}", VulkanUtility::covertVkResultToString(result));
+            }
         }
 
         void freeCommandBuffer(Base::Interop::RawRef<Interface::RHI::ICommandBuffer> command_buffer) override
@@ -339,7 +1583,10 @@ namespace Arieo
         friend class VulkanDevice;
         friend class VulkanRenderCommandQueue;
         friend class VulkanPresentCommandQueue;
+        friend class VulkanThreadCommandPools;
+        friend class VulkanFrameCommandPools;
         VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
         VkCommandPool m_vk_command_pool;
     };
 
@@ -0,0 +1,94 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <array>
+#include <cstring>
+#include "../pipeline/vulkan_pipeline.h"
+namespace Arieo
+{
+    // How many binds and dynamic state sets were skipped because the same state was already set.
+    struct VulkanCommandElisionCounters
+    {
+        std::uint64_t pipeline_binds = 0;
+        std::uint64_t viewport_sets = 0;
+        std::uint64_t scissor_sets = 0;
+        std::uint64_t vertex_buffer_binds = 0;
+        std::uint64_t index_buffer_binds = 0;
+        std::uint64_t descriptor_set_binds = 0;
+        std::uint64_t shader_binds = 0;
+        std::uint64_t dynamic_state_sets = 0;
+
+        std::uint64_t getTotal() const
+        {
+            return pipeline_binds + viewport_sets + scissor_sets + vertex_buffer_binds + index_buffer_binds + descriptor_set_binds
+                + shader_binds + dynamic_state_sets;
+        }
+    };
+
+    // Shadow of the state last recorded into a command buffer. VK_NULL_HANDLE and the valid flags mean unknown,
+    // unknown state never matches so the next call always reaches the driver.
+    struct VulkanCommandShadowState
+    {
+        static constexpr std::uint32_t MAX_VERTEX_BINDINGS = 16;
+        static constexpr std::uint32_t MAX_DESCRIPTOR_SETS = 8;
+
+        VkPipeline vk_pipeline = VK_NULL_HANDLE;
+        // Layout of vk_pipeline, used by pushConstants
+        VkPipelineLayout vk_pipeline_layout = VK_NULL_HANDLE;
+
+        bool is_viewport_valid = false;
+        VkViewport vk_viewport{};
+        bool is_scissor_valid = false;
+        VkRect2D vk_scissor{};
+
+        std::array<VkBuffer, MAX_VERTEX_BINDINGS> vk_vertex_buffers{};
+        std::array<VkDeviceSize, MAX_VERTEX_BINDINGS> vk_vertex_buffer_offsets{};
+
+        VkBuffer vk_index_buffer = VK_NULL_HANDLE;
+        VkDeviceSize vk_index_buffer_offset = 0;
+        VkIndexType vk_index_type = VK_INDEX_TYPE_UINT16;
+
+        VkPipelineLayout vk_descriptor_pipeline_layout = VK_NULL_HANDLE;
+        std::array<VkDescriptorSet, MAX_DESCRIPTOR_SETS> vk_descriptor_sets{};
+
+        // Descriptor buffers bound with vkCmdBindDescriptorBuffersEXT, in binding index order
+        std::array<VkDeviceAddress, MAX_DESCRIPTOR_SETS> vk_descriptor_buffer_addresses{};
+        std::uint32_t descriptor_buffer_count = 0;
+        // Per set index, buffer address and offset of the descriptor buffer sets bound through
+        // vk_descriptor_pipeline_layout, 0 when the index has none
+        std::array<VkDeviceAddress, MAX_DESCRIPTOR_SETS> vk_descriptor_set_buffer_addresses{};
+        std::array<VkDeviceSize, MAX_DESCRIPTOR_SETS> descriptor_set_buffer_offsets{};
+
+        // Shader objects bound to the vertex and fragment stage
+        std::array<VkShaderEXT, 2> vk_shaders{};
+        // State a shader object draw needs beside the raster state, see VulkanCommandBuffer::bindPipeline
+        bool is_shader_object_state_valid = false;
+
+        bool is_raster_state_valid = false;
+        VulkanRasterState raster_state;
+        bool is_topology_valid = false;
+        VkPrimitiveTopology vk_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        // Layout last passed to setVertexInput, compared by address
+        const VulkanVertexLayout* vertex_layout = nullptr;
+
+        void invalidate()
+        {
+            *this = VulkanCommandShadowState{};
+        }
+
+        static bool isSameViewport(const VkViewport& a, const VkViewport& b)
+        {
+            return std::memcmp(&a, &b, sizeof(VkViewport)) == 0;
+        }
+
+        static bool isSameScissor(const VkRect2D& a, const VkRect2D& b)
+        {
+            return a.offset.x == b.offset.x && a.offset.y == b.offset.y
+                && a.extent.width == b.extent.width && a.extent.height == b.extent.height;
+        }
+    };
+}
+
+
+
+
@@ -0,0 +1,89 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include "vulkan_command.h"
+#include "../fence/vulkan_fence.h"
+namespace Arieo
+{
+    // One transient command pool per frame in flight. Command buffers are handed out from bulk allocations
+    // and are recycled together by resetting the whole pool once the frame's fence has signaled.
+    class VulkanFrameCommandPools final
+    {
+    public:
+        struct FramePool
+        {
+            Base::Interop::RawRef<Interface::RHI::ICommandPool> command_pool;
+            std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>> primary_command_buffers;
+            std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>> secondary_command_buffers;
+            size_t used_primary_count = 0;
+            size_t used_secondary_count = 0;
+            VkFence vk_fence = VK_NULL_HANDLE;
+        };
+
+        VulkanFrameCommandPools(VkDevice& vk_device, std::uint32_t command_buffer_batch_size, std::vector<FramePool>&& frame_pools)
+            : m_vk_device(vk_device),
+            m_command_buffer_batch_size(command_buffer_batch_size),
+            m_frame_pools(std::move(frame_pools))
+        {
+
+        }
+
+        // frame_fence is the fence this frame will be submitted with, one fence per frame in flight. Call this before
+        // the fence is reset: the slot waits for the fence of its previous frame, a reset fence would never signal.
+        // The pool of the slot is recycled here.
+        void beginFrame(Base::Interop::RawRef<Interface::RHI::IFence> frame_fence)
+        {
+            m_frame_index = (m_frame_index + 1) % m_frame_pools.size();
+            FramePool& frame_pool = m_frame_pools[m_frame_index];
+
+            if(frame_pool.vk_fence != VK_NULL_HANDLE)
+            {
+                // Normally already signaled, the caller waits on it before reusing the frame resources.
+                vkWaitForFences(m_vk_device, 1, &frame_pool.vk_fence, VK_TRUE, UINT64_MAX);
+            }
+
+            frame_pool.command_pool.castToInstance<VulkanCommandPool>()->reset();
+            frame_pool.used_primary_count = 0;
+            frame_pool.used_secondary_count = 0;
+            frame_pool.vk_fence = frame_fence.castToInstance<VulkanFence>()->m_vk_fence;
+        }
+
+        // Valid until the same frame slot begins again, do not free or reset it individually.
+        Base::Interop::RawRef<Interface::RHI::ICommandBuffer> allocateCommandBuffer(VkCommandBufferLevel vk_command_buffer_level = VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+        {
+            if(m_frame_index >= m_frame_pools.size())
+            {
+                Core::Logger::error("Frame command buffer requested before beginFrame");
+                return nullptr;
+            }
+
+            FramePool& frame_pool = m_frame_pools[m_frame_index];
+            bool is_primary = vk_command_buffer_level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>>& command_buffers = is_primary ? frame_pool.primary_command_buffers : frame_pool.secondary_command_buffers;
+            size_t& used_count = is_primary ? frame_pool.used_primary_count : frame_pool.used_secondary_count;
+
+            if(used_count == command_buffers.size())
+            {
+                std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>> new_command_buffers = frame_pool.command_pool.castToInstance<VulkanCommandPool>()->allocateCommandBuffers(m_command_buffer_batch_size, vk_command_buffer_level);
+                if(new_command_buffers.empty())
+                {
+                    return nullptr;
+                }
+                command_buffers.insert(command_buffers.end(), new_command_buffers.begin(), new_command_buffers.end());
+            }
+            return command_buffers[used_count++];
+        }
+    private:
+        friend class VulkanRenderCommandQueue;
+
+        VkDevice& m_vk_device;
+        std::uint32_t m_command_buffer_batch_size;
+        std::vector<FramePool> m_frame_pools;
+        // Wraps to slot 0 on the first beginFrame
+        size_t m_frame_index = static_cast<size_t>(-1);
+    };
+}
+
+
+
+
@@ -0,0 +1,116 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "vulkan_command.h"
+namespace Arieo
+{
+    // Command pools are externally synchronized, so every recording thread gets its own pool.
+    // Pools are created on first use by a thread and live until the manager is destroyed.
+    class VulkanThreadCommandPools final
+    {
+    public:
+        VulkanThreadCommandPools(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, std::uint32_t queue_family_index)
+            : m_vk_device(vk_device),
+            m_vulkan_device_features(vulkan_device_features),
+            m_queue_family_index(queue_family_index)
+        {
+
+        }
+
+        ~VulkanThreadCommandPools()
+        {
+            for(auto& [thread_id, thread_pool] : m_thread_pool_map)
+            {
+                // Destroying the pool frees its command buffers, only the wrappers are left
+                for(Base::Interop::RawRef<Interface::RHI::ICommandBuffer>& command_buffer : thread_pool.secondary_command_buffers)
+                {
+                    Base::Interop::RawRef<Interface::RHI::ICommandBuffer>::destroyAs<VulkanCommandBuffer>(std::move(command_buffer));
+                }
+                vkDestroyCommandPool(m_vk_device, thread_pool.command_pool.castToInstance<VulkanCommandPool>()->m_vk_command_pool, nullptr);
+                Base::Interop::RawRef<Interface::RHI::ICommandPool>::destroyAs<VulkanCommandPool>(std::move(thread_pool.command_pool));
+            }
+            m_thread_pool_map.clear();
+        }
+
+        // Pool of the calling thread, only use it and its command buffers from that thread.
+        Base::Interop::RawRef<Interface::RHI::ICommandPool> getCommandPool()
+        {
+            ThreadPool* thread_pool = getThreadPool();
+            if(thread_pool == nullptr)
+            {
+                return nullptr;
+            }
+            return thread_pool->command_pool;
+        }
+
+        // Convenience for worker threads recording part of a render pass. The command buffer lives until the manager
+        // is destroyed.
+        Base::Interop::RawRef<Interface::RHI::ICommandBuffer> allocateSecondaryCommandBuffer()
+        {
+            ThreadPool* thread_pool = getThreadPool();
+            if(thread_pool == nullptr)
+            {
+                return nullptr;
+            }
+
+            Base::Interop::RawRef<Interface::RHI::ICommandBuffer> command_buffer = thread_pool->command_pool.castToInstance<VulkanCommandPool>()->allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            if(command_buffer.castToInstance<VulkanCommandBuffer>() == nullptr)
+            {
+                return nullptr;
+            }
+            // Only the owning thread appends to its pool's list
+            thread_pool->secondary_command_buffers.emplace_back(command_buffer);
+            return command_buffer;
+        }
+    private:
+        struct ThreadPool
+        {
+            Base::Interop::RawRef<Interface::RHI::ICommandPool> command_pool;
+            std::vector<Base::Interop::RawRef<Interface::RHI::ICommandBuffer>> secondary_command_buffers;
+        };
+
+        // Map nodes never move, the returned pool stays valid until the manager is destroyed.
+        ThreadPool* getThreadPool()
+        {
+            std::thread::id thread_id = std::this_thread::get_id();
+
+            std::lock_guard<std::mutex> lock(m_command_pool_mutex);
+            auto found_iter = m_thread_pool_map.find(thread_id);
+            if(found_iter != m_thread_pool_map.end())
+            {
+                return &found_iter->second;
+            }
+
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            pool_info.queueFamilyIndex = m_queue_family_index;
+
+            VkCommandPool vk_command_pool;
+            if (vkCreateCommandPool(m_vk_device, &pool_info, nullptr, &vk_command_pool) != VK_SUCCESS)
+            {
+                Core::Logger::error("failed to create thread command pool");
+                return nullptr;
+            }
+
+            ThreadPool& thread_pool = m_thread_pool_map[thread_id];
+            thread_pool.command_pool = Base::Interop::RawRef<Interface::RHI::ICommandPool>::createAs<VulkanCommandPool>(m_vk_device, m_vulkan_device_features, std::move(vk_command_pool));
+            return &thread_pool;
+        }
+
+        VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
+        std::uint32_t m_queue_family_index;
+
+        std::mutex m_command_pool_mutex;
+        std::unordered_map<std::thread::id, ThreadPool> m_thread_pool_map;
+    };
+}
+
+
+
+
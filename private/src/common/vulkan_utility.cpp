@@ -54,8 +54,169 @@ namespace Arieo
         }
         return "UNKNOWN_VK_RESULT";
     }
-}
 
+    std::uint32_t VulkanUtility::getFormatTexelSize(VkFormat format)
+    {
+        switch(format)
+        {
+            case VK_FORMAT_R8_UNORM:
+            case VK_FORMAT_R8_SNORM:
+            case VK_FORMAT_R8_UINT:
+            case VK_FORMAT_R8_SINT:
+            case VK_FORMAT_R8_SRGB:
+            case VK_FORMAT_S8_UINT:
+                return 1;
+            case VK_FORMAT_R8G8_UNORM:
+            case VK_FORMAT_R8G8_SNORM:
+            case VK_FORMAT_R8G8_UINT:
+            case VK_FORMAT_R8G8_SINT:
+            case VK_FORMAT_R16_UNORM:
+            case VK_FORMAT_R16_SNORM:
+            case VK_FORMAT_R16_UINT:
+            case VK_FORMAT_R16_SINT:
+            case VK_FORMAT_R16_SFLOAT:
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_R5G6B5_UNORM_PACK16:
+                return 2;
+            case VK_FORMAT_R8G8B8_UNORM:
+            case VK_FORMAT_R8G8B8_SRGB:
+            case VK_FORMAT_B8G8R8_UNORM:
+            case VK_FORMAT_B8G8R8_SRGB:
+                return 3;
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SNORM:
+            case VK_FORMAT_R8G8B8A8_UINT:
+            case VK_FORMAT_R8G8B8A8_SINT:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+            case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+            case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+            case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+            case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+            case VK_FORMAT_R16G16_UNORM:
+            case VK_FORMAT_R16G16_SFLOAT:
+            case VK_FORMAT_R32_UINT:
+            case VK_FORMAT_R32_SINT:
+            case VK_FORMAT_R32_SFLOAT:
+            case VK_FORMAT_D32_SFLOAT:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            // Depth aspect of packed depth/stencil formats is copied as 4 bytes per texel
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return 4;
+            case VK_FORMAT_R16G16B16A16_UNORM:
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+            case VK_FORMAT_R16G16B16A16_UINT:
+            case VK_FORMAT_R32G32_UINT:
+            case VK_FORMAT_R32G32_SFLOAT:
+                return 8;
+            case VK_FORMAT_R32G32B32_SFLOAT:
+                return 12;
+            case VK_FORMAT_R32G32B32A32_UINT:
+            case VK_FORMAT_R32G32B32A32_SINT:
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    namespace
+    {
+        constexpr std::uint32_t SHA256_ROUND_CONSTANTS[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        std::uint32_t rotateRight(std::uint32_t value, std::uint32_t bit_count)
+        {
+            return (value >> bit_count) | (value << (32 - bit_count));
+        }
+
+        void processSha256Block(std::array<std::uint32_t, 8>& state, const std::uint8_t* block)
+        {
+            std::uint32_t words[64];
+            for(std::uint32_t word_index = 0; word_index < 16; word_index++)
+            {
+                const std::uint8_t* word_bytes = block + word_index * 4;
+                words[word_index] = (std::uint32_t(word_bytes[0]) << 24) | (std::uint32_t(word_bytes[1]) << 16) | (std::uint32_t(word_bytes[2]) << 8) | std::uint32_t(word_bytes[3]);
+            }
+            for(std::uint32_t word_index = 16; word_index < 64; word_index++)
+            {
+                std::uint32_t s0 = rotateRight(words[word_index - 15], 7) ^ rotateRight(words[word_index - 15], 18) ^ (words[word_index - 15] >> 3);
+                std::uint32_t s1 = rotateRight(words[word_index - 2], 17) ^ rotateRight(words[word_index - 2], 19) ^ (words[word_index - 2] >> 10);
+                words[word_index] = words[word_index - 16] + s0 + words[word_index - 7] + s1;
+            }
+
+            std::array<std::uint32_t, 8> working = state;
+            for(std::uint32_t round_index = 0; round_index < 64; round_index++)
+            {
+                std::uint32_t s1 = rotateRight(working[4], 6) ^ rotateRight(working[4], 11) ^ rotateRight(working[4], 25);
+                std::uint32_t choice = (working[4] & working[5]) ^ (~working[4] & working[6]);
+                std::uint32_t temp1 = working[7] + s1 + choice + SHA256_ROUND_CONSTANTS[round_index] + words[round_index];
+                std::uint32_t s0 = rotateRight(working[0], 2) ^ rotateRight(working[0], 13) ^ rotateRight(working[0], 22);
+                std::uint32_t majority = (working[0] & working[1]) ^ (working[0] & working[2]) ^ (working[1] & working[2]);
+                std::uint32_t temp2 = s0 + majority;
+                working[7] = working[6];
+                working[6] = working[5];
+                working[5] = working[4];
+                working[4] = working[3] + temp1;
+                working[3] = working[2];
+                working[2] = working[1];
+                working[1] = working[0];
+                working[0] = temp1 + temp2;
+            }
+            for(size_t state_index = 0; state_index < state.size(); state_index++)
+            {
+                state[state_index] += working[state_index];
+            }
+        }
+    }
 
+    VulkanUtility::Digest VulkanUtility::computeDigest(const void* data, size_t data_size)
+    {
+        std::array<std::uint32_t, 8> state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        size_t full_block_size = data_size - data_size % 64;
+        for(size_t block_offset = 0; block_offset < full_block_size; block_offset += 64)
+        {
+            processSha256Block(state, bytes + block_offset);
+        }
 
+        // Remaining bytes, the 0x80 marker and the message length in bits fill one or two final blocks
+        std::uint8_t tail[128] = {};
+        size_t tail_size = data_size - full_block_size;
+        if(tail_size != 0)
+        {
+            std::memcpy(tail, bytes + full_block_size, tail_size);
+        }
+        tail[tail_size] = 0x80;
+        size_t tail_block_size = tail_size < 56 ? 64 : 128;
+        std::uint64_t bit_count = static_cast<std::uint64_t>(data_size) * 8;
+        for(size_t byte_index = 0; byte_index < 8; byte_index++)
+        {
+            tail[tail_block_size - 1 - byte_index] = static_cast<std::uint8_t>(bit_count >> (byte_index * 8));
+        }
+        for(size_t block_offset = 0; block_offset < tail_block_size; block_offset += 64)
+        {
+            processSha256Block(state, tail + block_offset);
+        }
 
+        Digest digest;
+        for(size_t state_index = 0; state_index < state.size(); state_index++)
+        {
+            digest[state_index * 4 + 0] = static_cast<std::uint8_t>(state[state_index] >> 24);
+            digest[state_index * 4 + 1] = static_cast<std::uint8_t>(state[state_index] >> 16);
+            digest[state_index * 4 + 2] = static_cast<std::uint8_t>(state[state_index] >> 8);
+            digest[state_index * 4 + 3] = static_cast<std::uint8_t>(state[state_index]);
+        }
+        return digest;
+    }
+}
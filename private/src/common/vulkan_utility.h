@@ -1,13 +1,33 @@
 #pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
+#include <array>
+#include <cstring>
 
 namespace Arieo
 {
     class VulkanUtility
     {
     public:
+        // SHA-256 of some bytes, used where two inputs must never share a cache entry
+        using Digest = std::array<std::uint8_t, 32>;
+
+        struct DigestHash
+        {
+            size_t operator()(const Digest& digest) const
+            {
+                size_t hash;
+                std::memcpy(&hash, digest.data(), sizeof(hash));
+                return hash;
+            }
+        };
+
         static const char* covertVkResultToString(VkResult result);
+
+        // Bytes per texel of uncompressed formats, 0 for block compressed or unknown formats.
+        static std::uint32_t getFormatTexelSize(VkFormat format);
+
+        static Digest computeDigest(const void* data, size_t data_size);
     };
 }
 
@@ -0,0 +1,135 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <array>
+#include <mutex>
+#include "vulkan_descriptor.h"
+namespace Arieo
+{
+    // One global descriptor set holding every sampled image, sampler and storage buffer of the device in large
+    // update-after-bind, partially bound arrays. Resources get a stable index at creation that shaders use directly:
+    //   layout(set = N, binding = 0) uniform texture2D bindless_textures[];
+    //   layout(set = N, binding = 1) uniform sampler bindless_samplers[];
+    //   layout(set = N, binding = 2) buffer BindlessBuffer { uint data[]; } bindless_buffers[];
+    // An image's sampler lives at the same index as the image. Registering and unregistering is thread safe,
+    // slots of unused indices may be rewritten while frames referencing other slots are in flight.
+    class VulkanBindlessHeap final
+    {
+    public:
+        static constexpr std::uint32_t INVALID_INDEX = UINT32_MAX;
+        static constexpr std::uint32_t SAMPLED_IMAGE_BINDING = 0;
+        static constexpr std::uint32_t SAMPLER_BINDING = 1;
+        static constexpr std::uint32_t STORAGE_BUFFER_BINDING = 2;
+
+        VulkanBindlessHeap(VkDevice& vk_device, VkDescriptorSetLayout&& vk_descriptor_set_layout, VkDescriptorPool&& vk_descriptor_pool, Base::Interop::RawRef<Interface::RHI::IDescriptorSet>&& descriptor_set, std::vector<VkDescriptorSetLayoutBinding>&& vk_descriptor_bindings, std::uint32_t image_capacity, std::uint32_t buffer_capacity)
+            : m_vk_device(vk_device),
+            m_vk_descriptor_set_layout(std::move(vk_descriptor_set_layout)),
+            m_vk_descriptor_pool(std::move(vk_descriptor_pool)),
+            m_descriptor_set(std::move(descriptor_set)),
+            m_vk_descriptor_bindings(std::move(vk_descriptor_bindings)),
+            m_image_capacity(image_capacity),
+            m_buffer_capacity(buffer_capacity)
+        {
+
+        }
+
+        std::uint32_t registerImage(Base::Interop::RawRef<Interface::RHI::IImage> image)
+        {
+            std::lock_guard<std::mutex> lock(m_heap_mutex);
+            std::uint32_t index = allocateIndex(m_free_image_indices, m_next_image_index, m_image_capacity);
+            if(index == INVALID_INDEX)
+            {
+                Core::Logger::error("Bindless heap is full, {} images registered", m_image_capacity);
+                return INVALID_INDEX;
+            }
+
+            VkDescriptorImageInfo image_info = VulkanDescriptorSet::getImageInfo(image);
+            std::array<VkWriteDescriptorSet, 2> descriptor_writes{};
+            descriptor_writes[0] = getWrite(SAMPLED_IMAGE_BINDING, index, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+            descriptor_writes[0].pImageInfo = &image_info;
+            descriptor_writes[1] = getWrite(SAMPLER_BINDING, index, VK_DESCRIPTOR_TYPE_SAMPLER);
+            descriptor_writes[1].pImageInfo = &image_info;
+            vkUpdateDescriptorSets(m_vk_device, static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data(), 0, nullptr);
+            return index;
+        }
+
+        std::uint32_t registerBuffer(Base::Interop::RawRef<Interface::RHI::IBuffer> buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_heap_mutex);
+            std::uint32_t index = allocateIndex(m_free_buffer_indices, m_next_buffer_index, m_buffer_capacity);
+            if(index == INVALID_INDEX)
+            {
+                Core::Logger::error("Bindless heap is full, {} buffers registered", m_buffer_capacity);
+                return INVALID_INDEX;
+            }
+
+            VkDescriptorBufferInfo buffer_info = VulkanDescriptorSet::getBufferInfo(buffer, 0, VK_WHOLE_SIZE);
+            VkWriteDescriptorSet descriptor_write = getWrite(STORAGE_BUFFER_BINDING, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+            descriptor_write.pBufferInfo = &buffer_info;
+            vkUpdateDescriptorSets(m_vk_device, 1, &descriptor_write, 0, nullptr);
+            return index;
+        }
+
+        // The slot keeps its stale descriptor until reused, partially bound slots are fine as long as no shader reads them.
+        void unregisterImage(std::uint32_t index)
+        {
+            std::lock_guard<std::mutex> lock(m_heap_mutex);
+            m_free_image_indices.emplace_back(index);
+        }
+
+        void unregisterBuffer(std::uint32_t index)
+        {
+            std::lock_guard<std::mutex> lock(m_heap_mutex);
+            m_free_buffer_indices.emplace_back(index);
+        }
+
+        // Bind it at the pipeline's getBindlessSetIndex() with VulkanCommandBuffer::bindDescriptorSets.
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> getDescriptorSet()
+        {
+            return m_descriptor_set;
+        }
+    private:
+        friend class VulkanDevice;
+
+        static std::uint32_t allocateIndex(std::vector<std::uint32_t>& free_indices, std::uint32_t& next_index, std::uint32_t capacity)
+        {
+            if(free_indices.empty() == false)
+            {
+                std::uint32_t index = free_indices.back();
+                free_indices.pop_back();
+                return index;
+            }
+            return next_index < capacity ? next_index++ : INVALID_INDEX;
+        }
+
+        VkWriteDescriptorSet getWrite(std::uint32_t binding, std::uint32_t index, VkDescriptorType vk_descriptor_type)
+        {
+            VkWriteDescriptorSet descriptor_write{};
+            descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptor_write.dstSet = m_descriptor_set.castToInstance<VulkanDescriptorSet>()->m_vk_descriptor_set;
+            descriptor_write.dstBinding = binding;
+            descriptor_write.dstArrayElement = index;
+            descriptor_write.descriptorType = vk_descriptor_type;
+            descriptor_write.descriptorCount = 1;
+            return descriptor_write;
+        }
+
+        VkDevice& m_vk_device;
+        VkDescriptorSetLayout m_vk_descriptor_set_layout;
+        VkDescriptorPool m_vk_descriptor_pool;
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> m_descriptor_set;
+        std::vector<VkDescriptorSetLayoutBinding> m_vk_descriptor_bindings;
+
+        std::mutex m_heap_mutex;
+        std::uint32_t m_image_capacity;
+        std::uint32_t m_buffer_capacity;
+        std::uint32_t m_next_image_index = 0;
+        std::uint32_t m_next_buffer_index = 0;
+        std::vector<std::uint32_t> m_free_image_indices;
+        std::vector<std::uint32_t> m_free_buffer_indices;
+    };
+}
+
+
+
+
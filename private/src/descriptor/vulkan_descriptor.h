@@ -1,5 +1,4 @@
 #pragma once
-#pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
 #include "../image/vulkan_image.h"
@@ -9,56 +8,120 @@ namespace Arieo
         : public Interface::RHI::IDescriptorSet
     {
     public:
-        VulkanDescriptorSet(VkDevice& vk_device, VkDescriptorSet&& vk_descriptor_set)
+        VulkanDescriptorSet(VkDevice& vk_device, VkDescriptorSet&& vk_descriptor_set, const std::vector<VkDescriptorSetLayoutBinding>& vk_descriptor_bindings, VkDescriptorPool vk_descriptor_pool = VK_NULL_HANDLE)
             : m_vk_device(vk_device),
-            m_vk_descriptor_set(std::move(vk_descriptor_set))
+            m_vk_descriptor_set(std::move(vk_descriptor_set)),
+            m_vk_descriptor_bindings(vk_descriptor_bindings),
+            m_vk_descriptor_pool(vk_descriptor_pool)
         {
         }
 
+        // For *_DYNAMIC bindings offset is the base of the slice and size its range, the per-draw offset
+        // is added by bindDescriptorSets.
         void bindBuffer(size_t bind_index, Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, size_t offset, size_t size) override
         {
-            VulkanBuffer* vulkan_buffer = buffer.castToInstance<VulkanBuffer>();
-            VkDescriptorBufferInfo bufferInfo{};
-            bufferInfo.buffer = vulkan_buffer->m_vk_buffer;
-            bufferInfo.offset = offset;
-            bufferInfo.range = size;
+            VkDescriptorBufferInfo bufferInfo = getBufferInfo(buffer, offset, size);
 
             VkWriteDescriptorSet descriptor_write{};
             descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             descriptor_write.dstSet = m_vk_descriptor_set;
             descriptor_write.dstBinding = bind_index;
             descriptor_write.dstArrayElement = 0;
-            descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptor_write.descriptorType = getDescriptorType(bind_index, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
             descriptor_write.descriptorCount = 1;
             descriptor_write.pBufferInfo = &bufferInfo;
 
             vkUpdateDescriptorSets(m_vk_device, 1, &descriptor_write, 0, nullptr);
         }
 
+        // Written with the binding's declared type, storage images are expected in VK_IMAGE_LAYOUT_GENERAL.
         void bindImage(size_t bind_index, Base::Interop::RawRef<Interface::RHI::IImage> image) override
         {
-            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
-            VkDescriptorImageInfo image_info{};
-            image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            image_info.imageView = vulkan_image->m_vulkan_image_view->m_vk_image_view;
-            image_info.sampler = vulkan_image->m_vulkan_image_sampler->m_vk_image_sampler;
+            VkDescriptorType vk_descriptor_type = getDescriptorType(bind_index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+            VkDescriptorImageInfo image_info = getImageInfo(image, vk_descriptor_type);
 
             VkWriteDescriptorSet descriptor_write{};
             descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             descriptor_write.dstSet = m_vk_descriptor_set;
             descriptor_write.dstBinding = bind_index;
             descriptor_write.dstArrayElement = 0;
-            descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptor_write.descriptorType = vk_descriptor_type;
             descriptor_write.descriptorCount = 1;
             descriptor_write.pImageInfo = &image_info;
 
             vkUpdateDescriptorSets(m_vk_device, 1, &descriptor_write, 0, nullptr);
         }
+
+        // Descriptor payloads as bindBuffer and bindImage write them, also the element layout of update template data.
+        static VkDescriptorBufferInfo getBufferInfo(Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, size_t offset, size_t size)
+        {
+            VkDescriptorBufferInfo buffer_info{};
+            buffer_info.buffer = buffer.castToInstance<VulkanBuffer>()->m_vk_buffer;
+            buffer_info.offset = offset;
+            buffer_info.range = size;
+            return buffer_info;
+        }
+
+        static VkDescriptorImageInfo getImageInfo(Base::Interop::RawRef<Interface::RHI::IImage> image)
+        {
+            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
+            VkDescriptorImageInfo image_info{};
+            image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            image_info.imageView = vulkan_image->getImageView().castToInstance<VulkanImageView>()->m_vk_image_view;
+            image_info.sampler = vulkan_image->m_vulkan_image_sampler->m_vk_image_sampler;
+            return image_info;
+        }
+
+        // Payload for a binding of the given type, storage images are accessed in VK_IMAGE_LAYOUT_GENERAL.
+        static VkDescriptorImageInfo getImageInfo(Base::Interop::RawRef<Interface::RHI::IImage> image, VkDescriptorType vk_descriptor_type)
+        {
+            VkDescriptorImageInfo image_info = getImageInfo(image);
+            if(vk_descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+            {
+                image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            }
+            return image_info;
+        }
+
+        // Number of dynamic offsets bindDescriptorSets has to supply for this set.
+        std::uint32_t getDynamicOffsetCount() const
+        {
+            std::uint32_t dynamic_offset_count = 0;
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : m_vk_descriptor_bindings)
+            {
+                if(descriptor_binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                || descriptor_binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+                {
+                    dynamic_offset_count += descriptor_binding.descriptorCount;
+                }
+            }
+            return dynamic_offset_count;
+        }
     private:
         friend class VulkanDescriptorPool;
+        friend class VulkanDescriptorAllocator;
+        friend class VulkanDescriptorWriter;
+        friend class VulkanDescriptorUpdateTemplate;
+        friend class VulkanBindlessHeap;
         friend class VulkanCommandBuffer;
+
+        VkDescriptorType getDescriptorType(size_t bind_index, VkDescriptorType default_type) const
+        {
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : m_vk_descriptor_bindings)
+            {
+                if(descriptor_binding.binding == bind_index)
+                {
+                    return descriptor_binding.descriptorType;
+                }
+            }
+            return default_type;
+        }
+
         VkDevice& m_vk_device;
         VkDescriptorSet m_vk_descriptor_set;
+        std::vector<VkDescriptorSetLayoutBinding> m_vk_descriptor_bindings;
+        // Pool the set came from when it was allocated by VulkanDescriptorAllocator
+        VkDescriptorPool m_vk_descriptor_pool;
     };
 
     class VulkanDescriptorPool final
@@ -73,23 +136,40 @@ namespace Arieo
         }
 
         Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline)
+        {
+            return allocateDescriptorSet(pipeline, 0);
+        }
+
+        // Allocates a set with the layout of set_index in the pipeline layout.
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index)
         {
             VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            if(vulkan_pipeline->m_is_descriptor_buffer)
+            {
+                Core::Logger::error("Pipeline uses descriptor buffers, allocate its sets from a VulkanDescriptorBufferPool");
+                return nullptr;
+            }
+            if(set_index >= vulkan_pipeline->m_vk_descriptor_set_layouts.size())
+            {
+                Core::Logger::error("Pipeline has no descriptor set {}", set_index);
+                return nullptr;
+            }
             
             VkDescriptorSetAllocateInfo alloc_info{};
             alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
             alloc_info.descriptorPool = m_vk_descriptor_pool;
             alloc_info.descriptorSetCount = 1;
-            alloc_info.pSetLayouts = &vulkan_pipeline->m_vk_descriptor_set_layout;
+            alloc_info.pSetLayouts = &vulkan_pipeline->m_vk_descriptor_set_layouts[set_index];
 
             VkDescriptorSet vk_descriptor_set;
             VkResult result = vkAllocateDescriptorSets(m_vk_device, &alloc_info, &vk_descriptor_set);
             if (result != VK_SUCCESS) 
             {
                 Core::Logger::error("Create allocate descriptor sets failed: {}", VulkanUtility::covertVkResultToString(result));
+                return nullptr;
             }
             
-            return Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::createAs<VulkanDescriptorSet>(m_vk_device, std::move(vk_descriptor_set));
+            return Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::createAs<VulkanDescriptorSet>(m_vk_device, std::move(vk_descriptor_set), vulkan_pipeline->m_vk_descriptor_set_bindings[set_index]);
         }
 
         void freeDescriptorSet(Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set)
@@ -0,0 +1,261 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <algorithm>
+#include <map>
+#include "vulkan_descriptor.h"
+#include "../pipeline/vulkan_pipeline.h"
+#include "../fence/vulkan_fence.h"
+namespace Arieo
+{
+    // Descriptor allocator that never runs dry: when a pool is exhausted a larger one is chained behind it.
+    // New pools are sized from the descriptor types the allocator has actually handed out so far.
+    //  - allocateDescriptorSet / freeDescriptorSet: long lived sets, freed one at a time.
+    //  - allocateFrameDescriptorSet: transient sets of the current frame, recycled together with
+    //    vkResetDescriptorPool once the frame's fence has signaled.
+    // Like the Vulkan pools it wraps, the allocator is externally synchronized. Free the long lived sets
+    // before destroying it, frame sets are cleaned up with their pools.
+    class VulkanDescriptorAllocator final
+    {
+    public:
+        static constexpr std::uint32_t MAX_SETS_PER_POOL = 4096;
+
+        // A growable list of pools, allocation moves on to the next pool once the current one is full.
+        struct PoolChain
+        {
+            std::vector<VkDescriptorPool> vk_descriptor_pools;
+            size_t current_index = 0;
+            std::uint32_t next_set_count = 0;
+            // Frame chains only, sets handed out since the last reset
+            std::vector<Base::Interop::RawRef<Interface::RHI::IDescriptorSet>> frame_descriptor_sets;
+            VkFence vk_fence = VK_NULL_HANDLE;
+        };
+
+        VulkanDescriptorAllocator(VkDevice& vk_device, std::uint32_t initial_set_count, std::uint32_t frame_count)
+            : m_vk_device(vk_device),
+            m_frame_chains(frame_count)
+        {
+            initial_set_count = std::clamp<std::uint32_t>(initial_set_count, 1, MAX_SETS_PER_POOL);
+            m_persistent_chain.next_set_count = initial_set_count;
+            for(PoolChain& frame_chain : m_frame_chains)
+            {
+                frame_chain.next_set_count = initial_set_count;
+            }
+        }
+
+        ~VulkanDescriptorAllocator()
+        {
+            destroyPoolChain(m_persistent_chain);
+            for(PoolChain& frame_chain : m_frame_chains)
+            {
+                destroyPoolChain(frame_chain);
+            }
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index)
+        {
+            return allocateFromChain(m_persistent_chain, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, pipeline, set_index, nullptr);
+        }
+
+        // Frees a set from allocateDescriptorSet, frame sets and sets of other pools are rejected.
+        bool freeDescriptorSet(Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set)
+        {
+            VulkanDescriptorSet* vulkan_desc_set = descriptor_set.castToInstance<VulkanDescriptorSet>();
+            auto found_iter = std::find(m_persistent_chain.vk_descriptor_pools.begin(), m_persistent_chain.vk_descriptor_pools.end(), vulkan_desc_set->m_vk_descriptor_pool);
+            if(vulkan_desc_set->m_vk_descriptor_pool == VK_NULL_HANDLE || found_iter == m_persistent_chain.vk_descriptor_pools.end())
+            {
+                Core::Logger::error("Descriptor set was not allocated with allocateDescriptorSet of this allocator, it cannot be freed");
+                return false;
+            }
+            vkFreeDescriptorSets(m_vk_device, vulkan_desc_set->m_vk_descriptor_pool, 1, &vulkan_desc_set->m_vk_descriptor_set);
+
+            // The pool has room again, try it first on the next allocation
+            m_persistent_chain.current_index = std::min<size_t>(m_persistent_chain.current_index, found_iter - m_persistent_chain.vk_descriptor_pools.begin());
+            Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::destroyAs<VulkanDescriptorSet>(std::move(descriptor_set));
+            return true;
+        }
+
+        // frame_fence is the fence this frame will be submitted with, one fence per frame in flight. Call this before
+        // the fence is reset: the slot waits for the fence of its previous frame, a reset fence would never signal.
+        // The pools of the slot are recycled here.
+        void beginFrame(Base::Interop::RawRef<Interface::RHI::IFence> frame_fence)
+        {
+            if(m_frame_chains.empty())
+            {
+                Core::Logger::error("Descriptor allocator was created without frame pools");
+                return;
+            }
+
+            m_frame_index = (m_frame_index + 1) % m_frame_chains.size();
+            PoolChain& frame_chain = m_frame_chains[m_frame_index];
+
+            if(frame_chain.vk_fence != VK_NULL_HANDLE)
+            {
+                // Normally already signaled, the caller waits on it before reusing the frame resources.
+                vkWaitForFences(m_vk_device, 1, &frame_chain.vk_fence, VK_TRUE, UINT64_MAX);
+            }
+
+            for(VkDescriptorPool vk_descriptor_pool : frame_chain.vk_descriptor_pools)
+            {
+                vkResetDescriptorPool(m_vk_device, vk_descriptor_pool, 0);
+            }
+            for(Base::Interop::RawRef<Interface::RHI::IDescriptorSet>& descriptor_set : frame_chain.frame_descriptor_sets)
+            {
+                Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::destroyAs<VulkanDescriptorSet>(std::move(descriptor_set));
+            }
+            frame_chain.frame_descriptor_sets.clear();
+            frame_chain.current_index = 0;
+            frame_chain.vk_fence = frame_fence.castToInstance<VulkanFence>()->m_vk_fence;
+        }
+
+        // Valid until the same frame slot begins again, do not free it individually.
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateFrameDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index)
+        {
+            if(m_frame_index >= m_frame_chains.size())
+            {
+                Core::Logger::error("Frame descriptor set requested before beginFrame");
+                return nullptr;
+            }
+
+            PoolChain& frame_chain = m_frame_chains[m_frame_index];
+            return allocateFromChain(frame_chain, 0, pipeline, set_index, &frame_chain.frame_descriptor_sets);
+        }
+    private:
+        friend class VulkanDevice;
+
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateFromChain(PoolChain& pool_chain, VkDescriptorPoolCreateFlags vk_pool_flags, Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index, std::vector<Base::Interop::RawRef<Interface::RHI::IDescriptorSet>>* tracked_descriptor_sets)
+        {
+            VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            if(vulkan_pipeline->m_is_descriptor_buffer)
+            {
+                Core::Logger::error("Pipeline uses descriptor buffers, allocate its sets from a VulkanDescriptorBufferPool");
+                return nullptr;
+            }
+            if(set_index >= vulkan_pipeline->m_vk_descriptor_set_layouts.size())
+            {
+                Core::Logger::error("Pipeline has no descriptor set {}", set_index);
+                return nullptr;
+            }
+            const std::vector<VkDescriptorSetLayoutBinding>& vk_descriptor_bindings = vulkan_pipeline->m_vk_descriptor_set_bindings[set_index];
+
+            // Record usage first, so a pool created for this request already covers its descriptor types
+            m_observed_set_count++;
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : vk_descriptor_bindings)
+            {
+                m_observed_descriptor_counts[descriptor_binding.descriptorType] += descriptor_binding.descriptorCount;
+            }
+
+            VkDescriptorSetAllocateInfo alloc_info{};
+            alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            alloc_info.descriptorSetCount = 1;
+            alloc_info.pSetLayouts = &vulkan_pipeline->m_vk_descriptor_set_layouts[set_index];
+
+            while(true)
+            {
+                bool is_new_pool = false;
+                if(pool_chain.current_index == pool_chain.vk_descriptor_pools.size())
+                {
+                    VkDescriptorPool vk_descriptor_pool = createPool(vk_pool_flags, pool_chain.next_set_count, vk_descriptor_bindings);
+                    if(vk_descriptor_pool == VK_NULL_HANDLE)
+                    {
+                        return nullptr;
+                    }
+                    pool_chain.vk_descriptor_pools.emplace_back(vk_descriptor_pool);
+                    pool_chain.next_set_count = std::min(pool_chain.next_set_count * 2, MAX_SETS_PER_POOL);
+                    is_new_pool = true;
+                }
+
+                alloc_info.descriptorPool = pool_chain.vk_descriptor_pools[pool_chain.current_index];
+                VkDescriptorSet vk_descriptor_set;
+                VkResult result = vkAllocateDescriptorSets(m_vk_device, &alloc_info, &vk_descriptor_set);
+                if(result == VK_SUCCESS)
+                {
+                    Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set = Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::createAs<VulkanDescriptorSet>(m_vk_device, std::move(vk_descriptor_set), vk_descriptor_bindings, alloc_info.descriptorPool);
+                    if(tracked_descriptor_sets != nullptr)
+                    {
+                        tracked_descriptor_sets->emplace_back(descriptor_set);
+                    }
+                    return descriptor_set;
+                }
+
+                // Exhausted or fragmented, move on to the next pool. A fresh pool failing means the set can never fit.
+                if((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || is_new_pool)
+                {
+                    Core::Logger::error("Allocate descriptor set failed: {}", VulkanUtility::covertVkResultToString(result));
+                    return nullptr;
+                }
+                pool_chain.current_index++;
+            }
+        }
+
+        // The pool always fits at least one set with the pending request's bindings.
+        VkDescriptorPool createPool(VkDescriptorPoolCreateFlags vk_pool_flags, std::uint32_t set_count, const std::vector<VkDescriptorSetLayoutBinding>& vk_pending_bindings)
+        {
+            std::vector<VkDescriptorPoolSize> pool_sizes;
+            for(auto& [vk_descriptor_type, descriptor_count] : m_observed_descriptor_counts)
+            {
+                // Average descriptors of this type per set so far, rounded up
+                std::uint64_t type_count = (descriptor_count * set_count + m_observed_set_count - 1) / m_observed_set_count;
+                std::uint64_t pending_count = 0;
+                for(const VkDescriptorSetLayoutBinding& descriptor_binding : vk_pending_bindings)
+                {
+                    if(descriptor_binding.descriptorType == vk_descriptor_type)
+                    {
+                        pending_count += descriptor_binding.descriptorCount;
+                    }
+                }
+                type_count = std::max(type_count, pending_count);
+                VkDescriptorPoolSize pool_size{};
+                pool_size.type = vk_descriptor_type;
+                pool_size.descriptorCount = static_cast<uint32_t>(std::max<std::uint64_t>(type_count, 1));
+                pool_sizes.emplace_back(pool_size);
+            }
+
+            VkDescriptorPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            pool_info.flags = vk_pool_flags;
+            pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+            pool_info.pPoolSizes = pool_sizes.data();
+            pool_info.maxSets = set_count;
+
+            VkDescriptorPool vk_descriptor_pool;
+            VkResult result = vkCreateDescriptorPool(m_vk_device, &pool_info, nullptr, &vk_descriptor_pool);
+            if (result != VK_SUCCESS)
+            {
+                Core::Logger::error("Create descriptor pool failed: {}", VulkanUtility::covertVkResultToString(result));
+                return VK_NULL_HANDLE;
+            }
+            Core::Logger::trace("Descriptor allocator pool created {} sets {} types", set_count, pool_sizes.size());
+            return vk_descriptor_pool;
+        }
+
+        void destroyPoolChain(PoolChain& pool_chain)
+        {
+            for(Base::Interop::RawRef<Interface::RHI::IDescriptorSet>& descriptor_set : pool_chain.frame_descriptor_sets)
+            {
+                Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::destroyAs<VulkanDescriptorSet>(std::move(descriptor_set));
+            }
+            pool_chain.frame_descriptor_sets.clear();
+
+            // Destroying a pool frees its sets
+            for(VkDescriptorPool vk_descriptor_pool : pool_chain.vk_descriptor_pools)
+            {
+                vkDestroyDescriptorPool(m_vk_device, vk_descriptor_pool, nullptr);
+            }
+            pool_chain.vk_descriptor_pools.clear();
+        }
+
+        VkDevice& m_vk_device;
+        PoolChain m_persistent_chain;
+        std::vector<PoolChain> m_frame_chains;
+        // Wraps to slot 0 on the first beginFrame
+        size_t m_frame_index = static_cast<size_t>(-1);
+
+        std::uint64_t m_observed_set_count = 0;
+        std::map<VkDescriptorType, std::uint64_t> m_observed_descriptor_counts;
+    };
+}
+
+
+
+
@@ -0,0 +1,248 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <map>
+#include "../buffer/vulkan_buffer.h"
+#include "../image/vulkan_image.h"
+#include "../pipeline/vulkan_pipeline.h"
+#include "../device/vulkan_device_features.h"
+#include "vulkan_descriptor.h"
+namespace Arieo
+{
+    // Descriptor set living in a range of a descriptor buffer (VK_EXT_descriptor_buffer). Writes go straight into
+    // mapped memory through vkGetDescriptorEXT, there is no VkDescriptorSet behind it.
+    class VulkanDescriptorBufferSet final
+        : public Interface::RHI::IDescriptorSet
+    {
+    public:
+        VulkanDescriptorBufferSet(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, VkBuffer vk_descriptor_buffer, VkDeviceAddress vk_descriptor_buffer_address, VkDeviceSize offset, VkDeviceSize size, std::uint8_t* mapped_ptr, const std::vector<VkDescriptorSetLayoutBinding>& vk_descriptor_bindings, std::vector<VkDeviceSize>&& binding_offsets)
+            : m_vk_device(vk_device),
+            m_vulkan_device_features(vulkan_device_features),
+            m_vk_descriptor_buffer(vk_descriptor_buffer),
+            m_vk_descriptor_buffer_address(vk_descriptor_buffer_address),
+            m_offset(offset),
+            m_size(size),
+            m_mapped_ptr(mapped_ptr),
+            m_vk_descriptor_bindings(vk_descriptor_bindings),
+            m_binding_offsets(std::move(binding_offsets))
+        {
+
+        }
+
+        void bindBuffer(size_t bind_index, Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, size_t offset, size_t size) override
+        {
+            VkBufferDeviceAddressInfo address_info{};
+            address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+            address_info.buffer = buffer.castToInstance<VulkanBuffer>()->m_vk_buffer;
+
+            VkDescriptorAddressInfoEXT descriptor_address_info{};
+            descriptor_address_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+            descriptor_address_info.address = vkGetBufferDeviceAddress(m_vk_device, &address_info) + offset;
+            descriptor_address_info.range = size;
+            descriptor_address_info.format = VK_FORMAT_UNDEFINED;
+
+            VkDescriptorGetInfoEXT descriptor_info{};
+            descriptor_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+            descriptor_info.type = getDescriptorType(bind_index, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+            size_t descriptor_size;
+            if(descriptor_info.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+            {
+                descriptor_info.data.pStorageBuffer = &descriptor_address_info;
+                descriptor_size = m_vulkan_device_features.descriptor_buffer_properties.storageBufferDescriptorSize;
+            }
+            else
+            {
+                descriptor_info.data.pUniformBuffer = &descriptor_address_info;
+                descriptor_size = m_vulkan_device_features.descriptor_buffer_properties.uniformBufferDescriptorSize;
+            }
+            writeDescriptor(bind_index, descriptor_info, descriptor_size);
+        }
+
+        // Written with the binding's declared type and its descriptor size, storage images are expected in
+        // VK_IMAGE_LAYOUT_GENERAL.
+        void bindImage(size_t bind_index, Base::Interop::RawRef<Interface::RHI::IImage> image) override
+        {
+            VkDescriptorGetInfoEXT descriptor_info{};
+            descriptor_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+            descriptor_info.type = getDescriptorType(bind_index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+            VkDescriptorImageInfo image_info = VulkanDescriptorSet::getImageInfo(image, descriptor_info.type);
+
+            const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties = m_vulkan_device_features.descriptor_buffer_properties;
+            size_t descriptor_size;
+            switch(descriptor_info.type)
+            {
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                descriptor_info.data.pCombinedImageSampler = &image_info;
+                descriptor_size = properties.combinedImageSamplerDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                descriptor_info.data.pSampledImage = &image_info;
+                descriptor_size = properties.sampledImageDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                descriptor_info.data.pStorageImage = &image_info;
+                descriptor_size = properties.storageImageDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                descriptor_info.data.pInputAttachmentImage = &image_info;
+                descriptor_size = properties.inputAttachmentDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                descriptor_info.data.pSampler = &image_info.sampler;
+                descriptor_size = properties.samplerDescriptorSize;
+                break;
+            default:
+                Core::Logger::error("Binding {} is not an image binding", bind_index);
+                return;
+            }
+            writeDescriptor(bind_index, descriptor_info, descriptor_size);
+        }
+    private:
+        friend class VulkanDescriptorBufferPool;
+        friend class VulkanCommandBuffer;
+
+        VkDescriptorType getDescriptorType(size_t bind_index, VkDescriptorType default_type) const
+        {
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : m_vk_descriptor_bindings)
+            {
+                if(descriptor_binding.binding == bind_index)
+                {
+                    return descriptor_binding.descriptorType;
+                }
+            }
+            return default_type;
+        }
+
+        void writeDescriptor(size_t bind_index, const VkDescriptorGetInfoEXT& descriptor_info, size_t descriptor_size)
+        {
+            for(size_t binding_index = 0; binding_index < m_vk_descriptor_bindings.size(); binding_index++)
+            {
+                if(m_vk_descriptor_bindings[binding_index].binding == bind_index)
+                {
+                    // Host coherent memory, visible to the GPU at the next submit
+                    m_vulkan_device_features.vk_get_descriptor(m_vk_device, &descriptor_info, descriptor_size, m_mapped_ptr + m_binding_offsets[binding_index]);
+                    return;
+                }
+            }
+            Core::Logger::error("Descriptor set layout has no binding {}", bind_index);
+        }
+
+        VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
+        VkBuffer m_vk_descriptor_buffer;
+        VkDeviceAddress m_vk_descriptor_buffer_address;
+        // Range of the set inside the descriptor buffer, m_mapped_ptr points at m_offset
+        VkDeviceSize m_offset;
+        VkDeviceSize m_size;
+        std::uint8_t* m_mapped_ptr;
+        std::vector<VkDescriptorSetLayoutBinding> m_vk_descriptor_bindings;
+        // Per entry of m_vk_descriptor_bindings, from vkGetDescriptorSetLayoutBindingOffsetEXT
+        std::vector<VkDeviceSize> m_binding_offsets;
+    };
+
+    // Descriptor pool backed by one persistently mapped descriptor buffer. Sets are sub-ranges of the buffer sized
+    // with vkGetDescriptorSetLayoutSizeEXT, freed ranges are reused by later sets of the same size.
+    class VulkanDescriptorBufferPool final
+        : public Interface::RHI::IDescriptorPool
+    {
+    public:
+        VulkanDescriptorBufferPool(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, Base::Interop::RawRef<Interface::RHI::IBuffer>&& descriptor_buffer, VkDeviceAddress vk_descriptor_buffer_address, std::uint8_t* mapped_ptr, VkDeviceSize capacity)
+            : m_vk_device(vk_device),
+            m_vulkan_device_features(vulkan_device_features),
+            m_descriptor_buffer(std::move(descriptor_buffer)),
+            m_vk_descriptor_buffer_address(vk_descriptor_buffer_address),
+            m_mapped_ptr(mapped_ptr),
+            m_capacity(capacity)
+        {
+
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline)
+        {
+            return allocateDescriptorSet(pipeline, 0);
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> allocateDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index)
+        {
+            VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            if(vulkan_pipeline->m_is_descriptor_buffer == false)
+            {
+                Core::Logger::error("Descriptor buffer sets need a pipeline created with use_descriptor_buffer");
+                return nullptr;
+            }
+            if(set_index >= vulkan_pipeline->m_vk_descriptor_set_layouts.size())
+            {
+                Core::Logger::error("Pipeline has no descriptor set {}", set_index);
+                return nullptr;
+            }
+
+            VkDescriptorSetLayout vk_descriptor_set_layout = vulkan_pipeline->m_vk_descriptor_set_layouts[set_index];
+            const std::vector<VkDescriptorSetLayoutBinding>& vk_descriptor_bindings = vulkan_pipeline->m_vk_descriptor_set_bindings[set_index];
+
+            VkDeviceSize layout_size = 0;
+            m_vulkan_device_features.vk_get_descriptor_set_layout_size(m_vk_device, vk_descriptor_set_layout, &layout_size);
+            VkDeviceSize alignment = m_vulkan_device_features.descriptor_buffer_properties.descriptorBufferOffsetAlignment;
+            layout_size = (layout_size + alignment - 1) / alignment * alignment;
+
+            VkDeviceSize offset;
+            auto free_iter = m_free_ranges.find(layout_size);
+            if(free_iter != m_free_ranges.end())
+            {
+                offset = free_iter->second;
+                m_free_ranges.erase(free_iter);
+            }
+            else if(m_used_size + layout_size <= m_capacity)
+            {
+                offset = m_used_size;
+                m_used_size += layout_size;
+            }
+            else
+            {
+                Core::Logger::error("Descriptor buffer is full, {} of {} bytes used", m_used_size, m_capacity);
+                return nullptr;
+            }
+
+            std::vector<VkDeviceSize> binding_offsets(vk_descriptor_bindings.size());
+            for(size_t binding_index = 0; binding_index < vk_descriptor_bindings.size(); binding_index++)
+            {
+                m_vulkan_device_features.vk_get_descriptor_set_layout_binding_offset(m_vk_device, vk_descriptor_set_layout, vk_descriptor_bindings[binding_index].binding, &binding_offsets[binding_index]);
+            }
+
+            return Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::createAs<VulkanDescriptorBufferSet>(
+                m_vk_device,
+                m_vulkan_device_features,
+                m_descriptor_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer,
+                m_vk_descriptor_buffer_address,
+                offset,
+                layout_size,
+                m_mapped_ptr + offset,
+                vk_descriptor_bindings,
+                std::move(binding_offsets)
+            );
+        }
+
+        // The range is reused right away, only free sets the GPU is done with.
+        void freeDescriptorSet(Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set)
+        {
+            VulkanDescriptorBufferSet* vulkan_desc_set = descriptor_set.castToInstance<VulkanDescriptorBufferSet>();
+            m_free_ranges.emplace(vulkan_desc_set->m_size, vulkan_desc_set->m_offset);
+            Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::destroyAs<VulkanDescriptorBufferSet>(std::move(descriptor_set));
+        }
+    private:
+        friend class VulkanDevice;
+
+        VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
+        Base::Interop::RawRef<Interface::RHI::IBuffer> m_descriptor_buffer;
+        VkDeviceAddress m_vk_descriptor_buffer_address;
+        std::uint8_t* m_mapped_ptr;
+        VkDeviceSize m_capacity;
+        VkDeviceSize m_used_size = 0;
+        // Freed ranges by size
+        std::multimap<VkDeviceSize, VkDeviceSize> m_free_ranges;
+    };
+}
+
+
+
+
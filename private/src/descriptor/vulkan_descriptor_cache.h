@@ -0,0 +1,341 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <algorithm>
+#include <unordered_map>
+#include "vulkan_descriptor.h"
+#include "vulkan_descriptor_allocator.h"
+#include "vulkan_descriptor_writer.h"
+namespace Arieo
+{
+    // One resource bound to a binding, either a buffer range or an image.
+    struct VulkanDescriptorResource
+    {
+        std::uint32_t binding = 0;
+        Base::Interop::RawRef<Interface::RHI::IBuffer> buffer;
+        VkBuffer vk_buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        Base::Interop::RawRef<Interface::RHI::IImage> image;
+        VkImage vk_image = VK_NULL_HANDLE;
+    };
+
+    // Everything bound to a descriptor set, the content half of the cache key.
+    class VulkanDescriptorSetResources
+    {
+    public:
+        VulkanDescriptorSetResources& addBuffer(std::uint32_t binding, Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, VkDeviceSize offset, VkDeviceSize size)
+        {
+            VulkanDescriptorResource resource;
+            resource.binding = binding;
+            resource.buffer = buffer;
+            resource.vk_buffer = buffer.castToInstance<VulkanBuffer>()->m_vk_buffer;
+            resource.offset = offset;
+            resource.size = size;
+            addResource(std::move(resource));
+            return *this;
+        }
+
+        VulkanDescriptorSetResources& addImage(std::uint32_t binding, Base::Interop::RawRef<Interface::RHI::IImage> image)
+        {
+            VulkanDescriptorResource resource;
+            resource.binding = binding;
+            resource.image = image;
+            resource.vk_image = image.castToInstance<VulkanImage>()->m_vk_image;
+            addResource(std::move(resource));
+            return *this;
+        }
+
+        const std::vector<VulkanDescriptorResource>& getResources() const
+        {
+            return m_resources;
+        }
+    private:
+        // Kept sorted by binding so the order resources are added in does not change the key
+        void addResource(VulkanDescriptorResource&& resource)
+        {
+            auto insert_iter = std::upper_bound(m_resources.begin(), m_resources.end(), resource.binding,
+                [](std::uint32_t binding, const VulkanDescriptorResource& other) { return binding < other.binding; });
+            m_resources.insert(insert_iter, std::move(resource));
+        }
+
+        std::vector<VulkanDescriptorResource> m_resources;
+    };
+
+    struct VulkanDescriptorSetCacheKey
+    {
+        // The layout by its bindings, not its handle: every pipeline creates its own layouts, and sets of identically
+        // defined layouts are compatible with each other
+        struct LayoutBinding
+        {
+            std::uint32_t binding;
+            VkDescriptorType descriptor_type;
+            std::uint32_t descriptor_count;
+            VkShaderStageFlags stage_flags;
+            std::vector<VkSampler> immutable_samplers;
+
+            bool operator==(const LayoutBinding& other) const
+            {
+                return binding == other.binding && descriptor_type == other.descriptor_type && descriptor_count == other.descriptor_count
+                    && stage_flags == other.stage_flags && immutable_samplers == other.immutable_samplers;
+            }
+        };
+        std::vector<LayoutBinding> layout_bindings;
+
+        struct Entry
+        {
+            std::uint32_t binding;
+            VkBuffer vk_buffer;
+            VkDeviceSize offset;
+            VkDeviceSize size;
+            VkImage vk_image;
+
+            bool operator==(const Entry& other) const
+            {
+                return binding == other.binding && vk_buffer == other.vk_buffer && offset == other.offset
+                    && size == other.size && vk_image == other.vk_image;
+            }
+        };
+        std::vector<Entry> entries;
+
+        bool operator==(const VulkanDescriptorSetCacheKey& other) const
+        {
+            return layout_bindings == other.layout_bindings && entries == other.entries;
+        }
+    };
+
+    struct VulkanDescriptorSetCacheKeyHash
+    {
+        size_t operator()(const VulkanDescriptorSetCacheKey& key) const
+        {
+            size_t hash = 0;
+            auto combine = [&hash](size_t value)
+            {
+                hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            };
+            for(const VulkanDescriptorSetCacheKey::LayoutBinding& layout_binding : key.layout_bindings)
+            {
+                combine(std::hash<std::uint32_t>()(layout_binding.binding));
+                combine(std::hash<std::uint32_t>()(layout_binding.descriptor_type));
+                combine(std::hash<std::uint32_t>()(layout_binding.descriptor_count));
+                combine(std::hash<std::uint32_t>()(layout_binding.stage_flags));
+            }
+            for(const VulkanDescriptorSetCacheKey::Entry& entry : key.entries)
+            {
+                combine(std::hash<std::uint32_t>()(entry.binding));
+                combine(std::hash<const void*>()(entry.vk_buffer));
+                combine(std::hash<std::uint64_t>()(entry.offset));
+                combine(std::hash<std::uint64_t>()(entry.size));
+                combine(std::hash<const void*>()(entry.vk_image));
+            }
+            return hash;
+        }
+    };
+
+    // Shares fully written descriptor sets between everything that binds the same resources with identically defined
+    // layouts, across pipelines. Cached sets are owned by the cache: bind them, never rewrite or free them. An entry
+    // is dropped when one of its buffers or images is destroyed, the resource is already idle on the GPU by then and
+    // so is the set. Sets outlive the pipeline they were allocated for, a destroyed layout only forbids updates.
+    class VulkanDescriptorSetCache final
+    {
+    public:
+        VulkanDescriptorSetCache(VkDevice& vk_device)
+            : m_vk_device(vk_device)
+        {
+
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> getDescriptorSet(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index, const VulkanDescriptorSetResources& resources)
+        {
+            VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            if(vulkan_pipeline->m_is_descriptor_buffer)
+            {
+                Core::Logger::error("Pipeline uses descriptor buffers, the descriptor set cache only serves descriptor pools");
+                return nullptr;
+            }
+            if(set_index >= vulkan_pipeline->m_vk_descriptor_set_layouts.size())
+            {
+                Core::Logger::error("Pipeline has no descriptor set {}", set_index);
+                return nullptr;
+            }
+
+            VulkanDescriptorSetCacheKey key;
+            const std::vector<VkDescriptorSetLayoutBinding>& vk_descriptor_bindings = vulkan_pipeline->m_vk_descriptor_set_bindings[set_index];
+            key.layout_bindings.reserve(vk_descriptor_bindings.size());
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : vk_descriptor_bindings)
+            {
+                VulkanDescriptorSetCacheKey::LayoutBinding& layout_binding = key.layout_bindings.emplace_back(VulkanDescriptorSetCacheKey::LayoutBinding{
+                    descriptor_binding.binding, descriptor_binding.descriptorType, descriptor_binding.descriptorCount, descriptor_binding.stageFlags, {}});
+                if(descriptor_binding.pImmutableSamplers != nullptr)
+                {
+                    layout_binding.immutable_samplers.assign(descriptor_binding.pImmutableSamplers, descriptor_binding.pImmutableSamplers + descriptor_binding.descriptorCount);
+                }
+            }
+            key.entries.reserve(resources.getResources().size());
+            for(const VulkanDescriptorResource& resource : resources.getResources())
+            {
+                key.entries.emplace_back(VulkanDescriptorSetCacheKey::Entry{resource.binding, resource.vk_buffer, resource.offset, resource.size, resource.vk_image});
+            }
+
+            auto found_iter = m_descriptor_set_map.find(key);
+            if(found_iter != m_descriptor_set_map.end())
+            {
+                m_hit_count++;
+                return found_iter->second;
+            }
+            m_miss_count++;
+
+            if(m_descriptor_allocator == nullptr)
+            {
+                m_descriptor_allocator = Base::newT<VulkanDescriptorAllocator>(m_vk_device, 64, 0);
+            }
+
+            Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set = m_descriptor_allocator->allocateDescriptorSet(pipeline, set_index);
+            VulkanDescriptorSet* vulkan_descriptor_set = descriptor_set.castToInstance<VulkanDescriptorSet>();
+            if(vulkan_descriptor_set == nullptr)
+            {
+                return nullptr;
+            }
+
+            // Written once here, every later lookup of the same resources skips the update
+            for(const VulkanDescriptorResource& resource : resources.getResources())
+            {
+                if(resource.vk_buffer != VK_NULL_HANDLE)
+                {
+                    m_descriptor_writer.writeBuffer(descriptor_set, resource.binding, resource.buffer, resource.offset, resource.size);
+                }
+                else
+                {
+                    m_descriptor_writer.writeImage(descriptor_set, resource.binding, resource.image);
+                }
+            }
+            m_descriptor_writer.flush();
+
+            auto inserted_iter = m_descriptor_set_map.emplace(std::move(key), descriptor_set).first;
+            // Map nodes never move, the reverse index points at the stored key
+            const VulkanDescriptorSetCacheKey* stored_key = &inserted_iter->first;
+            // Once per key even when a resource is bound to several bindings
+            for(const VulkanDescriptorSetCacheKey::Entry& entry : stored_key->entries)
+            {
+                if(entry.vk_buffer != VK_NULL_HANDLE)
+                {
+                    addReverseEntry(m_buffer_key_map[entry.vk_buffer], stored_key);
+                }
+                if(entry.vk_image != VK_NULL_HANDLE)
+                {
+                    addReverseEntry(m_image_key_map[entry.vk_image], stored_key);
+                }
+            }
+            return descriptor_set;
+        }
+
+        void invalidateBuffer(VkBuffer vk_buffer)
+        {
+            invalidateResource(m_buffer_key_map, vk_buffer);
+        }
+
+        void invalidateImage(VkImage vk_image)
+        {
+            invalidateResource(m_image_key_map, vk_image);
+        }
+
+        // Frees every cached set and the pools behind them.
+        void clear()
+        {
+            for(auto& [key, descriptor_set] : m_descriptor_set_map)
+            {
+                m_descriptor_allocator->freeDescriptorSet(descriptor_set);
+            }
+            m_descriptor_set_map.clear();
+            m_buffer_key_map.clear();
+            m_image_key_map.clear();
+
+            if(m_descriptor_allocator != nullptr)
+            {
+                Base::deleteT(m_descriptor_allocator);
+                m_descriptor_allocator = nullptr;
+            }
+        }
+
+        std::uint64_t getHitCount() const { return m_hit_count; }
+        std::uint64_t getMissCount() const { return m_miss_count; }
+        size_t getSize() const { return m_descriptor_set_map.size(); }
+    private:
+        using DescriptorSetMap = std::unordered_map<VulkanDescriptorSetCacheKey, Base::Interop::RawRef<Interface::RHI::IDescriptorSet>, VulkanDescriptorSetCacheKeyHash>;
+        using ReverseEntries = std::vector<const VulkanDescriptorSetCacheKey*>;
+
+        static void addReverseEntry(ReverseEntries& reverse_entries, const VulkanDescriptorSetCacheKey* key)
+        {
+            if(std::find(reverse_entries.begin(), reverse_entries.end(), key) == reverse_entries.end())
+            {
+                reverse_entries.emplace_back(key);
+            }
+        }
+
+        template<typename HandleType>
+        void invalidateResource(std::unordered_map<HandleType, ReverseEntries>& key_map, HandleType vk_handle)
+        {
+            auto found_iter = key_map.find(vk_handle);
+            if(found_iter == key_map.end())
+            {
+                return;
+            }
+            // Erasing an entry edits the reverse lists of its other resources, this one included
+            ReverseEntries keys = std::move(found_iter->second);
+            key_map.erase(found_iter);
+            for(const VulkanDescriptorSetCacheKey* key : keys)
+            {
+                eraseEntry(m_descriptor_set_map.find(*key));
+            }
+        }
+
+        void eraseEntry(DescriptorSetMap::iterator iter)
+        {
+            const VulkanDescriptorSetCacheKey* key = &iter->first;
+            for(const VulkanDescriptorSetCacheKey::Entry& entry : key->entries)
+            {
+                if(entry.vk_buffer != VK_NULL_HANDLE)
+                {
+                    removeReverseEntry(m_buffer_key_map, entry.vk_buffer, key);
+                }
+                if(entry.vk_image != VK_NULL_HANDLE)
+                {
+                    removeReverseEntry(m_image_key_map, entry.vk_image, key);
+                }
+            }
+            m_descriptor_allocator->freeDescriptorSet(iter->second);
+            m_descriptor_set_map.erase(iter);
+        }
+
+        template<typename HandleType>
+        static void removeReverseEntry(std::unordered_map<HandleType, ReverseEntries>& key_map, HandleType vk_handle, const VulkanDescriptorSetCacheKey* key)
+        {
+            auto found_iter = key_map.find(vk_handle);
+            if(found_iter == key_map.end())
+            {
+                return;
+            }
+            ReverseEntries& reverse_entries = found_iter->second;
+            reverse_entries.erase(std::remove(reverse_entries.begin(), reverse_entries.end(), key), reverse_entries.end());
+            if(reverse_entries.empty())
+            {
+                key_map.erase(found_iter);
+            }
+        }
+
+        VkDevice& m_vk_device;
+        VulkanDescriptorAllocator* m_descriptor_allocator = nullptr;
+        VulkanDescriptorWriter m_descriptor_writer;
+        DescriptorSetMap m_descriptor_set_map;
+        // Resource to the keys binding it, so destroying a resource only visits its own entries
+        std::unordered_map<VkBuffer, ReverseEntries> m_buffer_key_map;
+        std::unordered_map<VkImage, ReverseEntries> m_image_key_map;
+
+        std::uint64_t m_hit_count = 0;
+        std::uint64_t m_miss_count = 0;
+    };
+}
+
+
+
+
@@ -0,0 +1,134 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include "vulkan_descriptor.h"
+#include "../device/vulkan_device_features.h"
+namespace Arieo
+{
+    // Collects descriptor writes for any number of sets and submits them with a single vkUpdateDescriptorSets.
+    // The writer can be kept around and reused, flush keeps the capacity of its arrays.
+    class VulkanDescriptorWriter final
+    {
+    public:
+        VulkanDescriptorWriter& writeBuffer(Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set, std::uint32_t binding, Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, VkDeviceSize offset, VkDeviceSize size)
+        {
+            VulkanDescriptorSet* vulkan_descriptor_set = descriptor_set.castToInstance<VulkanDescriptorSet>();
+            m_info_indices.emplace_back(m_buffer_infos.size());
+            m_buffer_infos.emplace_back(VulkanDescriptorSet::getBufferInfo(buffer, offset, size));
+            addWrite(vulkan_descriptor_set, binding, vulkan_descriptor_set->getDescriptorType(binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER));
+            return *this;
+        }
+
+        // Written with the binding's declared type, storage images are expected in VK_IMAGE_LAYOUT_GENERAL.
+        VulkanDescriptorWriter& writeImage(Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set, std::uint32_t binding, Base::Interop::RawRef<Interface::RHI::IImage> image)
+        {
+            VulkanDescriptorSet* vulkan_descriptor_set = descriptor_set.castToInstance<VulkanDescriptorSet>();
+            VkDescriptorType vk_descriptor_type = vulkan_descriptor_set->getDescriptorType(binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+            VkDescriptorImageInfo image_info = VulkanDescriptorSet::getImageInfo(image, vk_descriptor_type);
+            m_info_indices.emplace_back(m_image_infos.size());
+            m_image_infos.emplace_back(image_info);
+            addWrite(vulkan_descriptor_set, binding, vk_descriptor_type);
+            return *this;
+        }
+
+        void flush()
+        {
+            if(m_vk_descriptor_writes.empty())
+            {
+                return;
+            }
+
+            // Info arrays may have moved while growing, pointers are resolved only now
+            for(size_t write_index = 0; write_index < m_vk_descriptor_writes.size(); write_index++)
+            {
+                VkWriteDescriptorSet& descriptor_write = m_vk_descriptor_writes[write_index];
+                if(isImageDescriptorType(descriptor_write.descriptorType))
+                {
+                    descriptor_write.pImageInfo = &m_image_infos[m_info_indices[write_index]];
+                }
+                else
+                {
+                    descriptor_write.pBufferInfo = &m_buffer_infos[m_info_indices[write_index]];
+                }
+            }
+
+            vkUpdateDescriptorSets(*m_vk_device, static_cast<uint32_t>(m_vk_descriptor_writes.size()), m_vk_descriptor_writes.data(), 0, nullptr);
+
+            m_vk_descriptor_writes.clear();
+            m_info_indices.clear();
+            m_buffer_infos.clear();
+            m_image_infos.clear();
+        }
+
+        size_t getPendingWriteCount() const
+        {
+            return m_vk_descriptor_writes.size();
+        }
+    private:
+        static bool isImageDescriptorType(VkDescriptorType vk_descriptor_type)
+        {
+            return vk_descriptor_type == VK_DESCRIPTOR_TYPE_SAMPLER
+                || vk_descriptor_type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+                || vk_descriptor_type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+                || vk_descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                || vk_descriptor_type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        }
+
+        void addWrite(VulkanDescriptorSet* vulkan_descriptor_set, std::uint32_t binding, VkDescriptorType vk_descriptor_type)
+        {
+            m_vk_device = &vulkan_descriptor_set->m_vk_device;
+
+            VkWriteDescriptorSet descriptor_write{};
+            descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptor_write.dstSet = vulkan_descriptor_set->m_vk_descriptor_set;
+            descriptor_write.dstBinding = binding;
+            descriptor_write.dstArrayElement = 0;
+            descriptor_write.descriptorType = vk_descriptor_type;
+            descriptor_write.descriptorCount = 1;
+            m_vk_descriptor_writes.emplace_back(descriptor_write);
+        }
+
+        VkDevice* m_vk_device = nullptr;
+        std::vector<VkWriteDescriptorSet> m_vk_descriptor_writes;
+        // Per write, index into m_buffer_infos or m_image_infos depending on the descriptor type
+        std::vector<size_t> m_info_indices;
+        std::vector<VkDescriptorBufferInfo> m_buffer_infos;
+        std::vector<VkDescriptorImageInfo> m_image_infos;
+    };
+
+    // Writes every binding of a set from one packed struct. Entry offsets and strides point into that struct,
+    // whose elements are VkDescriptorBufferInfo / VkDescriptorImageInfo as returned by VulkanDescriptorSet::getBufferInfo
+    // and VulkanDescriptorSet::getImageInfo.
+    class VulkanDescriptorUpdateTemplate final
+    {
+    public:
+        VulkanDescriptorUpdateTemplate(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, VkDescriptorUpdateTemplate&& vk_descriptor_update_template)
+            : m_vk_device(vk_device),
+            m_vulkan_device_features(vulkan_device_features),
+            m_vk_descriptor_update_template(std::move(vk_descriptor_update_template))
+        {
+
+        }
+
+        // descriptor_set must use the layout the template was created for.
+        void update(Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set, const void* data)
+        {
+            m_vulkan_device_features.vk_update_descriptor_set_with_template(
+                m_vk_device,
+                descriptor_set.castToInstance<VulkanDescriptorSet>()->m_vk_descriptor_set,
+                m_vk_descriptor_update_template,
+                data
+            );
+        }
+    private:
+        friend class VulkanDevice;
+
+        VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
+        VkDescriptorUpdateTemplate m_vk_descriptor_update_template;
+    };
+}
+
+
+
+
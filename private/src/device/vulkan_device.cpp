@@ -256,15 +256,25 @@ namespace Arieo
                 }
                 
                 Base::Interop::RawRef<Interface::RHI::IImage> vulkan_image = Base::Interop::RawRef<Interface::RHI::IImage>::createAs<VulkanImage>(
+                    m_vk_device,
                     std::move(vk_swapchain_image),
-                    std::move(vk_swapchain_image_view),
                     VK_NULL_HANDLE, 
                     VK_NULL_HANDLE,
                     VmaAllocationInfo{},
                     VkExtent3D(swapchain_create_info.imageExtent.width, swapchain_create_info.imageExtent.height, 1),
-                    swapchain_create_info.imageFormat
+                    swapchain_create_info.imageFormat,
+                    1,
+                    1,
+                    VK_IMAGE_VIEW_TYPE_2D,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    std::vector<VkFormat>{}
                 );
 
+                // Seed the view cache with the swapchain view
+                VulkanImage* vulkan_swapchain_image = vulkan_image.castToInstance<VulkanImage>();
+                vulkan_swapchain_image->addImageView(std::move(vk_swapchain_image_view), vulkan_swapchain_image->getDefaultViewKey());
+
                 vulkan_swapchain.castToInstance<VulkanSwapchain>()->m_image_resource_array.emplace_back(
                     vulkan_image
                 );
@@ -285,8 +295,8 @@ namespace Arieo
         for(Base::Interop::RawRef<Interface::RHI::IImage>& swapchain_image : vulkan_swapchain->m_image_resource_array)
         {
             VulkanImage* vulkan_swapchain_image = swapchain_image.castToInstance<VulkanImage>();
-            // Destroy image view.
-            vkDestroyImageView(m_vk_device, vulkan_swapchain_image->m_vulkan_image_view->m_vk_image_view, nullptr);
+            // Destroy image views.
+            vulkan_swapchain_image->destroyImageViews();
             Base::Interop::RawRef<Interface::RHI::IImage>::destroyAs<VulkanImage>(std::move(swapchain_image));
         }
 
@@ -304,10 +314,16 @@ namespace Arieo
         VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
 
         std::vector<VkImageView> vk_attachment_array;
+        std::vector<VulkanFramebufferAttachment> attachments;
         for(size_t i = 0; i < attachment_array.getItemCount(); i++)
         {
             Base::Interop::RawRef<Interface::RHI::IImageView> attach_image_view = attachment_array[i];
-            vk_attachment_array.emplace_back(attach_image_view.castToInstance<VulkanImageView>()->m_vk_image_view);
+            VulkanImageView* vulkan_image_view = attach_image_view.castToInstance<VulkanImageView>();
+            vk_attachment_array.emplace_back(vulkan_image_view->m_vk_image_view);
+            if(i < vulkan_pipeline->m_vk_attachment_final_layouts.size())
+            {
+                attachments.emplace_back(VulkanFramebufferAttachment{vulkan_image_view, vulkan_pipeline->m_vk_attachment_final_layouts[i]});
+            }
         };
 
         VkFramebufferCreateInfo framebuffer_info{};
@@ -328,7 +344,7 @@ namespace Arieo
         }
 
         Core::Logger::trace("swapchain framebuffer created");
-        return Base::Interop::RawRef<Interface::RHI::IFramebuffer>::createAs<VulkanFramebuffer>(std::move(vk_framebuffer));
+        return Base::Interop::RawRef<Interface::RHI::IFramebuffer>::createAs<VulkanFramebuffer>(std::move(vk_framebuffer), std::move(attachments));
     }
 
     void VulkanDevice::destroyFramebuffer(Base::Interop::RawRef<Interface::RHI::IFramebuffer> framebuffer)
@@ -340,10 +356,22 @@ namespace Arieo
 
     Base::Interop::RawRef<Interface::RHI::IShader> VulkanDevice::createShader(const void* buf, size_t buf_size)
     {
+        VulkanUtility::Digest code_digest = VulkanUtility::computeDigest(buf, buf_size);
+        Base::Interop::RawRef<Interface::RHI::IShader> cached_shader = m_shader_module_cache.acquire(code_digest);
+        if(cached_shader.castToInstance<VulkanShader>() != nullptr)
+        {
+            Core::Logger::trace("shader reused from cache");
+            return cached_shader;
+        }
+
+        // The module cache stays keyed by the supplied code, the optimizer only changes what the driver sees
+        std::vector<std::uint32_t> optimized_code;
+        bool is_optimized = m_shader_optimizer != nullptr && m_shader_optimizer->optimize(buf, buf_size, optimized_code);
+
         VkShaderModuleCreateInfo create_info{};
         create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        create_info.codeSize = buf_size;
-        create_info.pCode = reinterpret_cast<const uint32_t*>(buf);
+        create_info.codeSize = is_optimized ? optimized_code.size() * sizeof(std::uint32_t) : buf_size;
+        create_info.pCode = is_optimized ? optimized_code.data() : reinterpret_cast<const uint32_t*>(buf);
 
         VkShaderModule shader_module;
         VkResult result = vkCreateShaderModule(m_vk_device, &create_info, nullptr, &shader_module);
@@ -353,18 +381,147 @@ namespace Arieo
             return nullptr;
         }
 
+        // Reflected once here so pipelines can derive their layouts without parsing again. The supplied code is
+        // reflected, dead code elimination must not drop bindings the application still writes.
+        VulkanShaderReflection reflection = VulkanShaderReflector::reflect(buf, buf_size);
+        if(reflection.is_valid == false)
+        {
+            Core::Logger::warn("Shader reflection failed, pipelines need explicit layouts for it");
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IShader> shader = Base::Interop::RawRef<Interface::RHI::IShader>::createAs<VulkanShader>(std::move(shader_module), std::move(reflection));
+        VulkanShader* vulkan_shader = shader.castToInstance<VulkanShader>();
+        vulkan_shader->m_code_digest = code_digest;
+        vulkan_shader->m_is_cached = true;
+        // Only shader objects are created from the code itself, pipelines and libraries need the module alone
+        if(m_is_shader_object_enabled)
+        {
+            const std::uint32_t* code_words = create_info.pCode;
+            vulkan_shader->m_code.assign(code_words, code_words + create_info.codeSize / sizeof(std::uint32_t));
+        }
+        if(m_vulkan_device_features.shader_module_identifier)
+        {
+            VkShaderModuleIdentifierEXT vk_module_identifier{};
+            vk_module_identifier.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_IDENTIFIER_EXT;
+            m_vulkan_device_features.vk_get_shader_module_identifier(m_vk_device, vulkan_shader->m_vk_shader_module, &vk_module_identifier);
+            vulkan_shader->m_module_identifier.assign(vk_module_identifier.identifier, vk_module_identifier.identifier + vk_module_identifier.identifierSize);
+        }
+
+        // Another thread may have created the same shader meanwhile, keep only one of them
+        Base::Interop::RawRef<Interface::RHI::IShader> added_shader = m_shader_module_cache.add(shader);
+        if(added_shader.castToInstance<VulkanShader>() != vulkan_shader)
+        {
+            vkDestroyShaderModule(m_vk_device, vulkan_shader->m_vk_shader_module, nullptr);
+            Base::Interop::RawRef<Interface::RHI::IShader>::destroyAs<VulkanShader>(std::move(shader));
+            return added_shader;
+        }
+
         Core::Logger::trace("shader created");
-        return Base::Interop::RawRef<Interface::RHI::IShader>::createAs<VulkanShader>(std::move(shader_module));
+        return shader;
+    }
+
+    Base::Interop::RawRef<Interface::RHI::IShader> VulkanDevice::createShaderFromIdentifier(const std::uint8_t* identifier, std::uint32_t identifier_size)
+    {
+        if(m_vulkan_device_features.shader_module_identifier == false)
+        {
+            Core::Logger::error("Shader module identifiers are not supported by the device");
+            return nullptr;
+        }
+        if(identifier_size == 0 || identifier_size > VK_MAX_SHADER_MODULE_IDENTIFIER_SIZE_EXT)
+        {
+            Core::Logger::error("Shader module identifier size {} is invalid", identifier_size);
+            return nullptr;
+        }
+
+        VkShaderModule shader_module = VK_NULL_HANDLE;
+        Base::Interop::RawRef<Interface::RHI::IShader> shader = Base::Interop::RawRef<Interface::RHI::IShader>::createAs<VulkanShader>(std::move(shader_module), VulkanShaderReflection{});
+        shader.castToInstance<VulkanShader>()->m_module_identifier.assign(identifier, identifier + identifier_size);
+        return shader;
+    }
+
+    VulkanShaderCompiler* VulkanDevice::createShaderCompiler(const std::string& cache_directory, const std::vector<std::string>& include_directories, std::uint32_t thread_count)
+    {
+        if(VulkanShaderCompiler::isCompilerAvailable() == false)
+        {
+            Core::Logger::warn("Built without a shader compiler, only shaders in the cache at {} can be loaded", cache_directory);
+        }
+        return Base::newT<VulkanShaderCompiler>(cache_directory, include_directories, thread_count);
+    }
+
+    void VulkanDevice::destroyShaderCompiler(VulkanShaderCompiler* shader_compiler)
+    {
+        Base::deleteT(shader_compiler);
+    }
+
+    Base::Interop::RawRef<Interface::RHI::IShader> VulkanDevice::createShaderFromSource(VulkanShaderCompiler& shader_compiler, const VulkanShaderSource& shader_source)
+    {
+        VulkanShaderCompileResult compile_result = shader_compiler.compile(shader_source);
+        if(compile_result.is_success == false)
+        {
+            Core::Logger::error("Failed to compile shader {}: {}", shader_source.name, compile_result.log);
+            return nullptr;
+        }
+        if(compile_result.log.empty() == false)
+        {
+            Core::Logger::warn("Shader {}: {}", shader_source.name, compile_result.log);
+        }
+        Core::Logger::trace("shader {} compiled{}", shader_source.name, compile_result.is_cache_hit ? " (cached)" : "");
+        return createShader(compile_result.spirv.data(), compile_result.spirv.size() * sizeof(std::uint32_t));
     }
 
     void VulkanDevice::destroyShader(Base::Interop::RawRef<Interface::RHI::IShader> shader)
     {
         VulkanShader* vulkan_shader = shader.castToInstance<VulkanShader>();
-        vkDestroyShaderModule(m_vk_device, vulkan_shader->m_vk_shader_module, nullptr);
+        if(vulkan_shader->m_is_cached && m_shader_module_cache.release(shader) == false)
+        {
+            return;
+        }
+        if(vulkan_shader->m_vk_shader_module != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_vk_device, vulkan_shader->m_vk_shader_module, nullptr);
+        }
 
         Base::Interop::RawRef<Interface::RHI::IShader>::destroyAs<VulkanShader>(std::move(shader));
     }
 
+    bool VulkanDevice::loadPipelineCacheData(const void* data, size_t data_size)
+    {
+        VkPipelineCacheCreateInfo pipeline_cache_info{};
+        pipeline_cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        pipeline_cache_info.initialDataSize = data_size;
+        pipeline_cache_info.pInitialData = data;
+
+        VkPipelineCache vk_loaded_pipeline_cache;
+        VkResult result = vkCreatePipelineCache(m_vk_device, &pipeline_cache_info, nullptr, &vk_loaded_pipeline_cache);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Load pipeline cache failed: {}", VulkanUtility::covertVkResultToString(result));
+            return false;
+        }
+        result = vkMergePipelineCaches(m_vk_device, m_vk_pipeline_cache, 1, &vk_loaded_pipeline_cache);
+        vkDestroyPipelineCache(m_vk_device, vk_loaded_pipeline_cache, nullptr);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Merge pipeline cache failed: {}", VulkanUtility::covertVkResultToString(result));
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<std::uint8_t> VulkanDevice::getPipelineCacheData()
+    {
+        size_t data_size = 0;
+        vkGetPipelineCacheData(m_vk_device, m_vk_pipeline_cache, &data_size, nullptr);
+        std::vector<std::uint8_t> data(data_size);
+        if(vkGetPipelineCacheData(m_vk_device, m_vk_pipeline_cache, &data_size, data.data()) != VK_SUCCESS)
+        {
+            Core::Logger::error("Get pipeline cache data failed");
+            return {};
+        }
+        data.resize(data_size);
+        return data;
+    }
+
     Base::Interop::RawRef<Interface::RHI::IPipeline> VulkanDevice::createPipeline(
         Base::Interop::RawRef<Interface::RHI::IShader> vert_shader, 
         Base::Interop::RawRef<Interface::RHI::IShader> frag_shader, 
@@ -372,50 +529,415 @@ namespace Arieo
         Base::Interop::RawRef<Interface::RHI::IImageView> target_depth_attachment
     )
     {
-        VulkanImageView* target_color_image_view = target_color_attachment.castToInstance<VulkanImageView>();
-        VulkanImageView* target_depth_image_view = target_depth_attachment.castToInstance<VulkanImageView>();
+        VulkanGraphicsPipelineDesc pipeline_desc;
+        pipeline_desc.vert_shader = vert_shader;
+        pipeline_desc.frag_shader = frag_shader;
+        pipeline_desc.target_color_attachment = target_color_attachment;
+        pipeline_desc.target_depth_attachment = target_depth_attachment;
+
+        // Layouts come from shader reflection, the shape the interface has always assumed is kept for
+        // shaders that cannot be reflected
+        if(vert_shader.castToInstance<VulkanShader>()->m_reflection.is_valid == false
+        || frag_shader.castToInstance<VulkanShader>()->m_reflection.is_valid == false)
+        {
+            struct Vertex
+            {
+                Base::Math::Vector3 pos;
+                Base::Math::Vector3 color;
+                Base::Math::Vector2 tex_coord;
+            };
+
+            pipeline_desc.vertex_layout
+                .addBinding(0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX)
+                .addAttribute(0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos))
+                .addAttribute(1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color))
+                .addAttribute(2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, tex_coord));
+
+            // Uniform buffer for the vertex stage and one texture for the fragment stage
+            VkDescriptorSetLayoutBinding desc_layout_binding{};
+            desc_layout_binding.binding = 0;
+            desc_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            desc_layout_binding.descriptorCount = 1;
+            desc_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+            VkDescriptorSetLayoutBinding sample_layout_binding{};
+            sample_layout_binding.binding = 1;
+            sample_layout_binding.descriptorCount = 1;
+            sample_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            sample_layout_binding.pImmutableSamplers = nullptr;
+            sample_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+            pipeline_desc.descriptor_set_layouts = {{desc_layout_binding, sample_layout_binding}};
+        }
+        // Pairs with createDescriptorPool, which hands out descriptor buffer pools once they are enabled
+        pipeline_desc.use_descriptor_buffer = m_is_descriptor_buffer_enabled;
+        return createPipeline(pipeline_desc);
+    }
+
+    bool VulkanDevice::applyShaderReflection(VulkanGraphicsPipelineDesc& pipeline_desc)
+    {
+        const VulkanShaderReflection& vert_reflection = pipeline_desc.vert_shader.castToInstance<VulkanShader>()->m_reflection;
+        const VulkanShaderReflection& frag_reflection = pipeline_desc.frag_shader.castToInstance<VulkanShader>()->m_reflection;
+        if(vert_reflection.is_valid == false || frag_reflection.is_valid == false)
+        {
+            return true;
+        }
+
+        if(pipeline_desc.descriptor_set_layouts.empty())
+        {
+            // The bindless heap is appended after the pipeline's own sets, so it is the last set the shaders declare
+            std::uint32_t descriptor_set_count = std::max(vert_reflection.getDescriptorSetCount(), frag_reflection.getDescriptorSetCount());
+            if(pipeline_desc.use_bindless_heap && descriptor_set_count > 0)
+            {
+                descriptor_set_count--;
+            }
+
+            pipeline_desc.descriptor_set_layouts.resize(descriptor_set_count);
+            for(const VulkanShaderReflection* reflection : {&vert_reflection, &frag_reflection})
+            {
+                for(const VulkanShaderReflection::DescriptorBinding& descriptor_binding : reflection->descriptor_bindings)
+                {
+                    if(descriptor_binding.set >= descriptor_set_count)
+                    {
+                        continue;
+                    }
+                    if(descriptor_binding.vk_binding.descriptorCount == 0)
+                    {
+                        Core::Logger::error("Set {} binding {} is a runtime sized array, it needs an explicit layout", descriptor_binding.set, descriptor_binding.vk_binding.binding);
+                        return false;
+                    }
+
+                    std::vector<VkDescriptorSetLayoutBinding>& vk_descriptor_bindings = pipeline_desc.descriptor_set_layouts[descriptor_binding.set];
+                    auto found_iter = std::find_if(vk_descriptor_bindings.begin(), vk_descriptor_bindings.end(),
+                        [&descriptor_binding](const VkDescriptorSetLayoutBinding& vk_binding) { return vk_binding.binding == descriptor_binding.vk_binding.binding; });
+                    if(found_iter == vk_descriptor_bindings.end())
+                    {
+                        vk_descriptor_bindings.emplace_back(descriptor_binding.vk_binding);
+                    }
+                    else if(found_iter->descriptorType != descriptor_binding.vk_binding.descriptorType
+                        || found_iter->descriptorCount != descriptor_binding.vk_binding.descriptorCount)
+                    {
+                        Core::Logger::error("Set {} binding {} is declared differently by the vertex and fragment shaders", descriptor_binding.set, descriptor_binding.vk_binding.binding);
+                        return false;
+                    }
+                    else
+                    {
+                        found_iter->stageFlags |= descriptor_binding.vk_binding.stageFlags;
+                    }
+                }
+            }
+        }
+
+        // Overlapping blocks of the stages are merged into one range for all of them, a block shared by the vertex
+        // and fragment shaders is pushed once with both stage flags
+        if(pipeline_desc.push_constant_ranges.empty())
+        {
+            std::vector<VkPushConstantRange>& push_constant_ranges = pipeline_desc.push_constant_ranges;
+            for(const VulkanShaderReflection* reflection : {&vert_reflection, &frag_reflection})
+            {
+                for(const VkPushConstantRange& reflected_range : reflection->push_constant_ranges)
+                {
+                    // The merged range grows, start over after each absorbed range to catch new overlaps
+                    VkPushConstantRange merged_range = reflected_range;
+                    for(auto range_iter = push_constant_ranges.begin(); range_iter != push_constant_ranges.end();)
+                    {
+                        if(range_iter->offset < merged_range.offset + merged_range.size
+                        && merged_range.offset < range_iter->offset + range_iter->size)
+                        {
+                            std::uint32_t range_end = std::max(merged_range.offset + merged_range.size, range_iter->offset + range_iter->size);
+                            merged_range.offset = std::min(merged_range.offset, range_iter->offset);
+                            merged_range.size = range_end - merged_range.offset;
+                            merged_range.stageFlags |= range_iter->stageFlags;
+                            push_constant_ranges.erase(range_iter);
+                            range_iter = push_constant_ranges.begin();
+                        }
+                        else
+                        {
+                            ++range_iter;
+                        }
+                    }
+                    push_constant_ranges.emplace_back(merged_range);
+                }
+            }
+        }
+
+        // One interleaved vertex buffer at binding 0, attributes tightly packed in location order
+        if(pipeline_desc.vertex_layout.bindings.empty() && pipeline_desc.vertex_layout.attributes.empty() && vert_reflection.vertex_inputs.empty() == false)
+        {
+            std::uint32_t offset = 0;
+            for(const VulkanShaderReflection::VertexInput& vertex_input : vert_reflection.vertex_inputs)
+            {
+                if(vertex_input.format == VK_FORMAT_UNDEFINED)
+                {
+                    Core::Logger::error("Vertex input at location {} has no vertex format, it needs an explicit vertex layout", vertex_input.location);
+                    return false;
+                }
+                pipeline_desc.vertex_layout.addAttribute(vertex_input.location, 0, vertex_input.format, offset);
+                offset += vertex_input.size;
+            }
+            pipeline_desc.vertex_layout.addBinding(0, offset, VK_VERTEX_INPUT_RATE_VERTEX);
+        }
+        return true;
+    }
+
+    Base::Interop::RawRef<Interface::RHI::IPipeline> VulkanDevice::createPipeline(const VulkanGraphicsPipelineDesc& desc)
+    {
+        // Whatever the desc leaves empty is derived from the shaders
+        VulkanGraphicsPipelineDesc pipeline_desc = desc;
+        if(applyShaderReflection(pipeline_desc) == false)
+        {
+            return nullptr;
+        }
+
+        VulkanImageView* target_color_image_view = pipeline_desc.target_color_attachment.castToInstance<VulkanImageView>();
+        VulkanImageView* target_depth_image_view = pipeline_desc.target_depth_attachment.castToInstance<VulkanImageView>();
+
+        // Validate vertex input
+        {
+            const VkPhysicalDeviceLimits& limits = m_vk_phys_device_properties.limits;
+            if(pipeline_desc.vertex_layout.bindings.size() > limits.maxVertexInputBindings
+            || pipeline_desc.vertex_layout.attributes.size() > limits.maxVertexInputAttributes)
+            {
+                Core::Logger::error("Vertex layout exceeds device limits");
+                return nullptr;
+            }
+
+            for(const VkPushConstantRange& push_constant_range : pipeline_desc.push_constant_ranges)
+            {
+                if(push_constant_range.offset % 4 != 0 || push_constant_range.size % 4 != 0 || push_constant_range.size == 0
+                || push_constant_range.offset + push_constant_range.size > limits.maxPushConstantsSize)
+                {
+                    Core::Logger::error("Push constant range {}+{} is invalid, limit is {} bytes", push_constant_range.offset, push_constant_range.size, limits.maxPushConstantsSize);
+                    return nullptr;
+                }
+            }
+
+            if(pipeline_desc.use_bindless_heap && m_bindless_heap == nullptr)
+            {
+                Core::Logger::error("Pipeline uses the bindless heap but it is not enabled");
+                return nullptr;
+            }
+
+            if(pipeline_desc.use_descriptor_buffer)
+            {
+                if(m_vulkan_device_features.descriptor_buffer == false)
+                {
+                    Core::Logger::error("Pipeline uses descriptor buffers but the device does not support them");
+                    return nullptr;
+                }
+                if(pipeline_desc.use_bindless_heap)
+                {
+                    Core::Logger::error("The bindless heap is a classic descriptor set, it cannot be used with descriptor buffers");
+                    return nullptr;
+                }
+            }
+
+            size_t descriptor_set_count = pipeline_desc.descriptor_set_layouts.size() + (pipeline_desc.use_bindless_heap ? 1 : 0);
+            if(descriptor_set_count > limits.maxBoundDescriptorSets
+            || descriptor_set_count > VulkanCommandShadowState::MAX_DESCRIPTOR_SETS)
+            {
+                Core::Logger::error("Pipeline uses {} descriptor sets, device supports {}", descriptor_set_count, limits.maxBoundDescriptorSets);
+                return nullptr;
+            }
+
+            // Dynamic buffer limits apply to the whole pipeline layout
+            std::uint32_t dynamic_uniform_buffer_count = 0;
+            std::uint32_t dynamic_storage_buffer_count = 0;
+            for(const std::vector<VkDescriptorSetLayoutBinding>& descriptor_bindings : pipeline_desc.descriptor_set_layouts)
+            {
+                for(const VkDescriptorSetLayoutBinding& descriptor_binding : descriptor_bindings)
+                {
+                    if(descriptor_binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+                    {
+                        dynamic_uniform_buffer_count += descriptor_binding.descriptorCount;
+                    }
+                    else if(descriptor_binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+                    {
+                        dynamic_storage_buffer_count += descriptor_binding.descriptorCount;
+                    }
+                }
+            }
+            if(pipeline_desc.use_descriptor_buffer && (dynamic_uniform_buffer_count != 0 || dynamic_storage_buffer_count != 0))
+            {
+                Core::Logger::error("Dynamic buffers are not available with descriptor buffers");
+                return nullptr;
+            }
+            if(dynamic_uniform_buffer_count > limits.maxDescriptorSetUniformBuffersDynamic
+            || dynamic_storage_buffer_count > limits.maxDescriptorSetStorageBuffersDynamic)
+            {
+                Core::Logger::error("Pipeline uses more dynamic buffers than the device supports");
+                return nullptr;
+            }
+
+            for(const VkVertexInputAttributeDescription& attribute_desc : pipeline_desc.vertex_layout.attributes)
+            {
+                VkFormatProperties vk_format_properties;
+                vkGetPhysicalDeviceFormatProperties(m_vk_phys_device, attribute_desc.format, &vk_format_properties);
+                if((vk_format_properties.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT) == 0)
+                {
+                    Core::Logger::error("Vertex attribute format {} at location {} is not supported", (std::uint32_t)attribute_desc.format, attribute_desc.location);
+                    return nullptr;
+                }
+            }
+
+            // Values have to match the size the shader declares, unknown ids are ignored by the driver
+            auto is_specialization_valid = [](const VulkanShader* vulkan_shader, const VulkanSpecialization& specialization)
+            {
+                if(vulkan_shader->m_reflection.is_valid == false)
+                {
+                    return true;
+                }
+                const std::vector<VulkanShaderReflection::SpecializationConstant>& specialization_constants = vulkan_shader->m_reflection.specialization_constants;
+                for(const VkSpecializationMapEntry& map_entry : specialization.map_entries)
+                {
+                    auto found_iter = std::find_if(specialization_constants.begin(), specialization_constants.end(),
+                        [&map_entry](const VulkanShaderReflection::SpecializationConstant& specialization_constant) { return specialization_constant.constant_id == map_entry.constantID; });
+                    if(found_iter == specialization_constants.end())
+                    {
+                        Core::Logger::warn("Shader declares no specialization constant {}", map_entry.constantID);
+                    }
+                    else if(found_iter->size != map_entry.size)
+                    {
+                        Core::Logger::error("Specialization constant {} is {} bytes, {} given", map_entry.constantID, found_iter->size, map_entry.size);
+                        return false;
+                    }
+                }
+                return true;
+            };
+            if(is_specialization_valid(pipeline_desc.vert_shader.castToInstance<VulkanShader>(), pipeline_desc.vert_specialization) == false
+            || is_specialization_valid(pipeline_desc.frag_shader.castToInstance<VulkanShader>(), pipeline_desc.frag_specialization) == false)
+            {
+                return nullptr;
+            }
+
+            if(pipeline_desc.raster_state.polygon_mode != VK_POLYGON_MODE_FILL && m_vulkan_device_features.getEnabledCoreFeatures().fillModeNonSolid == VK_FALSE)
+            {
+                Core::Logger::error("Polygon mode {} needs the fillModeNonSolid feature", (std::uint32_t)pipeline_desc.raster_state.polygon_mode);
+                return nullptr;
+            }
+
+            if(pipeline_desc.use_shader_objects)
+            {
+                if(m_is_shader_object_enabled == false)
+                {
+                    Core::Logger::error("Pipeline uses shader objects but they are not enabled on the device");
+                    return nullptr;
+                }
+                if(pipeline_desc.vert_shader.castToInstance<VulkanShader>()->m_code.empty()
+                || pipeline_desc.frag_shader.castToInstance<VulkanShader>()->m_code.empty())
+                {
+                    Core::Logger::error("Shader objects are created from SPIR-V, the shaders have to be created after enableShaderObjects and not from an identifier");
+                    return nullptr;
+                }
+            }
+            else if(pipeline_desc.pipeline_library != nullptr && m_vulkan_device_features.graphics_pipeline_library == false)
+            {
+                Core::Logger::error("Pipeline uses a pipeline library but the device does not support graphics pipeline libraries");
+                return nullptr;
+            }
+        }
 
         // Set shaders
         Core::Logger::trace("Set shaders");
         VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
         vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vert_shader_stage_info.module = vert_shader.castToInstance<VulkanShader>()->m_vk_shader_module;
-        vert_shader_stage_info.pName = "main";
+        vert_shader_stage_info.module = pipeline_desc.vert_shader.castToInstance<VulkanShader>()->m_vk_shader_module;
+        vert_shader_stage_info.pName = pipeline_desc.vert_shader.castToInstance<VulkanShader>()->m_reflection.entry_point.c_str();
 
         VkPipelineShaderStageCreateInfo frag_shader_stage_info{};
         frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        frag_shader_stage_info.module = frag_shader.castToInstance<VulkanShader>()->m_vk_shader_module;
-        frag_shader_stage_info.pName = "main";
+        frag_shader_stage_info.module = pipeline_desc.frag_shader.castToInstance<VulkanShader>()->m_vk_shader_module;
+        frag_shader_stage_info.pName = pipeline_desc.frag_shader.castToInstance<VulkanShader>()->m_reflection.entry_point.c_str();
+
+        VkSpecializationInfo vert_specialization_info = pipeline_desc.vert_specialization.getInfo();
+        if(pipeline_desc.vert_specialization.empty() == false)
+        {
+            vert_shader_stage_info.pSpecializationInfo = &vert_specialization_info;
+        }
+        VkSpecializationInfo frag_specialization_info = pipeline_desc.frag_specialization.getInfo();
+        if(pipeline_desc.frag_specialization.empty() == false)
+        {
+            frag_shader_stage_info.pSpecializationInfo = &frag_specialization_info;
+        }
 
         VkPipelineShaderStageCreateInfo shaderStages[] = {vert_shader_stage_info, frag_shader_stage_info};
 
+        // Shaders created from an identifier alone are only resolved through the pipeline cache
+        std::array<VulkanShader*, 2> vulkan_shaders = {pipeline_desc.vert_shader.castToInstance<VulkanShader>(), pipeline_desc.frag_shader.castToInstance<VulkanShader>()};
+        std::array<VkPipelineShaderStageModuleIdentifierCreateInfoEXT, 2> vk_module_identifier_infos{};
+        bool is_identifier_only = false;
+        for(size_t stage_index = 0; stage_index < vulkan_shaders.size(); stage_index++)
+        {
+            if(vulkan_shaders[stage_index]->m_vk_shader_module == VK_NULL_HANDLE)
+            {
+                vk_module_identifier_infos[stage_index].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_MODULE_IDENTIFIER_CREATE_INFO_EXT;
+                vk_module_identifier_infos[stage_index].identifierSize = static_cast<uint32_t>(vulkan_shaders[stage_index]->m_module_identifier.size());
+                vk_module_identifier_infos[stage_index].pIdentifier = vulkan_shaders[stage_index]->m_module_identifier.data();
+                shaderStages[stage_index].pNext = &vk_module_identifier_infos[stage_index];
+                is_identifier_only = true;
+            }
+        }
+
         // Dynamic state configs
         Core::Logger::trace("Dynamic state config");
-        VkDynamicState dynamic_states[]
+        std::vector<VkDynamicState> dynamic_states
         {
             VK_DYNAMIC_STATE_VIEWPORT,
             VK_DYNAMIC_STATE_SCISSOR
         };
+        // Whatever the device can set on the command buffer stays out of the pipeline, one pipeline then serves
+        // every cull mode, depth state, ... and VulkanCommandBuffer::bindPipeline records the desc's values
+        if(m_vulkan_device_features.extended_dynamic_state)
+        {
+            dynamic_states.insert(dynamic_states.end(), {
+                VK_DYNAMIC_STATE_CULL_MODE,
+                VK_DYNAMIC_STATE_FRONT_FACE,
+                VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+                VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+                VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+                VK_DYNAMIC_STATE_DEPTH_COMPARE_OP
+            });
+        }
+        if(m_vulkan_device_features.extended_dynamic_state2)
+        {
+            dynamic_states.insert(dynamic_states.end(), {
+                VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE,
+                VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE
+            });
+        }
+        if(m_vulkan_device_features.extended_dynamic_state3)
+        {
+            dynamic_states.insert(dynamic_states.end(), {
+                VK_DYNAMIC_STATE_POLYGON_MODE_EXT,
+                VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT,
+                VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT,
+                VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT
+            });
+        }
+        if(m_vulkan_device_features.vertex_input_dynamic_state)
+        {
+            dynamic_states.emplace_back(VK_DYNAMIC_STATE_VERTEX_INPUT_EXT);
+        }
         VkPipelineDynamicStateCreateInfo dynamic_state{};
         dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamic_state.dynamicStateCount = static_cast<uint32_t>(sizeof(dynamic_states) / sizeof(dynamic_states[0]));
-        dynamic_state.pDynamicStates = dynamic_states;
+        dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+        dynamic_state.pDynamicStates = dynamic_states.data();
 
         //Viewport and scissor
         Core::Logger::trace("Viewport and scissor");
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = static_cast<float>(target_color_image_view->m_vulkan_image.m_vk_image_extent.width);
-        viewport.height = static_cast<float>(target_color_image_view->m_vulkan_image.m_vk_image_extent.height);
+        viewport.width = static_cast<float>(target_color_image_view->getExtent().width);
+        viewport.height = static_cast<float>(target_color_image_view->getExtent().height);
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;        
 
         VkRect2D scissor{};
         scissor.offset = {0, 0};
-        scissor.extent = {target_color_image_view->m_vulkan_image.m_vk_image_extent.width, target_color_image_view->m_vulkan_image.m_vk_image_extent.height};
+        scissor.extent = {target_color_image_view->getExtent().width, target_color_image_view->getExtent().height};
 
         VkPipelineViewportStateCreateInfo viewportState{};
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -424,90 +946,66 @@ namespace Arieo
         viewportState.scissorCount = 1;
         viewportState.pScissors = &scissor;        
 
-        //TODO pass this from parameters.
-        struct Vertex
+        std::vector<VkDescriptorSetLayout> vk_descriptor_set_layouts;
+        for(const std::vector<VkDescriptorSetLayoutBinding>& descriptor_bindings : pipeline_desc.descriptor_set_layouts)
         {
-            Base::Math::Vector3 pos;
-            Base::Math::Vector3 color;
-            Base::Math::Vector2 tex_coord;
-        };
-        VkVertexInputBindingDescription binding_desc{};
-        binding_desc.binding = 0;
-        binding_desc.stride = sizeof(Vertex);
-        binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        std::array<VkVertexInputAttributeDescription, 3> attribute_desc_array;
-        {
-            attribute_desc_array[0].binding = 0;
-            attribute_desc_array[0].location = 0;
-            attribute_desc_array[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attribute_desc_array[0].offset = offsetof(Vertex, pos);
-
-            attribute_desc_array[1].binding = 0;
-            attribute_desc_array[1].location = 1;
-            attribute_desc_array[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attribute_desc_array[1].offset = offsetof(Vertex, color);
-
-            attribute_desc_array[2].binding = 0;
-            attribute_desc_array[2].location = 2;
-            attribute_desc_array[2].format = VK_FORMAT_R32G32_SFLOAT;
-            attribute_desc_array[2].offset = offsetof(Vertex, tex_coord);
-        };
-
-        //TODO pass this from parameter
-        VkDescriptorSetLayout vk_descriptor_set_layout;
-        {
-            VkDescriptorSetLayoutBinding desc_layout_binding{};
-            desc_layout_binding.binding = 0;
-            desc_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            desc_layout_binding.descriptorCount = 1;
-            desc_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-            VkDescriptorSetLayoutBinding sample_layout_binding{};
-            sample_layout_binding.binding = 1;
-            sample_layout_binding.descriptorCount = 1;
-            sample_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            sample_layout_binding.pImmutableSamplers = nullptr;
-            sample_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-            std::array<VkDescriptorSetLayoutBinding, 2> bindings = {desc_layout_binding, sample_layout_binding};
-
             VkDescriptorSetLayoutCreateInfo desc_layout_create_info{};
             desc_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            desc_layout_create_info.bindingCount = bindings.size();
-            desc_layout_create_info.pBindings = bindings.data();
+            desc_layout_create_info.bindingCount = static_cast<uint32_t>(descriptor_bindings.size());
+            desc_layout_create_info.pBindings = descriptor_bindings.data();
+            if(pipeline_desc.use_descriptor_buffer)
+            {
+                desc_layout_create_info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+            }
             
+            VkDescriptorSetLayout vk_descriptor_set_layout;
             if (vkCreateDescriptorSetLayout(m_vk_device, &desc_layout_create_info, nullptr, &vk_descriptor_set_layout) != VK_SUCCESS) 
             {
                 Core::Logger::error("failed to create descriptor set layout!");
+                for(VkDescriptorSetLayout created_set_layout : vk_descriptor_set_layouts)
+                {
+                    vkDestroyDescriptorSetLayout(m_vk_device, created_set_layout, nullptr);
+                }
                 return nullptr;
             }
+            vk_descriptor_set_layouts.emplace_back(vk_descriptor_set_layout);
+        }
+
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> vk_descriptor_set_bindings = pipeline_desc.descriptor_set_layouts;
+        std::uint32_t bindless_set_index = UINT32_MAX;
+        if(pipeline_desc.use_bindless_heap)
+        {
+            bindless_set_index = static_cast<std::uint32_t>(vk_descriptor_set_layouts.size());
+            vk_descriptor_set_layouts.emplace_back(m_bindless_heap->m_vk_descriptor_set_layout);
+            vk_descriptor_set_bindings.emplace_back(m_bindless_heap->m_vk_descriptor_bindings);
         }
         
         // Vertex input
         Core::Logger::trace("Vertex input");
         VkPipelineVertexInputStateCreateInfo vertex_input_info{};
         vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertex_input_info.vertexBindingDescriptionCount = 1;
-        vertex_input_info.pVertexBindingDescriptions = &binding_desc; // Optional
-        vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_desc_array.size());
-        vertex_input_info.pVertexAttributeDescriptions = attribute_desc_array.data(); // Optional
+        vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(pipeline_desc.vertex_layout.bindings.size());
+        vertex_input_info.pVertexBindingDescriptions = pipeline_desc.vertex_layout.bindings.data(); // Optional
+        vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(pipeline_desc.vertex_layout.attributes.size());
+        vertex_input_info.pVertexAttributeDescriptions = pipeline_desc.vertex_layout.attributes.data(); // Optional
 
         // Input assembly
         Core::Logger::trace("input assembly");
         VkPipelineInputAssemblyStateCreateInfo input_assembly{};
         input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        input_assembly.primitiveRestartEnable = VK_FALSE;        
+        input_assembly.topology = pipeline_desc.topology;
+        input_assembly.primitiveRestartEnable = pipeline_desc.raster_state.primitive_restart_enable ? VK_TRUE : VK_FALSE;
 
         // Rasterizer
         Core::Logger::trace("rasterizer");
         VkPipelineRasterizationStateCreateInfo rasterizer{};
         rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
         rasterizer.depthClampEnable = VK_FALSE;
-        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.rasterizerDiscardEnable = pipeline_desc.raster_state.rasterizer_discard_enable ? VK_TRUE : VK_FALSE;
+        rasterizer.polygonMode = pipeline_desc.raster_state.polygon_mode;
         rasterizer.lineWidth = 1.0f;
-        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterizer.cullMode = pipeline_desc.raster_state.cull_mode;
+        rasterizer.frontFace = pipeline_desc.raster_state.front_face;
         rasterizer.depthBiasEnable = VK_FALSE;
         rasterizer.depthBiasConstantFactor = 0.0f; // Optional
         rasterizer.depthBiasClamp = 0.0f; // Optional
@@ -526,14 +1024,14 @@ namespace Arieo
         // Color blending
         Core::Logger::trace("color blending");
         VkPipelineColorBlendAttachmentState color_blend_attachment{};
-        color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        color_blend_attachment.blendEnable = VK_FALSE;
-        color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-        color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-        color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-        color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-        color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-        color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+        color_blend_attachment.colorWriteMask = pipeline_desc.raster_state.color_write_mask;
+        color_blend_attachment.blendEnable = pipeline_desc.raster_state.blend_enable ? VK_TRUE : VK_FALSE;
+        color_blend_attachment.srcColorBlendFactor = pipeline_desc.raster_state.blend_equation.srcColorBlendFactor;
+        color_blend_attachment.dstColorBlendFactor = pipeline_desc.raster_state.blend_equation.dstColorBlendFactor;
+        color_blend_attachment.colorBlendOp = pipeline_desc.raster_state.blend_equation.colorBlendOp;
+        color_blend_attachment.srcAlphaBlendFactor = pipeline_desc.raster_state.blend_equation.srcAlphaBlendFactor;
+        color_blend_attachment.dstAlphaBlendFactor = pipeline_desc.raster_state.blend_equation.dstAlphaBlendFactor;
+        color_blend_attachment.alphaBlendOp = pipeline_desc.raster_state.blend_equation.alphaBlendOp;
 
         VkPipelineColorBlendStateCreateInfo color_blending{};
         color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -548,25 +1046,167 @@ namespace Arieo
 
         // Pipeline layout
         Core::Logger::trace("pipeline layout");
-        VkPipelineLayout vk_pipeline_layout;
+        VkPipelineLayout vk_pipeline_layout = VK_NULL_HANDLE;
         VkPipelineLayoutCreateInfo pipeline_layout_info{};
         pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_info.setLayoutCount = 1; // Optional
-        pipeline_layout_info.pSetLayouts = &vk_descriptor_set_layout; // Optional
-        pipeline_layout_info.pushConstantRangeCount = 0; // Optional
-        pipeline_layout_info.pPushConstantRanges = nullptr; // Optional
+        pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(vk_descriptor_set_layouts.size()); // Optional
+        pipeline_layout_info.pSetLayouts = vk_descriptor_set_layouts.data(); // Optional
+        pipeline_layout_info.pushConstantRangeCount = static_cast<uint32_t>(pipeline_desc.push_constant_ranges.size()); // Optional
+        pipeline_layout_info.pPushConstantRanges = pipeline_desc.push_constant_ranges.data(); // Optional
+
+        auto destroy_layouts = [this, &vk_descriptor_set_layouts, bindless_set_index, &vk_pipeline_layout]()
+        {
+            for(std::uint32_t set_index = 0; set_index < vk_descriptor_set_layouts.size(); set_index++)
+            {
+                if(set_index != bindless_set_index)
+                {
+                    vkDestroyDescriptorSetLayout(m_vk_device, vk_descriptor_set_layouts[set_index], nullptr);
+                }
+            }
+            vkDestroyPipelineLayout(m_vk_device, vk_pipeline_layout, nullptr);
+        };
 
         if (vkCreatePipelineLayout(m_vk_device, &pipeline_layout_info, nullptr, &vk_pipeline_layout) != VK_SUCCESS) 
         {
             Core::Logger::error("Failed to create pipeline layout");
+            vk_pipeline_layout = VK_NULL_HANDLE;
+            destroy_layouts();
+            return nullptr;
+        }
+
+        // Depth stencil
+        VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+        depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depth_stencil.depthTestEnable = pipeline_desc.raster_state.depth_test_enable ? VK_TRUE : VK_FALSE;
+        depth_stencil.depthWriteEnable = pipeline_desc.raster_state.depth_write_enable ? VK_TRUE : VK_FALSE;
+        depth_stencil.depthCompareOp = pipeline_desc.raster_state.depth_compare_op;
+        depth_stencil.depthBoundsTestEnable = VK_FALSE;
+        depth_stencil.minDepthBounds = 0.0f; // Optional
+        depth_stencil.maxDepthBounds = 1.0f; // Optional
+        depth_stencil.stencilTestEnable = VK_FALSE;
+        depth_stencil.front = {}; // Optional
+        depth_stencil.back = {}; // Optional
+
+        VkGraphicsPipelineCreateInfo pipeline_create_info{};
+        pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipeline_create_info.stageCount = 2;
+        pipeline_create_info.pStages = shaderStages;
+        pipeline_create_info.pVertexInputState = &vertex_input_info;
+        pipeline_create_info.pInputAssemblyState = &input_assembly;
+        pipeline_create_info.pViewportState = &viewportState;
+        pipeline_create_info.pRasterizationState = &rasterizer;
+        pipeline_create_info.pMultisampleState = &multisampling;
+        pipeline_create_info.pDepthStencilState = &depth_stencil; // Optional
+        pipeline_create_info.pColorBlendState = &color_blending;
+        pipeline_create_info.pDynamicState = &dynamic_state;        
+        pipeline_create_info.layout = vk_pipeline_layout;
+        pipeline_create_info.subpass = 0;
+        pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
+        pipeline_create_info.basePipelineIndex = -1; // Optional        
+        if(pipeline_desc.use_descriptor_buffer)
+        {
+            pipeline_create_info.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        }
+        if(is_identifier_only)
+        {
+            pipeline_create_info.flags |= VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT;
+        }
+
+        // Shader objects take the set layouts themselves, there is no render pass and no VkPipeline
+        if(pipeline_desc.use_shader_objects)
+        {
+            std::array<VkShaderEXT, 2> vk_shaders{};
+            if(createShaderObjects(pipeline_desc, vk_descriptor_set_layouts, vk_descriptor_set_bindings, bindless_set_index, vk_shaders) == false)
+            {
+                destroy_layouts();
+                return nullptr;
+            }
+
+            VkPipeline vk_pipeline = VK_NULL_HANDLE;
+            VkRenderPass vk_render_pass = VK_NULL_HANDLE;
+            Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline = Base::Interop::RawRef<Interface::RHI::IPipeline>::createAs<VulkanPipeline>(
+                std::move(vk_pipeline), 
+                std::move(vk_pipeline_layout), 
+                std::move(vk_descriptor_set_layouts),
+                std::move(vk_render_pass),
+                target_color_image_view->getExtent(),
+                pipeline_desc.push_constant_ranges,
+                std::move(vk_descriptor_set_bindings),
+                bindless_set_index,
+                pipeline_desc.use_descriptor_buffer
+            );
+            VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            vulkan_pipeline->m_vk_shaders = vk_shaders;
+            vulkan_pipeline->m_vk_topology = pipeline_desc.topology;
+            vulkan_pipeline->m_raster_state = pipeline_desc.raster_state;
+            vulkan_pipeline->m_vertex_layout = pipeline_desc.vertex_layout;
+
+            Core::Logger::trace("Vulkan shader object pipeline created");
+            return pipeline;
+        }
+
+        // Linked from shared parts without a render pass, then relinked optimized in the background
+        if(pipeline_desc.pipeline_library != nullptr)
+        {
+            VulkanPipelineLibrary& pipeline_library = *pipeline_desc.pipeline_library;
+            std::array<VkPipeline, VulkanPipelineLibrary::PART_TYPE_COUNT> vk_part_pipelines{};
+            if(createPipelineLibraryParts(pipeline_library, pipeline_desc, pipeline_create_info, vk_part_pipelines) == false)
+            {
+                destroy_layouts();
+                return nullptr;
+            }
+
+            VkPipelineCreateFlags vk_link_flags = pipeline_create_info.flags & VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+            bool is_fast_linking = m_vulkan_device_features.graphics_pipeline_library_properties.graphicsPipelineLibraryFastLinking == VK_TRUE;
+            VkPipeline vk_pipeline = VulkanPipelineLibrary::linkParts(m_vk_device, m_vk_pipeline_cache, vk_pipeline_layout, vk_part_pipelines, 
+                is_fast_linking ? vk_link_flags : vk_link_flags | VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT);
+            if(vk_pipeline == VK_NULL_HANDLE)
+            {
+                destroy_layouts();
+                return nullptr;
+            }
+
+            VkRenderPass vk_render_pass = VK_NULL_HANDLE;
+            Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline = Base::Interop::RawRef<Interface::RHI::IPipeline>::createAs<VulkanPipeline>(
+                std::move(vk_pipeline), 
+                std::move(vk_pipeline_layout), 
+                std::move(vk_descriptor_set_layouts),
+                std::move(vk_render_pass),
+                target_color_image_view->getExtent(),
+                pipeline_desc.push_constant_ranges,
+                std::move(vk_descriptor_set_bindings),
+                bindless_set_index,
+                pipeline_desc.use_descriptor_buffer
+            );
+            VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+            vulkan_pipeline->m_vk_topology = pipeline_desc.topology;
+            vulkan_pipeline->m_raster_state = pipeline_desc.raster_state;
+            vulkan_pipeline->m_vertex_layout = pipeline_desc.vertex_layout;
+
+            if(is_fast_linking)
+            {
+                // The layout outlives the job, destroyPipeline waits for it. Parts live as long as the library.
+                VkDevice vk_device = m_vk_device;
+                VkPipelineCache vk_pipeline_cache = m_vk_pipeline_cache;
+                VkPipelineLayout vk_linked_pipeline_layout = vulkan_pipeline->m_vk_pipeline_layout;
+                pipeline_library.queueOptimize(vulkan_pipeline, std::packaged_task<VkPipeline()>(
+                    [vk_device, vk_pipeline_cache, vk_linked_pipeline_layout, vk_part_pipelines, vk_link_flags]()
+                    {
+                        return VulkanPipelineLibrary::linkParts(vk_device, vk_pipeline_cache, vk_linked_pipeline_layout, vk_part_pipelines, vk_link_flags | VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT);
+                    }));
+            }
+
+            Core::Logger::trace("Vulkan library pipeline linked");
+            return pipeline;
         }
 
         // create render pass
         VkRenderPass vk_render_pass;
+        std::vector<VkImageLayout> vk_attachment_final_layouts;
         {
             Core::Logger::trace("create render pass");
             VkAttachmentDescription color_attachment{};
-            color_attachment.format = target_color_image_view->m_vulkan_image.m_vk_image_format;
+            color_attachment.format = target_color_image_view->m_vk_format;
             color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
             color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
             color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -576,7 +1216,7 @@ namespace Arieo
             color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
             VkAttachmentDescription depth_attachment{};
-            depth_attachment.format = target_depth_image_view->m_vulkan_image.m_vk_image_format;
+            depth_attachment.format = target_depth_image_view->m_vk_format;
             depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
             depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
             depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -608,6 +1248,7 @@ namespace Arieo
             dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;;        
 
             std::array<VkAttachmentDescription, 2> attachments = {color_attachment, depth_attachment};
+            vk_attachment_final_layouts = {color_attachment.finalLayout, depth_attachment.finalLayout};
             VkRenderPassCreateInfo render_pass_info{};
             render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
             render_pass_info.attachmentCount = attachments.size();
@@ -621,69 +1262,488 @@ namespace Arieo
             if (result != VK_SUCCESS) 
             {
                 Core::Logger::fatal("failed to create pipeline: {}", VulkanUtility::covertVkResultToString(result));
+                destroy_layouts();
                 return nullptr;
             }
             Core::Logger::trace("renderpass created");
         }
 
-        // Depth stencil
-        VkPipelineDepthStencilStateCreateInfo depth_stencil{};
-        depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        depth_stencil.depthTestEnable = VK_TRUE;
-        depth_stencil.depthWriteEnable = VK_TRUE;
-        depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
-        depth_stencil.depthBoundsTestEnable = VK_FALSE;
-        depth_stencil.minDepthBounds = 0.0f; // Optional
-        depth_stencil.maxDepthBounds = 1.0f; // Optional
-        depth_stencil.stencilTestEnable = VK_FALSE;
-        depth_stencil.front = {}; // Optional
-        depth_stencil.back = {}; // Optional
-
         // Create pipeline
-        VkGraphicsPipelineCreateInfo pipeline_create_info{};
-        pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipeline_create_info.stageCount = 2;
-        pipeline_create_info.pStages = shaderStages;
-        pipeline_create_info.pVertexInputState = &vertex_input_info;
-        pipeline_create_info.pInputAssemblyState = &input_assembly;
-        pipeline_create_info.pViewportState = &viewportState;
-        pipeline_create_info.pRasterizationState = &rasterizer;
-        pipeline_create_info.pMultisampleState = &multisampling;
-        pipeline_create_info.pDepthStencilState = &depth_stencil; // Optional
-        pipeline_create_info.pColorBlendState = &color_blending;
-        pipeline_create_info.pDynamicState = &dynamic_state;        
-        pipeline_create_info.layout = vk_pipeline_layout;
         pipeline_create_info.renderPass = vk_render_pass;
-        pipeline_create_info.subpass = 0;
-        pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
-        pipeline_create_info.basePipelineIndex = -1; // Optional        
+        VkPipeline vk_pipeline;
+        VkResult result = vkCreateGraphicsPipelines(m_vk_device, m_vk_pipeline_cache, 1, &pipeline_create_info, nullptr, &vk_pipeline);
+        if (result != VK_SUCCESS)
+        {
+            if (result == VK_PIPELINE_COMPILE_REQUIRED)
+            {
+                Core::Logger::error("Pipeline is not in the pipeline cache, its shaders have to be created from SPIR-V");
+            }
+            else
+            {
+                Core::Logger::fatal("failed to create pipeline: {}", VulkanUtility::covertVkResultToString(result));
+            }
+            vkDestroyRenderPass(m_vk_device, vk_render_pass, nullptr);
+            destroy_layouts();
+            return nullptr;
+        }
+
+        Core::Logger::trace("Vulkan pipeline created");
+        Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline = Base::Interop::RawRef<Interface::RHI::IPipeline>::createAs<VulkanPipeline>(
+            std::move(vk_pipeline), 
+            std::move(vk_pipeline_layout), 
+            std::move(vk_descriptor_set_layouts),
+            std::move(vk_render_pass),
+            target_color_image_view->getExtent(),
+            pipeline_desc.push_constant_ranges,
+            std::move(vk_descriptor_set_bindings),
+            bindless_set_index,
+            pipeline_desc.use_descriptor_buffer
+        );
+        // Values of the dynamic states, see VulkanCommandBuffer::bindPipeline
+        VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+        vulkan_pipeline->m_vk_attachment_final_layouts = std::move(vk_attachment_final_layouts);
+        vulkan_pipeline->m_vk_topology = pipeline_desc.topology;
+        vulkan_pipeline->m_raster_state = pipeline_desc.raster_state;
+        vulkan_pipeline->m_vertex_layout = pipeline_desc.vertex_layout;
+        return pipeline;
+    }
+
+    bool VulkanDevice::createShaderObjects(const VulkanGraphicsPipelineDesc& pipeline_desc, const std::vector<VkDescriptorSetLayout>& vk_descriptor_set_layouts, const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& vk_descriptor_set_bindings, std::uint32_t bindless_set_index, std::array<VkShaderEXT, 2>& vk_shaders)
+    {
+        std::array<VulkanShader*, 2> vulkan_shaders = {pipeline_desc.vert_shader.castToInstance<VulkanShader>(), pipeline_desc.frag_shader.castToInstance<VulkanShader>()};
+        std::array<const VulkanSpecialization*, 2> specializations = {&pipeline_desc.vert_specialization, &pipeline_desc.frag_specialization};
+        std::array<VkSpecializationInfo, 2> vk_specialization_infos = {pipeline_desc.vert_specialization.getInfo(), pipeline_desc.frag_specialization.getInfo()};
+        std::array<VkShaderStageFlagBits, 2> vk_stages = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
+
+        // Layouts are compared by their definition, every pipeline creates its own set layout handles.
+        // The bindless set layout is shared by all pipelines and compared by handle.
+        auto append_key = [](std::vector<std::uint8_t>& key, const void* bytes, size_t size)
+        {
+            key.insert(key.end(), static_cast<const std::uint8_t*>(bytes), static_cast<const std::uint8_t*>(bytes) + size);
+        };
+        std::vector<std::uint8_t> layout_key;
+        std::uint32_t layout_flags = pipeline_desc.use_descriptor_buffer ? 1 : 0;
+        append_key(layout_key, &layout_flags, sizeof(layout_flags));
+        for(std::uint32_t set_index = 0; set_index < vk_descriptor_set_layouts.size(); set_index++)
+        {
+            if(set_index == bindless_set_index)
+            {
+                append_key(layout_key, &vk_descriptor_set_layouts[set_index], sizeof(VkDescriptorSetLayout));
+                continue;
+            }
+            std::uint32_t binding_count = static_cast<std::uint32_t>(vk_descriptor_set_bindings[set_index].size());
+            append_key(layout_key, &binding_count, sizeof(binding_count));
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : vk_descriptor_set_bindings[set_index])
+            {
+                std::uint32_t binding_key[4] = {descriptor_binding.binding, static_cast<std::uint32_t>(descriptor_binding.descriptorType), descriptor_binding.descriptorCount, descriptor_binding.stageFlags};
+                append_key(layout_key, binding_key, sizeof(binding_key));
+                if(descriptor_binding.pImmutableSamplers != nullptr)
+                {
+                    append_key(layout_key, descriptor_binding.pImmutableSamplers, descriptor_binding.descriptorCount * sizeof(VkSampler));
+                }
+            }
+        }
+        std::uint32_t push_constant_range_count = static_cast<std::uint32_t>(pipeline_desc.push_constant_ranges.size());
+        append_key(layout_key, &push_constant_range_count, sizeof(push_constant_range_count));
+        append_key(layout_key, pipeline_desc.push_constant_ranges.data(), pipeline_desc.push_constant_ranges.size() * sizeof(VkPushConstantRange));
+
+        // Unlinked, so a stage can be bound next to any other stage created with a compatible layout
+        std::array<std::vector<std::uint8_t>, 2> shader_keys;
+        std::array<VkShaderCreateInfoEXT, 2> vk_shader_create_infos{};
+        std::array<size_t, 2> created_stage_indices{};
+        size_t created_count = 0;
+        for(size_t stage_index = 0; stage_index < vk_shader_create_infos.size(); stage_index++)
+        {
+            VulkanShader* vulkan_shader = vulkan_shaders[stage_index];
+            std::vector<std::uint8_t>& shader_key = shader_keys[stage_index];
+            std::uint32_t stage_key = static_cast<std::uint32_t>(vk_stages[stage_index]);
+            append_key(shader_key, &stage_key, sizeof(stage_key));
+            VulkanUtility::Digest code_digest = VulkanUtility::computeDigest(vulkan_shader->m_code.data(), vulkan_shader->m_code.size() * sizeof(std::uint32_t));
+            append_key(shader_key, code_digest.data(), code_digest.size());
+            const std::string& entry_point = vulkan_shader->m_reflection.entry_point;
+            append_key(shader_key, entry_point.c_str(), entry_point.size() + 1);
+            specializations[stage_index]->appendKey(shader_key);
+            shader_key.insert(shader_key.end(), layout_key.begin(), layout_key.end());
+
+            vk_shaders[stage_index] = m_shader_object_cache.acquire(shader_key);
+            if(vk_shaders[stage_index] != VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            VkShaderCreateInfoEXT& vk_shader_create_info = vk_shader_create_infos[created_count];
+            vk_shader_create_info.sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT;
+            vk_shader_create_info.stage = vk_stages[stage_index];
+            vk_shader_create_info.nextStage = vk_stages[stage_index] == VK_SHADER_STAGE_VERTEX_BIT ? VK_SHADER_STAGE_FRAGMENT_BIT : 0;
+            vk_shader_create_info.codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT;
+            vk_shader_create_info.codeSize = vulkan_shader->m_code.size() * sizeof(std::uint32_t);
+            vk_shader_create_info.pCode = vulkan_shader->m_code.data();
+            vk_shader_create_info.pName = entry_point.c_str();
+            vk_shader_create_info.setLayoutCount = static_cast<uint32_t>(vk_descriptor_set_layouts.size());
+            vk_shader_create_info.pSetLayouts = vk_descriptor_set_layouts.data();
+            vk_shader_create_info.pushConstantRangeCount = push_constant_range_count;
+            vk_shader_create_info.pPushConstantRanges = pipeline_desc.push_constant_ranges.data();
+            if(specializations[stage_index]->empty() == false)
+            {
+                vk_shader_create_info.pSpecializationInfo = &vk_specialization_infos[stage_index];
+            }
+            created_stage_indices[created_count++] = stage_index;
+        }
+        if(created_count == 0)
+        {
+            return true;
+        }
+
+        std::array<VkShaderEXT, 2> vk_created_shaders{};
+        VkResult result = m_vulkan_device_features.vk_create_shaders(m_vk_device, static_cast<uint32_t>(created_count), vk_shader_create_infos.data(), nullptr, vk_created_shaders.data());
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Failed to create shader objects: {}", VulkanUtility::covertVkResultToString(result));
+            // Stages created before the failing one are returned and have to be destroyed
+            for(VkShaderEXT vk_shader : vk_created_shaders)
+            {
+                if(vk_shader != VK_NULL_HANDLE)
+                {
+                    m_vulkan_device_features.vk_destroy_shader(m_vk_device, vk_shader, nullptr);
+                }
+            }
+            for(VkShaderEXT& vk_shader : vk_shaders)
+            {
+                if(vk_shader != VK_NULL_HANDLE && m_shader_object_cache.release(vk_shader))
+                {
+                    m_vulkan_device_features.vk_destroy_shader(m_vk_device, vk_shader, nullptr);
+                }
+                vk_shader = VK_NULL_HANDLE;
+            }
+            return false;
+        }
+
+        for(size_t created_index = 0; created_index < created_count; created_index++)
+        {
+            size_t stage_index = created_stage_indices[created_index];
+            vk_shaders[stage_index] = m_shader_object_cache.add(std::move(shader_keys[stage_index]), vk_created_shaders[created_index]);
+            if(vk_shaders[stage_index] != vk_created_shaders[created_index])
+            {
+                // Another thread cached the same stage first
+                m_vulkan_device_features.vk_destroy_shader(m_vk_device, vk_created_shaders[created_index], nullptr);
+            }
+        }
+        return true;
+    }
+
+    bool VulkanDevice::createPipelineLibraryParts(VulkanPipelineLibrary& pipeline_library, const VulkanGraphicsPipelineDesc& pipeline_desc, const VkGraphicsPipelineCreateInfo& pipeline_create_info, std::array<VkPipeline, VulkanPipelineLibrary::PART_TYPE_COUNT>& vk_part_pipelines)
+    {
+        VulkanImageView* target_color_image_view = pipeline_desc.target_color_attachment.castToInstance<VulkanImageView>();
+        VulkanImageView* target_depth_image_view = pipeline_desc.target_depth_attachment.castToInstance<VulkanImageView>();
+
+        // Attachment formats take the place of the render pass, see VulkanCommandBuffer::beginRendering
+        VkFormat vk_color_format = target_color_image_view->m_vk_format;
+        VkPipelineRenderingCreateInfo rendering_info{};
+        rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        rendering_info.colorAttachmentCount = 1;
+        rendering_info.pColorAttachmentFormats = &vk_color_format;
+        if(target_depth_image_view != nullptr)
+        {
+            rendering_info.depthAttachmentFormat = target_depth_image_view->m_vk_format;
+            if(target_depth_image_view->m_vk_format == VK_FORMAT_D32_SFLOAT_S8_UINT
+            || target_depth_image_view->m_vk_format == VK_FORMAT_D24_UNORM_S8_UINT
+            || target_depth_image_view->m_vk_format == VK_FORMAT_D16_UNORM_S8_UINT)
+            {
+                rendering_info.stencilAttachmentFormat = target_depth_image_view->m_vk_format;
+            }
+        }
+
+        // Parts are linked without independent sets, the shader parts need identically defined layouts
+        std::vector<std::uint8_t> layout_key;
+        VulkanPipelineLibrary::appendKey(layout_key, static_cast<std::uint32_t>(pipeline_desc.descriptor_set_layouts.size()));
+        for(const std::vector<VkDescriptorSetLayoutBinding>& descriptor_bindings : pipeline_desc.descriptor_set_layouts)
+        {
+            VulkanPipelineLibrary::appendKey(layout_key, static_cast<std::uint32_t>(descriptor_bindings.size()));
+            for(const VkDescriptorSetLayoutBinding& descriptor_binding : descriptor_bindings)
+            {
+                VulkanPipelineLibrary::appendKey(layout_key, descriptor_binding.binding);
+                VulkanPipelineLibrary::appendKey(layout_key, descriptor_binding.descriptorType);
+                VulkanPipelineLibrary::appendKey(layout_key, descriptor_binding.descriptorCount);
+                VulkanPipelineLibrary::appendKey(layout_key, descriptor_binding.stageFlags);
+                if(descriptor_binding.pImmutableSamplers != nullptr)
+                {
+                    for(std::uint32_t sampler_index = 0; sampler_index < descriptor_binding.descriptorCount; sampler_index++)
+                    {
+                        VulkanPipelineLibrary::appendKey(layout_key, descriptor_binding.pImmutableSamplers[sampler_index]);
+                    }
+                }
+            }
+        }
+        VulkanPipelineLibrary::appendKey(layout_key, static_cast<std::uint32_t>(pipeline_desc.push_constant_ranges.size()));
+        for(const VkPushConstantRange& push_constant_range : pipeline_desc.push_constant_ranges)
+        {
+            VulkanPipelineLibrary::appendKey(layout_key, push_constant_range);
+        }
+        VulkanPipelineLibrary::appendKey(layout_key, pipeline_desc.use_bindless_heap);
+
+        // Module identifiers are unique per module, without them the shader cache key is used
+        auto append_shader_key = [](std::vector<std::uint8_t>& key, const VulkanShader* vulkan_shader, const VulkanSpecialization& specialization)
+        {
+            if(vulkan_shader->m_module_identifier.empty() == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, static_cast<std::uint8_t>(1));
+                VulkanPipelineLibrary::appendKey(key, static_cast<std::uint32_t>(vulkan_shader->m_module_identifier.size()));
+                key.insert(key.end(), vulkan_shader->m_module_identifier.begin(), vulkan_shader->m_module_identifier.end());
+            }
+            else if(vulkan_shader->m_is_cached)
+            {
+                VulkanPipelineLibrary::appendKey(key, static_cast<std::uint8_t>(2));
+                VulkanPipelineLibrary::appendKey(key, vulkan_shader->m_code_digest);
+            }
+            else
+            {
+                Core::Logger::error("Shader is not in the shader module cache, it cannot be used with a pipeline library");
+                return false;
+            }
+            const std::string& entry_point = vulkan_shader->m_reflection.entry_point;
+            key.insert(key.end(), entry_point.c_str(), entry_point.c_str() + entry_point.size() + 1);
+            specialization.appendKey(key);
+            return true;
+        };
+
+        // States the parts leave dynamic are not part of their keys, parts differing only in them are shared
+        const VulkanDeviceFeatures& features = m_vulkan_device_features;
+        std::array<std::vector<std::uint8_t>, VulkanPipelineLibrary::PART_TYPE_COUNT> part_keys;
+        // Every part is created with the pipeline's flags, e.g. the descriptor buffer bit, and links only with parts
+        // created with the same flags
+        for(std::vector<std::uint8_t>& key : part_keys)
+        {
+            VulkanPipelineLibrary::appendKey(key, pipeline_create_info.flags);
+        }
+        {
+            std::vector<std::uint8_t>& key = part_keys[VulkanPipelineLibrary::VERTEX_INPUT];
+            if(features.vertex_input_dynamic_state == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, static_cast<std::uint32_t>(pipeline_desc.vertex_layout.bindings.size()));
+                for(const VkVertexInputBindingDescription& binding_desc : pipeline_desc.vertex_layout.bindings)
+                {
+                    VulkanPipelineLibrary::appendKey(key, binding_desc);
+                }
+                VulkanPipelineLibrary::appendKey(key, static_cast<std::uint32_t>(pipeline_desc.vertex_layout.attributes.size()));
+                for(const VkVertexInputAttributeDescription& attribute_desc : pipeline_desc.vertex_layout.attributes)
+                {
+                    VulkanPipelineLibrary::appendKey(key, attribute_desc);
+                }
+            }
+            // A dynamic topology has to stay in the class of the pipeline's: points, lines, triangles or patches
+            VulkanPipelineLibrary::appendKey(key, features.extended_dynamic_state 
+                ? VulkanPipelineLibrary::getTopologyClass(pipeline_desc.topology) 
+                : static_cast<std::uint32_t>(pipeline_desc.topology));
+            if(features.extended_dynamic_state2 == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.primitive_restart_enable);
+            }
+        }
+        {
+            std::vector<std::uint8_t>& key = part_keys[VulkanPipelineLibrary::PRE_RASTERIZATION];
+            if(append_shader_key(key, pipeline_desc.vert_shader.castToInstance<VulkanShader>(), pipeline_desc.vert_specialization) == false)
+            {
+                return false;
+            }
+            key.insert(key.end(), layout_key.begin(), layout_key.end());
+            if(features.extended_dynamic_state3 == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.polygon_mode);
+            }
+            if(features.extended_dynamic_state == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.cull_mode);
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.front_face);
+            }
+            if(features.extended_dynamic_state2 == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.rasterizer_discard_enable);
+            }
+        }
+        {
+            std::vector<std::uint8_t>& key = part_keys[VulkanPipelineLibrary::FRAGMENT_SHADER];
+            if(append_shader_key(key, pipeline_desc.frag_shader.castToInstance<VulkanShader>(), pipeline_desc.frag_specialization) == false)
+            {
+                return false;
+            }
+            key.insert(key.end(), layout_key.begin(), layout_key.end());
+            if(features.extended_dynamic_state == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.depth_test_enable);
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.depth_write_enable);
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.depth_compare_op);
+            }
+        }
+        {
+            std::vector<std::uint8_t>& key = part_keys[VulkanPipelineLibrary::FRAGMENT_OUTPUT];
+            VulkanPipelineLibrary::appendKey(key, rendering_info.pColorAttachmentFormats[0]);
+            VulkanPipelineLibrary::appendKey(key, rendering_info.depthAttachmentFormat);
+            VulkanPipelineLibrary::appendKey(key, rendering_info.stencilAttachmentFormat);
+            if(features.extended_dynamic_state3 == false)
+            {
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.blend_enable);
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.blend_equation);
+                VulkanPipelineLibrary::appendKey(key, pipeline_desc.raster_state.color_write_mask);
+            }
+        }
+
+        std::array<VkGraphicsPipelineLibraryFlagsEXT, VulkanPipelineLibrary::PART_TYPE_COUNT> vk_part_flags = {
+            VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+            VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+            VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+            VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+        };
+        for(size_t part_index = 0; part_index < part_keys.size(); part_index++)
+        {
+            auto& part_map = pipeline_library.m_part_maps[part_index];
+            {
+                std::lock_guard<std::mutex> lock(pipeline_library.m_part_mutex);
+                auto found_iter = part_map.find(part_keys[part_index]);
+                if(found_iter != part_map.end())
+                {
+                    pipeline_library.m_hit_count++;
+                    vk_part_pipelines[part_index] = found_iter->second;
+                    continue;
+                }
+                pipeline_library.m_miss_count++;
+            }
+
+            // The create info carries the whole state, each part only reads its own subset
+            VkGraphicsPipelineLibraryCreateInfoEXT library_info{};
+            library_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+            library_info.pNext = &rendering_info;
+            library_info.flags = vk_part_flags[part_index];
+
+            bool is_shader_part = part_index == VulkanPipelineLibrary::PRE_RASTERIZATION || part_index == VulkanPipelineLibrary::FRAGMENT_SHADER;
+            VkGraphicsPipelineCreateInfo part_create_info = pipeline_create_info;
+            part_create_info.pNext = &library_info;
+            part_create_info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+            part_create_info.stageCount = is_shader_part ? 1 : 0;
+            part_create_info.pStages = is_shader_part ? &pipeline_create_info.pStages[part_index == VulkanPipelineLibrary::PRE_RASTERIZATION ? 0 : 1] : nullptr;
+            part_create_info.layout = is_shader_part ? pipeline_create_info.layout : VK_NULL_HANDLE;
+            part_create_info.renderPass = VK_NULL_HANDLE;
+
+            VkPipeline vk_part_pipeline;
+            VkResult result = vkCreateGraphicsPipelines(m_vk_device, m_vk_pipeline_cache, 1, &part_create_info, nullptr, &vk_part_pipeline);
+            if(result == VK_PIPELINE_COMPILE_REQUIRED)
+            {
+                Core::Logger::error("Pipeline library part is not in the pipeline cache, its shaders have to be created from SPIR-V");
+                return false;
+            }
+            if(result != VK_SUCCESS)
+            {
+                Core::Logger::error("Failed to create pipeline library part {}: {}", part_index, VulkanUtility::covertVkResultToString(result));
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(pipeline_library.m_part_mutex);
+            auto [found_iter, is_inserted] = part_map.try_emplace(std::move(part_keys[part_index]), vk_part_pipeline);
+            if(is_inserted == false)
+            {
+                // Another thread built the same part meanwhile
+                vkDestroyPipeline(m_vk_device, vk_part_pipeline, nullptr);
+            }
+            vk_part_pipelines[part_index] = found_iter->second;
+        }
+        return true;
+    }
+
+    VulkanPipelineLibrary* VulkanDevice::createPipelineLibrary(std::uint32_t frame_count)
+    {
+        if(m_vulkan_device_features.graphics_pipeline_library == false)
+        {
+            Core::Logger::error("Graphics pipeline libraries are not supported by the device");
+            return nullptr;
+        }
+        Core::Logger::trace("Pipeline library created {} frames, fast linking {}", frame_count, 
+            m_vulkan_device_features.graphics_pipeline_library_properties.graphicsPipelineLibraryFastLinking == VK_TRUE);
+        return Base::newT<VulkanPipelineLibrary>(m_vk_device, std::max(frame_count, 1u));
+    }
 
-        VkPipeline vk_pipeline;
-        VkResult result = vkCreateGraphicsPipelines(m_vk_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &vk_pipeline);
-        if (result != VK_SUCCESS)
+    void VulkanDevice::destroyPipelineLibrary(VulkanPipelineLibrary* pipeline_library)
+    {
+        Base::deleteT(pipeline_library);
+    }
+
+    VulkanPipelineVariants* VulkanDevice::createPipelineVariants(const VulkanGraphicsPipelineDesc& base_desc)
+    {
+        return Base::newT<VulkanPipelineVariants>(base_desc);
+    }
+
+    void VulkanDevice::destroyPipelineVariants(VulkanPipelineVariants* pipeline_variants)
+    {
+        for(auto& [key, pipeline] : pipeline_variants->m_pipeline_map)
+        {
+            destroyPipeline(pipeline);
+        }
+        Base::deleteT(pipeline_variants);
+    }
+
+    Base::Interop::RawRef<Interface::RHI::IPipeline> VulkanDevice::getPipelineVariant(VulkanPipelineVariants* pipeline_variants, const VulkanSpecialization& vert_specialization, const VulkanSpecialization& frag_specialization)
+    {
+        std::vector<std::uint8_t> key = VulkanPipelineVariants::getKey(vert_specialization, frag_specialization);
+        {
+            std::lock_guard<std::mutex> lock(pipeline_variants->m_variant_mutex);
+            auto found_iter = pipeline_variants->m_pipeline_map.find(key);
+            if(found_iter != pipeline_variants->m_pipeline_map.end())
+            {
+                pipeline_variants->m_hit_count++;
+                return found_iter->second;
+            }
+            pipeline_variants->m_miss_count++;
+        }
+
+        // Compiled outside the lock so other variants of the set are not held up
+        VulkanGraphicsPipelineDesc variant_desc = pipeline_variants->m_base_desc;
+        variant_desc.vert_specialization = vert_specialization;
+        variant_desc.frag_specialization = frag_specialization;
+        Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline = createPipeline(variant_desc);
+        if(pipeline.castToInstance<VulkanPipeline>() == nullptr)
         {
-            Core::Logger::fatal("failed to create pipeline: {}", VulkanUtility::covertVkResultToString(result));
             return nullptr;
         }
 
-        Core::Logger::trace("Vulkan pipeline created");
-        return Base::Interop::RawRef<Interface::RHI::IPipeline>::createAs<VulkanPipeline>(
-            std::move(vk_pipeline), 
-            std::move(vk_pipeline_layout), 
-            std::move(vk_descriptor_set_layout),
-            std::move(vk_render_pass),
-            target_color_image_view->m_vulkan_image.m_vk_image_extent
-        );
+        std::lock_guard<std::mutex> lock(pipeline_variants->m_variant_mutex);
+        auto [found_iter, is_inserted] = pipeline_variants->m_pipeline_map.try_emplace(std::move(key), pipeline);
+        if(is_inserted == false)
+        {
+            // Another thread created the same variant meanwhile
+            destroyPipeline(pipeline);
+        }
+        return found_iter->second;
     }
 
     void VulkanDevice::destroyPipeline(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline)
     {
         VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
 
-        vkDestroyDescriptorSetLayout(m_vk_device, vulkan_pipeline->m_vk_descriptor_set_layout, nullptr);
+        // A pending optimized link uses the pipeline layout
+        if(vulkan_pipeline->m_pipeline_library != nullptr)
+        {
+            VkPipeline vk_optimized_pipeline = vulkan_pipeline->m_pipeline_library->cancelOptimize(vulkan_pipeline);
+            if(vk_optimized_pipeline != VK_NULL_HANDLE)
+            {
+                vkDestroyPipeline(m_vk_device, vk_optimized_pipeline, nullptr);
+            }
+        }
+
+        for(std::uint32_t set_index = 0; set_index < vulkan_pipeline->m_vk_descriptor_set_layouts.size(); set_index++)
+        {
+            if(set_index != vulkan_pipeline->m_bindless_set_index)
+            {
+                vkDestroyDescriptorSetLayout(m_vk_device, vulkan_pipeline->m_vk_descriptor_set_layouts[set_index], nullptr);
+            }
+        }
         vkDestroyRenderPass(m_vk_device, vulkan_pipeline->m_vk_render_pass, nullptr);
         vkDestroyPipelineLayout(m_vk_device, vulkan_pipeline->m_vk_pipeline_layout, nullptr);
         vkDestroyPipeline(m_vk_device, vulkan_pipeline->m_vk_pipeline, nullptr);
+        for(VkShaderEXT vk_shader : vulkan_pipeline->m_vk_shaders)
+        {
+            if(vk_shader != VK_NULL_HANDLE && m_shader_object_cache.release(vk_shader))
+            {
+                m_vulkan_device_features.vk_destroy_shader(m_vk_device, vk_shader, nullptr);
+            }
+        }
 
         Base::Interop::RawRef<Interface::RHI::IPipeline>::destroyAs<VulkanPipeline>(std::move(pipeline));
     }
@@ -743,6 +1803,12 @@ namespace Arieo
         buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         buffer_info.size = size;
         buffer_info.usage = Base::mapEnum<VkBufferUsageFlagBits>(buffer_usage);
+        if(m_is_descriptor_buffer_enabled
+        && (buffer_info.usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) != 0)
+        {
+            // Descriptor buffer descriptors reference buffers by device address
+            buffer_info.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+        }
         //buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
         VmaAllocationCreateInfo alloc_info{};
@@ -758,23 +1824,44 @@ namespace Arieo
             Core::Logger::error("Create buffer failed: {}", VulkanUtility::covertVkResultToString(result));
         }
         Core::Logger::trace("Buffer created {}", size);
-        return Base::Interop::RawRef<Interface::RHI::IBuffer>::createAs<VulkanBuffer>(std::move(vk_buffer), m_vma_allocator, std::move(vma_allocation));
+        Base::Interop::RawRef<Interface::RHI::IBuffer> buffer = Base::Interop::RawRef<Interface::RHI::IBuffer>::createAs<VulkanBuffer>(std::move(vk_buffer), m_vma_allocator, std::move(vma_allocation));
+        if(m_bindless_heap != nullptr && (buffer_info.usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0)
+        {
+            buffer.castToInstance<VulkanBuffer>()->m_bindless_index = m_bindless_heap->registerBuffer(buffer);
+        }
+        return buffer;
     }
 
     void VulkanDevice::destroyBuffer(Base::Interop::RawRef<Interface::RHI::IBuffer> buffer)
     {
         VulkanBuffer* vulkan_buffer = buffer.castToInstance<VulkanBuffer>();
+        m_descriptor_set_cache.invalidateBuffer(vulkan_buffer->m_vk_buffer);
+        if(vulkan_buffer->m_bindless_index != VulkanBindlessHeap::INVALID_INDEX)
+        {
+            m_bindless_heap->unregisterBuffer(vulkan_buffer->m_bindless_index);
+        }
         vmaDestroyBuffer(m_vma_allocator, vulkan_buffer->m_vk_buffer, vulkan_buffer->m_vma_allocation);
         Base::Interop::RawRef<Interface::RHI::IBuffer>::destroyAs<VulkanBuffer>(std::move(buffer));
     }
 
     Base::Interop::RawRef<Interface::RHI::IDescriptorPool> VulkanDevice::createDescriptorPool(size_t capacity)
     {
-        std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+        if(m_is_descriptor_buffer_enabled)
+        {
+            return createDescriptorBufferPool(capacity);
+        }
+
+        std::array<VkDescriptorPoolSize, 5> pool_sizes{};
         pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         pool_sizes[0].descriptorCount = static_cast<uint32_t>(capacity);
         pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         pool_sizes[1].descriptorCount = static_cast<uint32_t>(capacity);
+        pool_sizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        pool_sizes[2].descriptorCount = static_cast<uint32_t>(capacity);
+        pool_sizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[3].descriptorCount = static_cast<uint32_t>(capacity);
+        pool_sizes[4].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        pool_sizes[4].descriptorCount = static_cast<uint32_t>(capacity);
 
         VkDescriptorPoolCreateInfo pool_info{};
         pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -786,7 +1873,8 @@ namespace Arieo
         VkResult result = vkCreateDescriptorPool(m_vk_device, &pool_info, nullptr, &descriptor_pool);
         if (result != VK_SUCCESS) 
         {
-            Core::Logger::error("Create descriptor failed failed: {}", VulkanUtility::covertVkResultToString(result));
+            Core::Logger::error("Create descriptor pool failed: {}", VulkanUtility::covertVkResultToString(result));
+            return nullptr;
         }
         Core::Logger::trace("Descriptor Pool created {}", capacity);
 
@@ -796,8 +1884,71 @@ namespace Arieo
         );
     }
 
+    Base::Interop::RawRef<Interface::RHI::IDescriptorPool> VulkanDevice::createDescriptorBufferPool(size_t capacity)
+    {
+        // Room for capacity sets of up to MAX_DESCRIPTORS_PER_SET descriptors of the largest supported kind
+        constexpr VkDeviceSize MAX_DESCRIPTORS_PER_SET = 16;
+        const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties = m_vulkan_device_features.descriptor_buffer_properties;
+        VkDeviceSize descriptor_size = std::max({
+            properties.uniformBufferDescriptorSize,
+            properties.storageBufferDescriptorSize,
+            properties.combinedImageSamplerDescriptorSize
+        });
+        VkDeviceSize alignment = properties.descriptorBufferOffsetAlignment;
+        VkDeviceSize buffer_size = (capacity * MAX_DESCRIPTORS_PER_SET * descriptor_size + alignment - 1) / alignment * alignment;
+
+        VkBufferCreateInfo buffer_info{};
+        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_info.size = buffer_size;
+        buffer_info.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT
+            | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+        // Written by the host only, persistently mapped and coherent so set writes need no flush
+        VmaAllocationCreateInfo alloc_info{};
+        alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+        alloc_info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        VkBuffer vk_buffer;
+        VmaAllocation vma_allocation;
+        VmaAllocationInfo vma_allocation_info;
+        VkResult result = vmaCreateBuffer(m_vma_allocator, &buffer_info, &alloc_info, &vk_buffer, &vma_allocation, &vma_allocation_info);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Create descriptor buffer failed: {}", VulkanUtility::covertVkResultToString(result));
+            return nullptr;
+        }
+
+        VkBufferDeviceAddressInfo address_info{};
+        address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        address_info.buffer = vk_buffer;
+        VkDeviceAddress vk_descriptor_buffer_address = vkGetBufferDeviceAddress(m_vk_device, &address_info);
+        std::uint8_t* mapped_ptr = static_cast<std::uint8_t*>(vma_allocation_info.pMappedData);
+
+        Core::Logger::trace("Descriptor buffer pool created {} bytes", buffer_size);
+        return Base::Interop::RawRef<Interface::RHI::IDescriptorPool>::createAs<VulkanDescriptorBufferPool>(
+            m_vk_device,
+            m_vulkan_device_features,
+            Base::Interop::RawRef<Interface::RHI::IBuffer>::createAs<VulkanBuffer>(std::move(vk_buffer), m_vma_allocator, std::move(vma_allocation)),
+            vk_descriptor_buffer_address,
+            mapped_ptr,
+            buffer_size
+        );
+    }
+
     void VulkanDevice::destroyDescriptorPool(Base::Interop::RawRef<Interface::RHI::IDescriptorPool> descriptor_pool)
     {
+        if(m_is_descriptor_buffer_enabled)
+        {
+            VulkanDescriptorBufferPool* vulkan_descriptor_buffer_pool = descriptor_pool.castToInstance<VulkanDescriptorBufferPool>();
+            VulkanBuffer* vulkan_buffer = vulkan_descriptor_buffer_pool->m_descriptor_buffer.castToInstance<VulkanBuffer>();
+            vmaDestroyBuffer(m_vma_allocator, vulkan_buffer->m_vk_buffer, vulkan_buffer->m_vma_allocation);
+            Base::Interop::RawRef<Interface::RHI::IBuffer>::destroyAs<VulkanBuffer>(std::move(vulkan_descriptor_buffer_pool->m_descriptor_buffer));
+            Base::Interop::RawRef<Interface::RHI::IDescriptorPool>::destroyAs<VulkanDescriptorBufferPool>(std::move(descriptor_pool));
+            return;
+        }
+
         VulkanDescriptorPool* vulkan_descriptor_pool = descriptor_pool.castToInstance<VulkanDescriptorPool>();
         vkDestroyDescriptorPool(m_vk_device, vulkan_descriptor_pool->m_vk_descriptor_pool, nullptr);
         Base::Interop::RawRef<Interface::RHI::IDescriptorPool>::destroyAs<VulkanDescriptorPool>(std::move(descriptor_pool));
@@ -812,34 +1963,129 @@ namespace Arieo
         Interface::RHI::ImageUsageFlags usage,
         Interface::RHI::MemoryUsage mem_usage)
     {
-        Core::Logger::trace("Prepare for creating image {}x{}", width, height);
+        VulkanImageCreateInfo image_info;
+        image_info.width = width;
+        image_info.height = height;
+        image_info.format = format;
+        image_info.aspect = aspect;
+        image_info.tiling = tiling;
+        image_info.usage = usage;
+        image_info.memory_usage = mem_usage;
+        return createImage(image_info);
+    }
+
+    Base::Interop::RawRef<Interface::RHI::IImage> VulkanDevice::createImage(const VulkanImageCreateInfo& image_info)
+    {
+        Core::Logger::trace("Prepare for creating image {}x{}x{} mips {} layers {}", image_info.width, image_info.height, image_info.depth, image_info.mip_levels, image_info.array_layers);
         VkImageCreateInfo image_create_info = {};
         image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        image_create_info.imageType = VK_IMAGE_TYPE_2D;
-        image_create_info.format = Base::mapEnum<VkFormat>(format);
+        image_create_info.imageType = image_info.image_type;
+        image_create_info.format = Base::mapEnum<VkFormat>(image_info.format);
 
-        image_create_info.extent = {width, height, 1};
-        image_create_info.mipLevels = 1;
-        image_create_info.arrayLayers = 1;
+        image_create_info.extent = {image_info.width, image_info.height, image_info.depth};
+        image_create_info.mipLevels = image_info.mip_levels;
+        image_create_info.arrayLayers = image_info.array_layers;
         
-        image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
-        image_create_info.tiling = Base::mapEnum<VkImageTiling>(tiling);
+        image_create_info.samples = image_info.samples;
+        image_create_info.tiling = Base::mapEnum<VkImageTiling>(image_info.tiling);
 
         //image_create_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-        image_create_info.usage = Base::mapEnum<VkImageUsageFlags>(usage);
+        image_create_info.usage = Base::mapEnum<VkImageUsageFlags>(image_info.usage);
 
         image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
+        // Views with other formats need a mutable format image, the format list lets drivers keep compression
+        VkImageFormatListCreateInfo vk_format_list_info{};
+        std::vector<VkFormat> vk_format_list;
+        if(image_info.view_formats.empty() == false)
+        {
+            image_create_info.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+            if(m_vulkan_device_features.api_version >= VK_API_VERSION_1_2)
+            {
+                vk_format_list.emplace_back(image_create_info.format);
+                vk_format_list.insert(vk_format_list.end(), image_info.view_formats.begin(), image_info.view_formats.end());
+
+                vk_format_list_info.sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO;
+                vk_format_list_info.viewFormatCount = static_cast<uint32_t>(vk_format_list.size());
+                vk_format_list_info.pViewFormats = vk_format_list.data();
+                image_create_info.pNext = &vk_format_list_info;
+            }
+        }
+
+        // Select view type and validate the shape
+        VkImageViewType vk_image_view_type = VK_IMAGE_VIEW_TYPE_2D;
+        {
+            if(image_info.mip_levels == 0 || image_info.array_layers == 0)
+            {
+                Core::Logger::error("Image needs at least one mip level and one array layer");
+                return nullptr;
+            }
+
+            switch(image_info.image_type)
+            {
+                case VK_IMAGE_TYPE_1D:
+                    vk_image_view_type = image_info.array_layers > 1 ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+                    break;
+                case VK_IMAGE_TYPE_3D:
+                    if(image_info.array_layers != 1)
+                    {
+                        Core::Logger::error("3D image cannot have array layers");
+                        return nullptr;
+                    }
+                    vk_image_view_type = VK_IMAGE_VIEW_TYPE_3D;
+                    break;
+                default:
+                    vk_image_view_type = image_info.array_layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+                    break;
+            }
+
+            if(image_info.is_cube)
+            {
+                if(image_info.image_type != VK_IMAGE_TYPE_2D || image_info.width != image_info.height || image_info.array_layers % 6 != 0)
+                {
+                    Core::Logger::error("Cube image must be square 2D with a multiple of 6 layers");
+                    return nullptr;
+                }
+                image_create_info.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+                vk_image_view_type = image_info.array_layers > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+            }
+
+            if(image_info.samples != VK_SAMPLE_COUNT_1_BIT && (image_info.image_type != VK_IMAGE_TYPE_2D || image_info.mip_levels != 1 || image_info.is_cube))
+            {
+                Core::Logger::error("Multisampled image must be 2D with a single mip level");
+                return nullptr;
+            }
+
+            VkImageFormatProperties vk_image_format_properties;
+            VkResult result = vkGetPhysicalDeviceImageFormatProperties(
+                m_vk_phys_device,
+                image_create_info.format,
+                image_create_info.imageType,
+                image_create_info.tiling,
+                image_create_info.usage,
+                image_create_info.flags,
+                &vk_image_format_properties
+            );
+            if(result != VK_SUCCESS
+            || image_info.mip_levels > vk_image_format_properties.maxMipLevels
+            || image_info.array_layers > vk_image_format_properties.maxArrayLayers
+            || (vk_image_format_properties.sampleCounts & image_info.samples) == 0)
+            {
+                Core::Logger::error("Image format {} does not support the requested shape: {}", (std::uint32_t)image_create_info.format, VulkanUtility::covertVkResultToString(result));
+                return nullptr;
+            }
+        }
+
         // Allocation create info
         VmaAllocationCreateInfo mem_alloc_info = {};
-        mem_alloc_info.usage = Base::mapEnum<VmaMemoryUsage>(mem_usage); // Memory will be only on GPU
+        mem_alloc_info.usage = Base::mapEnum<VmaMemoryUsage>(image_info.memory_usage); // Memory will be only on GPU
 
         VkImage vk_image;
         VmaAllocation vk_image_allocation;
         VmaAllocationInfo vk_image_allocation_info;
 
-        Core::Logger::trace("Creating image {}x{}", width, height);
+        Core::Logger::trace("Creating image {}x{}", image_info.width, image_info.height);
         VkResult result = vmaCreateImage(
             m_vma_allocator,
             &image_create_info,
@@ -854,39 +2100,9 @@ namespace Arieo
             return nullptr;
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(m_vk_device, vk_image, &memRequirements);
+        VkImageAspectFlags vk_aspect_mask = Base::mapEnum<VkImageAspectFlags>(image_info.aspect);
 
-        // Create Image View
-        Core::Logger::trace("Creating image view for image");
-        VkImageView vk_image_view;
-        {
-            VkImageViewCreateInfo view_info{};
-            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-            view_info.image = vk_image;
-            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            view_info.format = image_create_info.format;
-            
-            //view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            view_info.subresourceRange.aspectMask = Base::mapEnum<VkImageAspectFlags>(aspect);
-
-            view_info.subresourceRange.baseMipLevel = 0;
-            view_info.subresourceRange.levelCount = 1;
-            view_info.subresourceRange.baseArrayLayer = 0;
-            view_info.subresourceRange.layerCount = 1;
-
-            VkResult result = vkCreateImageView(
-                m_vk_device,
-                &view_info,
-                nullptr,
-                &vk_image_view
-            );
-            if(result != VK_SUCCESS)
-            {
-                Core::Logger::error("ImageView create failed: {}", VulkanUtility::covertVkResultToString(result));
-                return nullptr;
-            }
-        };
+        // Image views are created on demand by VulkanImage::getImageView
 
         // Create Sampler
         Core::Logger::trace("Creating image sampler for image");
@@ -897,9 +2113,10 @@ namespace Arieo
             sampler_create_info.magFilter = VK_FILTER_LINEAR;
             sampler_create_info.minFilter = VK_FILTER_LINEAR;
 
-            sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            VkSamplerAddressMode vk_address_mode = image_info.is_cube ? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE : VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            sampler_create_info.addressModeU = vk_address_mode;
+            sampler_create_info.addressModeV = vk_address_mode;
+            sampler_create_info.addressModeW = vk_address_mode;
 
             sampler_create_info.anisotropyEnable = VK_TRUE;
             sampler_create_info.maxAnisotropy = m_vk_phys_device_properties.limits.maxSamplerAnisotropy;
@@ -913,7 +2130,7 @@ namespace Arieo
             sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
             sampler_create_info.mipLodBias = 0.0f;
             sampler_create_info.minLod = 0.0f;
-            sampler_create_info.maxLod = 0.0f;
+            sampler_create_info.maxLod = static_cast<float>(image_info.mip_levels - 1);
 
             VkResult result = vkCreateSampler(m_vk_device, &sampler_create_info, nullptr, &vk_sampler); 
             if(result != VK_SUCCESS)
@@ -923,26 +2140,363 @@ namespace Arieo
             }
         }
 
-        return Base::Interop::RawRef<Interface::RHI::IImage>::createAs<VulkanImage>(
+        std::vector<VkFormat> vk_view_formats = image_info.view_formats;
+        Base::Interop::RawRef<Interface::RHI::IImage> image = Base::Interop::RawRef<Interface::RHI::IImage>::createAs<VulkanImage>(
+            m_vk_device,
             std::move(vk_image),
-            std::move(vk_image_view),
             std::move(vk_sampler),
             std::move(vk_image_allocation),
             std::move(vk_image_allocation_info),
             image_create_info.extent, 
-            image_create_info.format
+            image_create_info.format,
+            image_info.mip_levels,
+            image_info.array_layers,
+            vk_image_view_type,
+            image_info.samples,
+            vk_aspect_mask,
+            std::move(vk_view_formats)
         );
+
+        if(m_bindless_heap != nullptr && (image_create_info.usage & VK_IMAGE_USAGE_SAMPLED_BIT) != 0)
+        {
+            image.castToInstance<VulkanImage>()->m_bindless_index = m_bindless_heap->registerImage(image);
+        }
+        return image;
     }
 
     void VulkanDevice::destroyImage(Base::Interop::RawRef<Interface::RHI::IImage> image)
     {
         VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
+        m_descriptor_set_cache.invalidateImage(vulkan_image->m_vk_image);
+        if(vulkan_image->m_bindless_index != VulkanBindlessHeap::INVALID_INDEX)
+        {
+            m_bindless_heap->unregisterImage(vulkan_image->m_bindless_index);
+        }
         vkDestroySampler(m_vk_device, vulkan_image->m_vulkan_image_sampler->m_vk_image_sampler, nullptr);
-        vkDestroyImageView(m_vk_device, vulkan_image->m_vulkan_image_view->m_vk_image_view, nullptr);
+        vulkan_image->destroyImageViews();
         vmaDestroyImage(m_vma_allocator, vulkan_image->m_vk_image, vulkan_image->m_vma_allocation);
         Base::Interop::RawRef<Interface::RHI::IImage>::destroyAs<VulkanImage>(std::move(image));
     }
 
+    VulkanEvent* VulkanDevice::createEvent()
+    {
+        VkEventCreateInfo event_info{};
+        event_info.sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO;
+        if(m_vulkan_device_features.synchronization2)
+        {
+            // Split barriers are only set and waited on the GPU timeline.
+            event_info.flags = VK_EVENT_CREATE_DEVICE_ONLY_BIT;
+        }
+
+        VkEvent vk_event;
+        VkResult result = vkCreateEvent(m_vk_device, &event_info, nullptr, &vk_event);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("failed create event: {}", VulkanUtility::covertVkResultToString(result));
+            return nullptr;
+        }
+
+        return Base::newT<VulkanEvent>(m_vk_device, std::move(vk_event));
+    }
+
+    void VulkanDevice::destroyEvent(VulkanEvent* vulkan_event)
+    {
+        vkDestroyEvent(m_vk_device, vulkan_event->m_vk_event, nullptr);
+        Base::deleteT(vulkan_event);
+    }
+
+    VulkanReadbackManager* VulkanDevice::createReadbackManager(std::uint32_t frame_count, VkDeviceSize frame_capacity)
+    {
+        if(frame_count == 0 || frame_capacity == 0)
+        {
+            Core::Logger::error("Readback manager needs at least one frame with non-zero capacity");
+            return nullptr;
+        }
+
+        std::vector<VulkanReadbackFrame> readback_frames(frame_count);
+        for(std::uint32_t frame_index = 0; frame_index < frame_count; frame_index++)
+        {
+            VulkanReadbackFrame& readback_frame = readback_frames[frame_index];
+
+            VkBufferCreateInfo buffer_info{};
+            buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_info.size = frame_capacity;
+            buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+            // Host cached memory keeps CPU reads fast, it is invalidated per ticket
+            VmaAllocationCreateInfo alloc_info{};
+            alloc_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+            alloc_info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+            alloc_info.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+            VkBuffer vk_buffer;
+            VmaAllocation vma_allocation;
+            VmaAllocationInfo vma_allocation_info;
+            VkResult result = vmaCreateBuffer(m_vma_allocator, &buffer_info, &alloc_info, &vk_buffer, &vma_allocation, &vma_allocation_info);
+            if(result != VK_SUCCESS)
+            {
+                Core::Logger::error("Create readback buffer failed: {}", VulkanUtility::covertVkResultToString(result));
+                for(std::uint32_t created_index = 0; created_index < frame_index; created_index++)
+                {
+                    destroyBuffer(readback_frames[created_index].staging_buffer);
+                }
+                return nullptr;
+            }
+
+            readback_frame.staging_buffer = Base::Interop::RawRef<Interface::RHI::IBuffer>::createAs<VulkanBuffer>(std::move(vk_buffer), m_vma_allocator, std::move(vma_allocation));
+            readback_frame.mapped_ptr = static_cast<std::uint8_t*>(vma_allocation_info.pMappedData);
+            readback_frame.capacity = frame_capacity;
+        }
+
+        Core::Logger::trace("Readback manager created {}x{}", frame_count, frame_capacity);
+        return Base::newT<VulkanReadbackManager>(m_vk_device, m_vma_allocator, std::move(readback_frames));
+    }
+
+    void VulkanDevice::destroyReadbackManager(VulkanReadbackManager* readback_manager)
+    {
+        for(VulkanReadbackFrame& readback_frame : readback_manager->m_readback_frames)
+        {
+            destroyBuffer(readback_frame.staging_buffer);
+        }
+        Base::deleteT(readback_manager);
+    }
+
+    VulkanDescriptorAllocator* VulkanDevice::createDescriptorAllocator(std::uint32_t frame_count, std::uint32_t initial_set_count)
+    {
+        Core::Logger::trace("Descriptor allocator created {} frames, {} initial sets", frame_count, initial_set_count);
+        return Base::newT<VulkanDescriptorAllocator>(m_vk_device, initial_set_count, frame_count);
+    }
+
+    void VulkanDevice::destroyDescriptorAllocator(VulkanDescriptorAllocator* descriptor_allocator)
+    {
+        Base::deleteT(descriptor_allocator);
+    }
+
+    VulkanDescriptorUpdateTemplate* VulkanDevice::createDescriptorUpdateTemplate(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index, const std::vector<VkDescriptorUpdateTemplateEntry>& entries)
+    {
+        if(m_vulkan_device_features.descriptor_update_template == false)
+        {
+            Core::Logger::error("Descriptor update templates are not supported by the device");
+            return nullptr;
+        }
+
+        VulkanPipeline* vulkan_pipeline = pipeline.castToInstance<VulkanPipeline>();
+        if(set_index >= vulkan_pipeline->m_vk_descriptor_set_layouts.size())
+        {
+            Core::Logger::error("Pipeline has no descriptor set {}", set_index);
+            return nullptr;
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo template_info{};
+        template_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        template_info.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+        template_info.pDescriptorUpdateEntries = entries.data();
+        template_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        template_info.descriptorSetLayout = vulkan_pipeline->m_vk_descriptor_set_layouts[set_index];
+
+        VkDescriptorUpdateTemplate vk_descriptor_update_template;
+        VkResult result = m_vulkan_device_features.vk_create_descriptor_update_template(m_vk_device, &template_info, nullptr, &vk_descriptor_update_template);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Create descriptor update template failed: {}", VulkanUtility::covertVkResultToString(result));
+            return nullptr;
+        }
+
+        Core::Logger::trace("Descriptor update template created {} entries", entries.size());
+        return Base::newT<VulkanDescriptorUpdateTemplate>(m_vk_device, m_vulkan_device_features, std::move(vk_descriptor_update_template));
+    }
+
+    void VulkanDevice::destroyDescriptorUpdateTemplate(VulkanDescriptorUpdateTemplate* descriptor_update_template)
+    {
+        m_vulkan_device_features.vk_destroy_descriptor_update_template(m_vk_device, descriptor_update_template->m_vk_descriptor_update_template, nullptr);
+        Base::deleteT(descriptor_update_template);
+    }
+
+    bool VulkanDevice::enableDescriptorBuffers()
+    {
+        if(m_vulkan_device_features.descriptor_buffer == false)
+        {
+            Core::Logger::error("Descriptor buffers are not supported by the device");
+            return false;
+        }
+        m_is_descriptor_buffer_enabled = true;
+        return true;
+    }
+
+    bool VulkanDevice::enableShaderObjects()
+    {
+        if(m_vulkan_device_features.shader_object == false)
+        {
+            Core::Logger::error("Shader objects are not supported by the device");
+            return false;
+        }
+        m_is_shader_object_enabled = true;
+        return true;
+    }
+
+    bool VulkanDevice::enableBindlessHeap(std::uint32_t image_capacity, std::uint32_t buffer_capacity)
+    {
+        if(m_bindless_heap != nullptr)
+        {
+            return true;
+        }
+        if(m_vulkan_device_features.descriptor_indexing == false)
+        {
+            Core::Logger::error("Bindless heap needs descriptor indexing, not supported by the device");
+            return false;
+        }
+
+        // Update-after-bind arrays have their own, usually much larger, limits
+        VkPhysicalDeviceDescriptorIndexingProperties vk_descriptor_indexing_properties{};
+        vk_descriptor_indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+        VkPhysicalDeviceProperties2 vk_phys_device_properties2{};
+        vk_phys_device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        vk_phys_device_properties2.pNext = &vk_descriptor_indexing_properties;
+        vkGetPhysicalDeviceProperties2(m_vk_phys_device, &vk_phys_device_properties2);
+
+        std::uint32_t max_image_count = std::min({
+            vk_descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+            vk_descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+            vk_descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            vk_descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers
+        });
+        std::uint32_t max_buffer_count = std::min(
+            vk_descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+            vk_descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+        );
+        if(image_capacity == 0 || buffer_capacity == 0 || image_capacity > max_image_count || buffer_capacity > max_buffer_count)
+        {
+            Core::Logger::error("Bindless heap of {} images and {} buffers is invalid, device supports {} and {}", image_capacity, buffer_capacity, max_image_count, max_buffer_count);
+            return false;
+        }
+
+        std::vector<VkDescriptorSetLayoutBinding> vk_descriptor_bindings(3);
+        vk_descriptor_bindings[0].binding = VulkanBindlessHeap::SAMPLED_IMAGE_BINDING;
+        vk_descriptor_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        vk_descriptor_bindings[0].descriptorCount = image_capacity;
+        vk_descriptor_bindings[1].binding = VulkanBindlessHeap::SAMPLER_BINDING;
+        vk_descriptor_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        vk_descriptor_bindings[1].descriptorCount = image_capacity;
+        vk_descriptor_bindings[2].binding = VulkanBindlessHeap::STORAGE_BUFFER_BINDING;
+        vk_descriptor_bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        vk_descriptor_bindings[2].descriptorCount = buffer_capacity;
+        for(VkDescriptorSetLayoutBinding& descriptor_binding : vk_descriptor_bindings)
+        {
+            descriptor_binding.stageFlags = VK_SHADER_STAGE_ALL;
+        }
+
+        std::array<VkDescriptorBindingFlags, 3> vk_binding_flags;
+        vk_binding_flags.fill(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+        VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+        binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_info.bindingCount = static_cast<uint32_t>(vk_binding_flags.size());
+        binding_flags_info.pBindingFlags = vk_binding_flags.data();
+
+        VkDescriptorSetLayoutCreateInfo desc_layout_create_info{};
+        desc_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        desc_layout_create_info.pNext = &binding_flags_info;
+        desc_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        desc_layout_create_info.bindingCount = static_cast<uint32_t>(vk_descriptor_bindings.size());
+        desc_layout_create_info.pBindings = vk_descriptor_bindings.data();
+
+        VkDescriptorSetLayout vk_descriptor_set_layout;
+        VkResult result = vkCreateDescriptorSetLayout(m_vk_device, &desc_layout_create_info, nullptr, &vk_descriptor_set_layout);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Create bindless descriptor set layout failed: {}", VulkanUtility::covertVkResultToString(result));
+            return false;
+        }
+
+        std::array<VkDescriptorPoolSize, 3> pool_sizes{};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        pool_sizes[0].descriptorCount = image_capacity;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        pool_sizes[1].descriptorCount = image_capacity;
+        pool_sizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[2].descriptorCount = buffer_capacity;
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_info.pPoolSizes = pool_sizes.data();
+        pool_info.maxSets = 1;
+
+        VkDescriptorPool vk_descriptor_pool;
+        result = vkCreateDescriptorPool(m_vk_device, &pool_info, nullptr, &vk_descriptor_pool);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Create bindless descriptor pool failed: {}", VulkanUtility::covertVkResultToString(result));
+            vkDestroyDescriptorSetLayout(m_vk_device, vk_descriptor_set_layout, nullptr);
+            return false;
+        }
+
+        VkDescriptorSetAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool = vk_descriptor_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &vk_descriptor_set_layout;
+
+        VkDescriptorSet vk_descriptor_set;
+        result = vkAllocateDescriptorSets(m_vk_device, &alloc_info, &vk_descriptor_set);
+        if(result != VK_SUCCESS)
+        {
+            Core::Logger::error("Allocate bindless descriptor set failed: {}", VulkanUtility::covertVkResultToString(result));
+            vkDestroyDescriptorPool(m_vk_device, vk_descriptor_pool, nullptr);
+            vkDestroyDescriptorSetLayout(m_vk_device, vk_descriptor_set_layout, nullptr);
+            return false;
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet> descriptor_set = Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::createAs<VulkanDescriptorSet>(m_vk_device, std::move(vk_descriptor_set), vk_descriptor_bindings);
+        m_bindless_heap = Base::newT<VulkanBindlessHeap>(
+            m_vk_device,
+            std::move(vk_descriptor_set_layout),
+            std::move(vk_descriptor_pool),
+            std::move(descriptor_set),
+            std::move(vk_descriptor_bindings),
+            image_capacity,
+            buffer_capacity
+        );
+        Core::Logger::trace("Bindless heap created {} images, {} buffers", image_capacity, buffer_capacity);
+        return true;
+    }
+
+    bool VulkanDevice::enableShaderOptimizer(bool strip_debug_info, bool optimize_performance, const std::string& cache_directory)
+    {
+        if(m_shader_optimizer != nullptr)
+        {
+            Core::Logger::error("Shader optimizer is already enabled");
+            return false;
+        }
+        m_shader_optimizer = Base::newT<VulkanShaderOptimizer>(strip_debug_info, optimize_performance, cache_directory);
+        return true;
+    }
+
+    void VulkanDevice::destroyShaderOptimizer()
+    {
+        if(m_shader_optimizer == nullptr)
+        {
+            return;
+        }
+        Base::deleteT(m_shader_optimizer);
+        m_shader_optimizer = nullptr;
+    }
+
+    void VulkanDevice::destroyBindlessHeap()
+    {
+        if(m_bindless_heap == nullptr)
+        {
+            return;
+        }
+
+        // Destroying the pool frees the set
+        vkDestroyDescriptorPool(m_vk_device, m_bindless_heap->m_vk_descriptor_pool, nullptr);
+        vkDestroyDescriptorSetLayout(m_vk_device, m_bindless_heap->m_vk_descriptor_set_layout, nullptr);
+        Base::Interop::RawRef<Interface::RHI::IDescriptorSet>::destroyAs<VulkanDescriptorSet>(std::move(m_bindless_heap->m_descriptor_set));
+        Base::deleteT(m_bindless_heap);
+        m_bindless_heap = nullptr;
+    }
+
     void VulkanDevice::waitIdle()
     {
         VkResult result = vkDeviceWaitIdle(m_vk_device);
@@ -3,6 +3,18 @@
 #include <vulkan.h>
 #include "../queue/vulkan_render_command_queue.h"
 #include "../queue/vulkan_present_command_queue.h"
+#include "vulkan_device_features.h"
+#include "../readback/vulkan_readback.h"
+#include "../descriptor/vulkan_descriptor_allocator.h"
+#include "../descriptor/vulkan_descriptor_cache.h"
+#include "../descriptor/vulkan_descriptor_writer.h"
+#include "../descriptor/vulkan_bindless_heap.h"
+#include "../descriptor/vulkan_descriptor_buffer.h"
+#include "../shader/vulkan_shader_cache.h"
+#include "../shader/vulkan_shader_compiler.h"
+#include "../shader/vulkan_shader_optimizer.h"
+#include "../pipeline/vulkan_pipeline_variants.h"
+#include "../pipeline/vulkan_pipeline_library.h"
 
 #include <vk_mem_alloc.h>
 
@@ -17,17 +29,22 @@ namespace Arieo
             VkPhysicalDevice&& vk_phys_device, 
             VkDevice&& vk_device,
             ::VmaAllocator&& vma_allocator,
+            VulkanDeviceFeatures&& vulkan_device_features,
             std::uint32_t vk_graphics_queue_index, 
             std::uint32_t vk_present_queue_index, 
             VkQueue&& vk_graphics_queue, 
-            VkQueue&& vk_present_queue)
+            VkQueue&& vk_present_queue,
+            VkPipelineCache&& vk_pipeline_cache)
             : m_vk_device(vk_device),
             m_vma_allocator(std::move(vma_allocator)),
+            m_vk_pipeline_cache(std::move(vk_pipeline_cache)),
             m_vk_phys_device(vk_phys_device),
-            m_graphics_queue(m_vk_device, vk_graphics_queue_index, std::move(vk_graphics_queue)),
-            m_present_queue(m_vk_device, vk_present_queue_index, std::move(vk_present_queue)),
+            m_vulkan_device_features(std::move(vulkan_device_features)),
+            m_graphics_queue(m_vk_device, m_vulkan_device_features, vk_graphics_queue_index, std::move(vk_graphics_queue)),
+            m_present_queue(m_vk_device, m_vulkan_device_features, vk_present_queue_index, std::move(vk_present_queue)),
             m_graphic_queue_index(vk_graphics_queue_index),
-            m_present_queue_index(vk_present_queue_index)
+            m_present_queue_index(vk_present_queue_index),
+            m_descriptor_set_cache(m_vk_device)
         {
             vkGetPhysicalDeviceProperties(m_vk_phys_device, &m_vk_phys_device_properties);
         }
@@ -49,11 +66,55 @@ namespace Arieo
         Base::Interop::RawRef<Interface::RHI::IFramebuffer> createFramebuffer(Base::Interop::RawRef<Interface::RHI::IPipeline>, Base::Interop::RawRef<Interface::RHI::ISwapchain> swapchain, const Base::Interop::DataArrayView<Base::Interop::RawRef<Interface::RHI::IImageView>>& attachment_array) override;
         void destroyFramebuffer(Base::Interop::RawRef<Interface::RHI::IFramebuffer>) override;
 
+        // Identical SPIR-V returns the same shader, every createShader needs its destroyShader.
         Base::Interop::RawRef<Interface::RHI::IShader> createShader(const void* buf, size_t buf_size) override;
         void destroyShader(Base::Interop::RawRef<Interface::RHI::IShader>) override;
+        // Needs shader_module_identifier. The shader has no module and no reflection, pipelines using it need
+        // explicit layouts and are only created when they are found in the pipeline cache.
+        Base::Interop::RawRef<Interface::RHI::IShader> createShaderFromIdentifier(const std::uint8_t* identifier, std::uint32_t identifier_size);
+        VulkanShaderModuleCache& getShaderModuleCache()
+        {
+            return m_shader_module_cache;
+        }
+        // Shader objects shared by the shader object pipelines, see VulkanShaderObjectCache.
+        VulkanShaderObjectCache& getShaderObjectCache()
+        {
+            return m_shader_object_cache;
+        }
+
+        // Compiler owned by the caller, it may outlive the device. Use compileAsync on it to build shaders
+        // in the background and createShader with the result.
+        VulkanShaderCompiler* createShaderCompiler(const std::string& cache_directory, const std::vector<std::string>& include_directories, std::uint32_t thread_count);
+        void destroyShaderCompiler(VulkanShaderCompiler*);
+        Base::Interop::RawRef<Interface::RHI::IShader> createShaderFromSource(VulkanShaderCompiler& shader_compiler, const VulkanShaderSource& shader_source);
+
+        // Opt-in, shaders created afterwards go through the optimizer before vkCreateShaderModule. Enable it
+        // before the first createShader, shaders already in the module cache are not optimized again.
+        bool enableShaderOptimizer(bool strip_debug_info, bool optimize_performance, const std::string& cache_directory);
+        VulkanShaderOptimizer* getShaderOptimizer()
+        {
+            return m_shader_optimizer;
+        }
+
+        // Pipeline cache shared by every pipeline of the device. Data saved by an earlier run is merged in,
+        // data of another driver or device is ignored by the driver.
+        bool loadPipelineCacheData(const void* data, size_t data_size);
+        std::vector<std::uint8_t> getPipelineCacheData();
 
         Base::Interop::RawRef<Interface::RHI::IPipeline> createPipeline(Base::Interop::RawRef<Interface::RHI::IShader> vert_shader, Base::Interop::RawRef<Interface::RHI::IShader> frag_shader, Base::Interop::RawRef<Interface::RHI::IImageView> target_color_attachment, Base::Interop::RawRef<Interface::RHI::IImageView> target_depth_attachment) override;
         void destroyPipeline(Base::Interop::RawRef<Interface::RHI::IPipeline>) override;
+        // Empty descriptor set layouts, push constant ranges and vertex layout are derived from the shaders.
+        Base::Interop::RawRef<Interface::RHI::IPipeline> createPipeline(const VulkanGraphicsPipelineDesc& pipeline_desc);
+
+        // The specializations replace the base desc's. Pipelines are owned by the variant set, do not destroy them.
+        VulkanPipelineVariants* createPipelineVariants(const VulkanGraphicsPipelineDesc& base_desc);
+        void destroyPipelineVariants(VulkanPipelineVariants*);
+        Base::Interop::RawRef<Interface::RHI::IPipeline> getPipelineVariant(VulkanPipelineVariants* pipeline_variants, const VulkanSpecialization& vert_specialization, const VulkanSpecialization& frag_specialization);
+
+        // Needs graphics_pipeline_library, set it as pipeline_library in descs. Call beginFrame on it every frame
+        // to swap in optimized pipelines. Destroy its pipelines first.
+        VulkanPipelineLibrary* createPipelineLibrary(std::uint32_t frame_count);
+        void destroyPipelineLibrary(VulkanPipelineLibrary*);
 
         Base::Interop::RawRef<Interface::RHI::IFence> createFence() override;
         void destroyFence(Base::Interop::RawRef<Interface::RHI::IFence>) override;
@@ -69,14 +130,72 @@ namespace Arieo
 
         Base::Interop::RawRef<Interface::RHI::IImage> createImage(std::uint32_t width, std::uint32_t height, Interface::RHI::Format format, Interface::RHI::ImageAspectFlags aspect, Interface::RHI::ImageTiling tiling, Interface::RHI::ImageUsageFlags usage, Interface::RHI::MemoryUsage mem_usage) override;
         void destroyImage(Base::Interop::RawRef<Interface::RHI::IImage>) override;
+        Base::Interop::RawRef<Interface::RHI::IImage> createImage(const VulkanImageCreateInfo& image_info);
 
         void waitIdle() override;
+
+        VulkanEvent* createEvent();
+        void destroyEvent(VulkanEvent*);
+
+        // frame_count should match the frames in flight, every frame can read back up to frame_capacity bytes.
+        VulkanReadbackManager* createReadbackManager(std::uint32_t frame_count, VkDeviceSize frame_capacity);
+        void destroyReadbackManager(VulkanReadbackManager*);
+
+        // frame_count should match the frames in flight, pass 0 when only long lived sets are needed.
+        // The first pool of each chain holds initial_set_count sets, later pools double in size.
+        VulkanDescriptorAllocator* createDescriptorAllocator(std::uint32_t frame_count, std::uint32_t initial_set_count = 64);
+        void destroyDescriptorAllocator(VulkanDescriptorAllocator*);
+
+        // entries describe the packed struct later passed to update, returns nullptr without template support.
+        VulkanDescriptorUpdateTemplate* createDescriptorUpdateTemplate(Base::Interop::RawRef<Interface::RHI::IPipeline> pipeline, std::uint32_t set_index, const std::vector<VkDescriptorUpdateTemplateEntry>& entries);
+        void destroyDescriptorUpdateTemplate(VulkanDescriptorUpdateTemplate*);
+
+        // Opt-in bindless mode, needs descriptor indexing. Sampled images and storage buffers created afterwards
+        // get a stable heap index, see VulkanImage::getBindlessIndex and VulkanBuffer::getBindlessIndex.
+        bool enableBindlessHeap(std::uint32_t image_capacity, std::uint32_t buffer_capacity);
+        VulkanBindlessHeap* getBindlessHeap()
+        {
+            return m_bindless_heap;
+        }
+
+        // Opt-in descriptor buffer mode, needs the descriptor_buffer feature. Enable it before creating buffers,
+        // descriptor pools or pipelines through the IRHI interface: uniform and storage buffers then get a device
+        // address, createDescriptorPool hands out descriptor buffer pools and createPipeline builds matching layouts.
+        // Descriptor allocators and the set cache reject such pipelines.
+        bool enableDescriptorBuffers();
+        bool isDescriptorBufferEnabled() const
+        {
+            return m_is_descriptor_buffer_enabled;
+        }
+
+        // Opt-in shader objects, needs the shader_object feature. Shaders created afterwards keep their SPIR-V for
+        // vkCreateShadersEXT, so enable it before creating the shaders of pipelines with use_shader_objects.
+        bool enableShaderObjects();
+        bool isShaderObjectEnabled() const
+        {
+            return m_is_shader_object_enabled;
+        }
+
+        // Shared descriptor sets keyed by layout and bound resources, entries follow destroyBuffer/destroyImage.
+        VulkanDescriptorSetCache& getDescriptorSetCache()
+        {
+            return m_descriptor_set_cache;
+        }
     private:
+        bool applyShaderReflection(VulkanGraphicsPipelineDesc& pipeline_desc);
+        bool createShaderObjects(const VulkanGraphicsPipelineDesc& pipeline_desc, const std::vector<VkDescriptorSetLayout>& vk_descriptor_set_layouts, const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& vk_descriptor_set_bindings, std::uint32_t bindless_set_index, std::array<VkShaderEXT, 2>& vk_shaders);
+        bool createPipelineLibraryParts(VulkanPipelineLibrary& pipeline_library, const VulkanGraphicsPipelineDesc& pipeline_desc, const VkGraphicsPipelineCreateInfo& pipeline_create_info, std::array<VkPipeline, VulkanPipelineLibrary::PART_TYPE_COUNT>& vk_part_pipelines);
+        Base::Interop::RawRef<Interface::RHI::IDescriptorPool> createDescriptorBufferPool(size_t capacity);
+        void destroyBindlessHeap();
+        void destroyShaderOptimizer();
+
         VkDevice m_vk_device;
 
         ::VmaAllocator m_vma_allocator;
+        VkPipelineCache m_vk_pipeline_cache;
 
         VkPhysicalDevice m_vk_phys_device; 
+        VulkanDeviceFeatures m_vulkan_device_features;
         Base::Interop::Instance<VulkanRenderCommandQueue> m_graphics_queue;
         Base::Interop::Instance<VulkanPresentCommandQueue> m_present_queue;
 
@@ -84,6 +203,14 @@ namespace Arieo
         std::uint32_t m_present_queue_index;
 
         VkPhysicalDeviceProperties m_vk_phys_device_properties{};
+
+        VulkanDescriptorSetCache m_descriptor_set_cache;
+        VulkanBindlessHeap* m_bindless_heap = nullptr;
+        bool m_is_descriptor_buffer_enabled = false;
+        bool m_is_shader_object_enabled = false;
+        VulkanShaderModuleCache m_shader_module_cache;
+        VulkanShaderObjectCache m_shader_object_cache;
+        VulkanShaderOptimizer* m_shader_optimizer = nullptr;
     };
 }
 
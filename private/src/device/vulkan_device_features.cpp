@@ -0,0 +1,659 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include <vulkan.h>
+#include <vulkan_core.h>
+
+#include "../vulkan_rhi.h"
+
+namespace Arieo
+{
+    void VulkanDeviceFeatures::queryPhysicalDevice(VkPhysicalDevice vk_phys_device)
+    {
+        VkPhysicalDeviceProperties vk_phys_device_properties;
+        vkGetPhysicalDeviceProperties(vk_phys_device, &vk_phys_device_properties);
+        api_version = vk_phys_device_properties.apiVersion;
+
+        {
+            uint32_t extension_count = 0;
+            vkEnumerateDeviceExtensionProperties(vk_phys_device, nullptr, &extension_count, nullptr);
+            m_vk_extension_properties.resize(extension_count);
+            vkEnumerateDeviceExtensionProperties(vk_phys_device, nullptr, &extension_count, m_vk_extension_properties.data());
+        }
+
+        VkPhysicalDeviceFeatures vk_core_features{};
+        vkGetPhysicalDeviceFeatures(vk_phys_device, &vk_core_features);
+        multi_draw_indirect = vk_core_features.multiDrawIndirect == VK_TRUE;
+        draw_indirect_first_instance = vk_core_features.drawIndirectFirstInstance == VK_TRUE;
+        // Core in 1.1, the extension has no feature structure
+        descriptor_update_template = api_version >= VK_API_VERSION_1_1 || isExtensionSupported(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+
+        if(api_version < VK_API_VERSION_1_1)
+        {
+            Core::Logger::warn("Vulkan device api version {}.{} is too low, optional features disabled",
+                VK_VERSION_MAJOR(api_version),
+                VK_VERSION_MINOR(api_version));
+            return;
+        }
+
+        VkPhysicalDeviceFeatures2 vk_features2{};
+        vk_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        void** vk_features_tail = &vk_features2.pNext;
+        auto chain_features = [&vk_features_tail](auto& vk_feature_struct)
+        {
+            *vk_features_tail = &vk_feature_struct;
+            vk_features_tail = &vk_feature_struct.pNext;
+        };
+
+        // Vulkan 1.2 features have to be queried and enabled through the aggregate structure
+        VkPhysicalDeviceVulkan12Features vk_vulkan12_features{};
+        vk_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        if(api_version >= VK_API_VERSION_1_2)
+        {
+            chain_features(vk_vulkan12_features);
+        }
+
+        // Before 1.2 descriptor indexing comes from VK_EXT_descriptor_indexing, same structure
+        VkPhysicalDeviceDescriptorIndexingFeatures vk_descriptor_indexing_features{};
+        vk_descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        bool is_descriptor_indexing_extension = api_version < VK_API_VERSION_1_2 && isExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        if(is_descriptor_indexing_extension)
+        {
+            chain_features(vk_descriptor_indexing_features);
+        }
+
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT vk_descriptor_buffer_features{};
+        vk_descriptor_buffer_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+        bool is_descriptor_buffer_exposed = api_version >= VK_API_VERSION_1_2 && isExtensionSupported(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+        if(is_descriptor_buffer_exposed)
+        {
+            chain_features(vk_descriptor_buffer_features);
+        }
+
+        // Identifier-only stages fail instead of compiling, which needs pipeline creation cache control (core in 1.3)
+        VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT vk_shader_module_identifier_features{};
+        vk_shader_module_identifier_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT;
+        VkPhysicalDevicePipelineCreationCacheControlFeatures vk_pipeline_creation_cache_control_features{};
+        vk_pipeline_creation_cache_control_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_CREATION_CACHE_CONTROL_FEATURES;
+        bool is_shader_module_identifier_exposed = isExtensionSupported(VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME)
+            && (api_version >= VK_API_VERSION_1_3 || isExtensionSupported(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME));
+        if(is_shader_module_identifier_exposed)
+        {
+            chain_features(vk_shader_module_identifier_features);
+            chain_features(vk_pipeline_creation_cache_control_features);
+        }
+
+        // Before 1.3 dynamic rendering needs the 1.2 render pass 2 and depth stencil resolve functionality
+        VkPhysicalDeviceDynamicRenderingFeatures vk_dynamic_rendering_features{};
+        vk_dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        bool is_dynamic_rendering_exposed = api_version >= VK_API_VERSION_1_3
+            || (api_version >= VK_API_VERSION_1_2 && isExtensionSupported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME));
+        if(is_dynamic_rendering_exposed)
+        {
+            chain_features(vk_dynamic_rendering_features);
+        }
+
+        VkPhysicalDeviceShaderObjectFeaturesEXT vk_shader_object_features{};
+        vk_shader_object_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
+        bool is_shader_object_exposed = is_dynamic_rendering_exposed && isExtensionSupported(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+        if(is_shader_object_exposed)
+        {
+            chain_features(vk_shader_object_features);
+        }
+
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT vk_graphics_pipeline_library_features{};
+        vk_graphics_pipeline_library_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+        bool is_graphics_pipeline_library_exposed = is_dynamic_rendering_exposed
+            && isExtensionSupported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
+            && isExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        if(is_graphics_pipeline_library_exposed)
+        {
+            chain_features(vk_graphics_pipeline_library_features);
+        }
+
+        // Promoted to 1.3 without a feature bit, the first two sets are only queried before that
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT vk_extended_dynamic_state_features{};
+        vk_extended_dynamic_state_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+        bool is_extended_dynamic_state_extension = api_version < VK_API_VERSION_1_3 && isExtensionSupported(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        if(is_extended_dynamic_state_extension)
+        {
+            chain_features(vk_extended_dynamic_state_features);
+        }
+
+        VkPhysicalDeviceExtendedDynamicState2FeaturesEXT vk_extended_dynamic_state2_features{};
+        vk_extended_dynamic_state2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+        bool is_extended_dynamic_state2_extension = api_version < VK_API_VERSION_1_3 && isExtensionSupported(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+        if(is_extended_dynamic_state2_extension)
+        {
+            chain_features(vk_extended_dynamic_state2_features);
+        }
+
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT vk_extended_dynamic_state3_features{};
+        vk_extended_dynamic_state3_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+        bool is_extended_dynamic_state3_exposed = isExtensionSupported(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+        if(is_extended_dynamic_state3_exposed)
+        {
+            chain_features(vk_extended_dynamic_state3_features);
+        }
+
+        VkPhysicalDeviceVertexInputDynamicStateFeaturesEXT vk_vertex_input_dynamic_state_features{};
+        vk_vertex_input_dynamic_state_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_INPUT_DYNAMIC_STATE_FEATURES_EXT;
+        bool is_vertex_input_dynamic_state_exposed = isExtensionSupported(VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME);
+        if(is_vertex_input_dynamic_state_exposed)
+        {
+            chain_features(vk_vertex_input_dynamic_state_features);
+        }
+
+        VkPhysicalDeviceSynchronization2Features vk_synchronization2_features{};
+        vk_synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+        bool is_synchronization2_exposed = api_version >= VK_API_VERSION_1_3 || isExtensionSupported(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        if(is_synchronization2_exposed)
+        {
+            chain_features(vk_synchronization2_features);
+        }
+
+        vkGetPhysicalDeviceFeatures2(vk_phys_device, &vk_features2);
+
+        synchronization2 = is_synchronization2_exposed && vk_synchronization2_features.synchronization2 == VK_TRUE;
+        // The extension has no feature structure, exposing it is enough
+        draw_indirect_count = api_version >= VK_API_VERSION_1_2 
+            ? vk_vulkan12_features.drawIndirectCount == VK_TRUE
+            : isExtensionSupported(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+        if(api_version >= VK_API_VERSION_1_2)
+        {
+            descriptor_indexing = vk_vulkan12_features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+                && vk_vulkan12_features.shaderStorageBufferArrayNonUniformIndexing == VK_TRUE
+                && vk_vulkan12_features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+                && vk_vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE
+                && vk_vulkan12_features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE
+                && vk_vulkan12_features.descriptorBindingPartiallyBound == VK_TRUE
+                && vk_vulkan12_features.runtimeDescriptorArray == VK_TRUE;
+        }
+        else if(is_descriptor_indexing_extension)
+        {
+            descriptor_indexing = vk_descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+                && vk_descriptor_indexing_features.shaderStorageBufferArrayNonUniformIndexing == VK_TRUE
+                && vk_descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+                && vk_descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE
+                && vk_descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE
+                && vk_descriptor_indexing_features.descriptorBindingPartiallyBound == VK_TRUE
+                && vk_descriptor_indexing_features.runtimeDescriptorArray == VK_TRUE;
+        }
+
+        descriptor_buffer = is_descriptor_buffer_exposed
+            && vk_descriptor_buffer_features.descriptorBuffer == VK_TRUE
+            && vk_vulkan12_features.bufferDeviceAddress == VK_TRUE;
+        if(descriptor_buffer)
+        {
+            // Descriptor sizes and offset alignment are needed to lay out sets in the buffer
+            descriptor_buffer_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+            VkPhysicalDeviceProperties2 vk_phys_device_properties2{};
+            vk_phys_device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            vk_phys_device_properties2.pNext = &descriptor_buffer_properties;
+            vkGetPhysicalDeviceProperties2(vk_phys_device, &vk_phys_device_properties2);
+            descriptor_buffer_properties.pNext = nullptr;
+        }
+
+        shader_module_identifier = is_shader_module_identifier_exposed
+            && vk_shader_module_identifier_features.shaderModuleIdentifier == VK_TRUE
+            && vk_pipeline_creation_cache_control_features.pipelineCreationCacheControl == VK_TRUE;
+        if(shader_module_identifier)
+        {
+            // The algorithm UUID tells whether identifiers saved by an earlier run are still comparable
+            shader_module_identifier_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_PROPERTIES_EXT;
+            VkPhysicalDeviceProperties2 vk_phys_device_properties2{};
+            vk_phys_device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            vk_phys_device_properties2.pNext = &shader_module_identifier_properties;
+            vkGetPhysicalDeviceProperties2(vk_phys_device, &vk_phys_device_properties2);
+            shader_module_identifier_properties.pNext = nullptr;
+        }
+
+        dynamic_rendering = is_dynamic_rendering_exposed && vk_dynamic_rendering_features.dynamicRendering == VK_TRUE;
+        // Shader objects can only be drawn inside vkCmdBeginRendering instances
+        shader_object = dynamic_rendering && is_shader_object_exposed && vk_shader_object_features.shaderObject == VK_TRUE;
+
+        graphics_pipeline_library = dynamic_rendering && is_graphics_pipeline_library_exposed
+            && vk_graphics_pipeline_library_features.graphicsPipelineLibrary == VK_TRUE;
+        if(graphics_pipeline_library)
+        {
+            // Without fast linking the unoptimized link is not cheap either, pipelines are then linked optimized
+            graphics_pipeline_library_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+            VkPhysicalDeviceProperties2 vk_phys_device_properties2{};
+            vk_phys_device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            vk_phys_device_properties2.pNext = &graphics_pipeline_library_properties;
+            vkGetPhysicalDeviceProperties2(vk_phys_device, &vk_phys_device_properties2);
+            graphics_pipeline_library_properties.pNext = nullptr;
+        }
+
+        extended_dynamic_state = api_version >= VK_API_VERSION_1_3
+            || (is_extended_dynamic_state_extension && vk_extended_dynamic_state_features.extendedDynamicState == VK_TRUE);
+        extended_dynamic_state2 = api_version >= VK_API_VERSION_1_3
+            || (is_extended_dynamic_state2_extension && vk_extended_dynamic_state2_features.extendedDynamicState2 == VK_TRUE);
+        // Only the states VulkanRasterState carries, each of them is an optional feature
+        extended_dynamic_state3 = extended_dynamic_state && is_extended_dynamic_state3_exposed
+            && vk_extended_dynamic_state3_features.extendedDynamicState3PolygonMode == VK_TRUE
+            && vk_extended_dynamic_state3_features.extendedDynamicState3ColorBlendEnable == VK_TRUE
+            && vk_extended_dynamic_state3_features.extendedDynamicState3ColorBlendEquation == VK_TRUE
+            && vk_extended_dynamic_state3_features.extendedDynamicState3ColorWriteMask == VK_TRUE;
+        vertex_input_dynamic_state = is_vertex_input_dynamic_state_exposed && vk_vertex_input_dynamic_state_features.vertexInputDynamicState == VK_TRUE;
+
+        Core::Logger::trace("Vulkan device features: synchronization2={}, multi_draw_indirect={}, draw_indirect_count={}, descriptor_update_template={}, descriptor_indexing={}, descriptor_buffer={}, shader_module_identifier={}, dynamic_rendering={}, shader_object={}, graphics_pipeline_library={}, extended_dynamic_state={}/{}/{}, vertex_input_dynamic_state={}", 
+            synchronization2, multi_draw_indirect, draw_indirect_count, descriptor_update_template, descriptor_indexing, descriptor_buffer, shader_module_identifier, dynamic_rendering, shader_object, graphics_pipeline_library,
+            extended_dynamic_state, extended_dynamic_state2, extended_dynamic_state3, vertex_input_dynamic_state);
+    }
+
+    void VulkanDeviceFeatures::postProcessDeviceCreateInfo(VkDeviceCreateInfo& device_create_info, std::vector<const char*>& extension_names)
+    {
+        const void* vk_create_info_head = device_create_info.pNext;
+        auto prepend_features = [&vk_create_info_head](auto& vk_feature_struct)
+        {
+            vk_feature_struct.pNext = const_cast<void*>(vk_create_info_head);
+            vk_create_info_head = &vk_feature_struct;
+        };
+
+        // Core features extend whatever the caller already enabled
+        if(device_create_info.pEnabledFeatures != nullptr)
+        {
+            m_vk_enabled_core_features = *device_create_info.pEnabledFeatures;
+        }
+        m_vk_enabled_core_features.multiDrawIndirect = multi_draw_indirect ? VK_TRUE : VK_FALSE;
+        m_vk_enabled_core_features.drawIndirectFirstInstance = draw_indirect_first_instance ? VK_TRUE : VK_FALSE;
+        device_create_info.pEnabledFeatures = &m_vk_enabled_core_features;
+
+        if(api_version >= VK_API_VERSION_1_2)
+        {
+            m_vk_enabled_vulkan12_features = {};
+            m_vk_enabled_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+            m_vk_enabled_vulkan12_features.drawIndirectCount = draw_indirect_count ? VK_TRUE : VK_FALSE;
+            if(descriptor_indexing)
+            {
+                m_vk_enabled_vulkan12_features.descriptorIndexing = VK_TRUE;
+                m_vk_enabled_vulkan12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+                m_vk_enabled_vulkan12_features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+                m_vk_enabled_vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+                m_vk_enabled_vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+                m_vk_enabled_vulkan12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+                m_vk_enabled_vulkan12_features.descriptorBindingPartiallyBound = VK_TRUE;
+                m_vk_enabled_vulkan12_features.runtimeDescriptorArray = VK_TRUE;
+            }
+            if(descriptor_buffer)
+            {
+                m_vk_enabled_vulkan12_features.bufferDeviceAddress = VK_TRUE;
+            }
+            prepend_features(m_vk_enabled_vulkan12_features);
+        }
+        else
+        {
+            if(draw_indirect_count)
+            {
+                extension_names.emplace_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+            }
+            if(descriptor_indexing)
+            {
+                extension_names.emplace_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+                m_vk_enabled_descriptor_indexing_features = {};
+                m_vk_enabled_descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+                m_vk_enabled_descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+                m_vk_enabled_descriptor_indexing_features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+                m_vk_enabled_descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+                m_vk_enabled_descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+                m_vk_enabled_descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+                m_vk_enabled_descriptor_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+                m_vk_enabled_descriptor_indexing_features.runtimeDescriptorArray = VK_TRUE;
+                prepend_features(m_vk_enabled_descriptor_indexing_features);
+            }
+        }
+
+        if(descriptor_update_template && api_version < VK_API_VERSION_1_1)
+        {
+            extension_names.emplace_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+        }
+
+        if(descriptor_buffer)
+        {
+            extension_names.emplace_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+            m_vk_enabled_descriptor_buffer_features = {};
+            m_vk_enabled_descriptor_buffer_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+            m_vk_enabled_descriptor_buffer_features.descriptorBuffer = VK_TRUE;
+            prepend_features(m_vk_enabled_descriptor_buffer_features);
+        }
+
+        if(shader_module_identifier)
+        {
+            extension_names.emplace_back(VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME);
+            if(api_version < VK_API_VERSION_1_3)
+            {
+                extension_names.emplace_back(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME);
+            }
+            m_vk_enabled_shader_module_identifier_features = {};
+            m_vk_enabled_shader_module_identifier_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT;
+            m_vk_enabled_shader_module_identifier_features.shaderModuleIdentifier = VK_TRUE;
+            prepend_features(m_vk_enabled_shader_module_identifier_features);
+            m_vk_enabled_pipeline_creation_cache_control_features = {};
+            m_vk_enabled_pipeline_creation_cache_control_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_CREATION_CACHE_CONTROL_FEATURES;
+            m_vk_enabled_pipeline_creation_cache_control_features.pipelineCreationCacheControl = VK_TRUE;
+            prepend_features(m_vk_enabled_pipeline_creation_cache_control_features);
+        }
+
+        if(dynamic_rendering)
+        {
+            if(api_version < VK_API_VERSION_1_3)
+            {
+                extension_names.emplace_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+            }
+            m_vk_enabled_dynamic_rendering_features = {};
+            m_vk_enabled_dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+            m_vk_enabled_dynamic_rendering_features.dynamicRendering = VK_TRUE;
+            prepend_features(m_vk_enabled_dynamic_rendering_features);
+        }
+
+        if(shader_object)
+        {
+            extension_names.emplace_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+            m_vk_enabled_shader_object_features = {};
+            m_vk_enabled_shader_object_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
+            m_vk_enabled_shader_object_features.shaderObject = VK_TRUE;
+            prepend_features(m_vk_enabled_shader_object_features);
+        }
+
+        if(graphics_pipeline_library)
+        {
+            extension_names.emplace_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            extension_names.emplace_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+            m_vk_enabled_graphics_pipeline_library_features = {};
+            m_vk_enabled_graphics_pipeline_library_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            m_vk_enabled_graphics_pipeline_library_features.graphicsPipelineLibrary = VK_TRUE;
+            prepend_features(m_vk_enabled_graphics_pipeline_library_features);
+        }
+
+        if(extended_dynamic_state && api_version < VK_API_VERSION_1_3)
+        {
+            extension_names.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+            m_vk_enabled_extended_dynamic_state_features = {};
+            m_vk_enabled_extended_dynamic_state_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+            m_vk_enabled_extended_dynamic_state_features.extendedDynamicState = VK_TRUE;
+            prepend_features(m_vk_enabled_extended_dynamic_state_features);
+        }
+
+        if(extended_dynamic_state2 && api_version < VK_API_VERSION_1_3)
+        {
+            extension_names.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+            m_vk_enabled_extended_dynamic_state2_features = {};
+            m_vk_enabled_extended_dynamic_state2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+            m_vk_enabled_extended_dynamic_state2_features.extendedDynamicState2 = VK_TRUE;
+            prepend_features(m_vk_enabled_extended_dynamic_state2_features);
+        }
+
+        if(extended_dynamic_state3)
+        {
+            extension_names.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+            m_vk_enabled_extended_dynamic_state3_features = {};
+            m_vk_enabled_extended_dynamic_state3_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+            m_vk_enabled_extended_dynamic_state3_features.extendedDynamicState3PolygonMode = VK_TRUE;
+            m_vk_enabled_extended_dynamic_state3_features.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+            m_vk_enabled_extended_dynamic_state3_features.extendedDynamicState3ColorBlendEquation = VK_TRUE;
+            m_vk_enabled_extended_dynamic_state3_features.extendedDynamicState3ColorWriteMask = VK_TRUE;
+            prepend_features(m_vk_enabled_extended_dynamic_state3_features);
+        }
+
+        if(vertex_input_dynamic_state)
+        {
+            extension_names.emplace_back(VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME);
+            m_vk_enabled_vertex_input_dynamic_state_features = {};
+            m_vk_enabled_vertex_input_dynamic_state_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_INPUT_DYNAMIC_STATE_FEATURES_EXT;
+            m_vk_enabled_vertex_input_dynamic_state_features.vertexInputDynamicState = VK_TRUE;
+            prepend_features(m_vk_enabled_vertex_input_dynamic_state_features);
+        }
+
+        if(synchronization2)
+        {
+            if(api_version < VK_API_VERSION_1_3)
+            {
+                extension_names.emplace_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+            }
+            m_vk_enabled_synchronization2_features = {};
+            m_vk_enabled_synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+            m_vk_enabled_synchronization2_features.synchronization2 = VK_TRUE;
+            prepend_features(m_vk_enabled_synchronization2_features);
+        }
+
+        device_create_info.pNext = vk_create_info_head;
+    }
+
+    void VulkanDeviceFeatures::loadDeviceFunctions(VkDevice vk_device)
+    {
+        // Promoted entry points are looked up by their core name when the device version covers them,
+        // otherwise by the extension alias.
+        auto load_function = [this, vk_device](std::uint32_t promoted_version, const char* core_name, const char* extension_name)
+        {
+            return vkGetDeviceProcAddr(vk_device, api_version >= promoted_version ? core_name : extension_name);
+        };
+
+        if(synchronization2)
+        {
+            vk_cmd_pipeline_barrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2>(load_function(VK_API_VERSION_1_3, "vkCmdPipelineBarrier2", "vkCmdPipelineBarrier2KHR"));
+            vk_cmd_set_event2 = reinterpret_cast<PFN_vkCmdSetEvent2>(load_function(VK_API_VERSION_1_3, "vkCmdSetEvent2", "vkCmdSetEvent2KHR"));
+            vk_cmd_reset_event2 = reinterpret_cast<PFN_vkCmdResetEvent2>(load_function(VK_API_VERSION_1_3, "vkCmdResetEvent2", "vkCmdResetEvent2KHR"));
+            vk_cmd_wait_events2 = reinterpret_cast<PFN_vkCmdWaitEvents2>(load_function(VK_API_VERSION_1_3, "vkCmdWaitEvents2", "vkCmdWaitEvents2KHR"));
+
+            if(vk_cmd_pipeline_barrier2 == nullptr
+            || vk_cmd_set_event2 == nullptr
+            || vk_cmd_reset_event2 == nullptr
+            || vk_cmd_wait_events2 == nullptr)
+            {
+                Core::Logger::warn("synchronization2 entry points missing, fallback to legacy barriers");
+                synchronization2 = false;
+            }
+        }
+
+        if(draw_indirect_count)
+        {
+            vk_cmd_draw_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndirectCount>(load_function(VK_API_VERSION_1_2, "vkCmdDrawIndirectCount", "vkCmdDrawIndirectCountKHR"));
+            vk_cmd_draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(load_function(VK_API_VERSION_1_2, "vkCmdDrawIndexedIndirectCount", "vkCmdDrawIndexedIndirectCountKHR"));
+
+            if(vk_cmd_draw_indirect_count == nullptr || vk_cmd_draw_indexed_indirect_count == nullptr)
+            {
+                Core::Logger::warn("draw indirect count entry points missing, feature disabled");
+                draw_indirect_count = false;
+            }
+        }
+
+        if(descriptor_update_template)
+        {
+            vk_create_descriptor_update_template = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplate>(load_function(VK_API_VERSION_1_1, "vkCreateDescriptorUpdateTemplate", "vkCreateDescriptorUpdateTemplateKHR"));
+            vk_destroy_descriptor_update_template = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplate>(load_function(VK_API_VERSION_1_1, "vkDestroyDescriptorUpdateTemplate", "vkDestroyDescriptorUpdateTemplateKHR"));
+            vk_update_descriptor_set_with_template = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplate>(load_function(VK_API_VERSION_1_1, "vkUpdateDescriptorSetWithTemplate", "vkUpdateDescriptorSetWithTemplateKHR"));
+
+            if(vk_create_descriptor_update_template == nullptr
+            || vk_destroy_descriptor_update_template == nullptr
+            || vk_update_descriptor_set_with_template == nullptr)
+            {
+                Core::Logger::warn("descriptor update template entry points missing, feature disabled");
+                descriptor_update_template = false;
+            }
+        }
+
+        if(descriptor_buffer)
+        {
+            // Extension only, not promoted to core
+            vk_get_descriptor_set_layout_size = reinterpret_cast<PFN_vkGetDescriptorSetLayoutSizeEXT>(vkGetDeviceProcAddr(vk_device, "vkGetDescriptorSetLayoutSizeEXT"));
+            vk_get_descriptor_set_layout_binding_offset = reinterpret_cast<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(vkGetDeviceProcAddr(vk_device, "vkGetDescriptorSetLayoutBindingOffsetEXT"));
+            vk_get_descriptor = reinterpret_cast<PFN_vkGetDescriptorEXT>(vkGetDeviceProcAddr(vk_device, "vkGetDescriptorEXT"));
+            vk_cmd_bind_descriptor_buffers = reinterpret_cast<PFN_vkCmdBindDescriptorBuffersEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdBindDescriptorBuffersEXT"));
+            vk_cmd_set_descriptor_buffer_offsets = reinterpret_cast<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDescriptorBufferOffsetsEXT"));
+
+            if(vk_get_descriptor_set_layout_size == nullptr
+            || vk_get_descriptor_set_layout_binding_offset == nullptr
+            || vk_get_descriptor == nullptr
+            || vk_cmd_bind_descriptor_buffers == nullptr
+            || vk_cmd_set_descriptor_buffer_offsets == nullptr)
+            {
+                Core::Logger::warn("descriptor buffer entry points missing, fallback to descriptor pools");
+                descriptor_buffer = false;
+            }
+        }
+
+        if(shader_module_identifier)
+        {
+            vk_get_shader_module_identifier = reinterpret_cast<PFN_vkGetShaderModuleIdentifierEXT>(vkGetDeviceProcAddr(vk_device, "vkGetShaderModuleIdentifierEXT"));
+            if(vk_get_shader_module_identifier == nullptr)
+            {
+                Core::Logger::warn("shader module identifier entry points missing, feature disabled");
+                shader_module_identifier = false;
+            }
+        }
+
+        if(dynamic_rendering)
+        {
+            vk_cmd_begin_rendering = reinterpret_cast<PFN_vkCmdBeginRendering>(load_function(VK_API_VERSION_1_3, "vkCmdBeginRendering", "vkCmdBeginRenderingKHR"));
+            vk_cmd_end_rendering = reinterpret_cast<PFN_vkCmdEndRendering>(load_function(VK_API_VERSION_1_3, "vkCmdEndRendering", "vkCmdEndRenderingKHR"));
+            if(vk_cmd_begin_rendering == nullptr || vk_cmd_end_rendering == nullptr)
+            {
+                Core::Logger::warn("dynamic rendering entry points missing, feature disabled");
+                dynamic_rendering = false;
+                shader_object = false;
+                graphics_pipeline_library = false;
+            }
+        }
+
+        if(extended_dynamic_state)
+        {
+            vk_cmd_set_primitive_topology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopology>(load_function(VK_API_VERSION_1_3, "vkCmdSetPrimitiveTopology", "vkCmdSetPrimitiveTopologyEXT"));
+            vk_cmd_set_cull_mode = reinterpret_cast<PFN_vkCmdSetCullMode>(load_function(VK_API_VERSION_1_3, "vkCmdSetCullMode", "vkCmdSetCullModeEXT"));
+            vk_cmd_set_front_face = reinterpret_cast<PFN_vkCmdSetFrontFace>(load_function(VK_API_VERSION_1_3, "vkCmdSetFrontFace", "vkCmdSetFrontFaceEXT"));
+            vk_cmd_set_depth_test_enable = reinterpret_cast<PFN_vkCmdSetDepthTestEnable>(load_function(VK_API_VERSION_1_3, "vkCmdSetDepthTestEnable", "vkCmdSetDepthTestEnableEXT"));
+            vk_cmd_set_depth_write_enable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnable>(load_function(VK_API_VERSION_1_3, "vkCmdSetDepthWriteEnable", "vkCmdSetDepthWriteEnableEXT"));
+            vk_cmd_set_depth_compare_op = reinterpret_cast<PFN_vkCmdSetDepthCompareOp>(load_function(VK_API_VERSION_1_3, "vkCmdSetDepthCompareOp", "vkCmdSetDepthCompareOpEXT"));
+
+            if(vk_cmd_set_primitive_topology == nullptr
+            || vk_cmd_set_cull_mode == nullptr
+            || vk_cmd_set_front_face == nullptr
+            || vk_cmd_set_depth_test_enable == nullptr
+            || vk_cmd_set_depth_write_enable == nullptr
+            || vk_cmd_set_depth_compare_op == nullptr)
+            {
+                Core::Logger::warn("extended dynamic state entry points missing, feature disabled");
+                extended_dynamic_state = false;
+                extended_dynamic_state3 = false;
+            }
+        }
+
+        if(extended_dynamic_state2)
+        {
+            vk_cmd_set_rasterizer_discard_enable = reinterpret_cast<PFN_vkCmdSetRasterizerDiscardEnable>(load_function(VK_API_VERSION_1_3, "vkCmdSetRasterizerDiscardEnable", "vkCmdSetRasterizerDiscardEnableEXT"));
+            vk_cmd_set_primitive_restart_enable = reinterpret_cast<PFN_vkCmdSetPrimitiveRestartEnable>(load_function(VK_API_VERSION_1_3, "vkCmdSetPrimitiveRestartEnable", "vkCmdSetPrimitiveRestartEnableEXT"));
+
+            if(vk_cmd_set_rasterizer_discard_enable == nullptr || vk_cmd_set_primitive_restart_enable == nullptr)
+            {
+                Core::Logger::warn("extended dynamic state 2 entry points missing, feature disabled");
+                extended_dynamic_state2 = false;
+            }
+        }
+
+        if(extended_dynamic_state3)
+        {
+            // Extension only, not promoted to core
+            vk_cmd_set_polygon_mode = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetPolygonModeEXT"));
+            vk_cmd_set_color_blend_enable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetColorBlendEnableEXT"));
+            vk_cmd_set_color_blend_equation = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetColorBlendEquationEXT"));
+            vk_cmd_set_color_write_mask = reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetColorWriteMaskEXT"));
+
+            if(vk_cmd_set_polygon_mode == nullptr
+            || vk_cmd_set_color_blend_enable == nullptr
+            || vk_cmd_set_color_blend_equation == nullptr
+            || vk_cmd_set_color_write_mask == nullptr)
+            {
+                Core::Logger::warn("extended dynamic state 3 entry points missing, feature disabled");
+                extended_dynamic_state3 = false;
+            }
+        }
+
+        if(vertex_input_dynamic_state)
+        {
+            vk_cmd_set_vertex_input = reinterpret_cast<PFN_vkCmdSetVertexInputEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetVertexInputEXT"));
+            if(vk_cmd_set_vertex_input == nullptr)
+            {
+                Core::Logger::warn("vertex input dynamic state entry points missing, feature disabled");
+                vertex_input_dynamic_state = false;
+            }
+        }
+
+        if(shader_object)
+        {
+            // The extension exposes every dynamic state command under its EXT name, also without the
+            // extended dynamic state extensions
+            vk_create_shaders = reinterpret_cast<PFN_vkCreateShadersEXT>(vkGetDeviceProcAddr(vk_device, "vkCreateShadersEXT"));
+            vk_destroy_shader = reinterpret_cast<PFN_vkDestroyShaderEXT>(vkGetDeviceProcAddr(vk_device, "vkDestroyShaderEXT"));
+            vk_cmd_bind_shaders = reinterpret_cast<PFN_vkCmdBindShadersEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdBindShadersEXT"));
+            vk_cmd_set_viewport_with_count = reinterpret_cast<PFN_vkCmdSetViewportWithCount>(vkGetDeviceProcAddr(vk_device, "vkCmdSetViewportWithCountEXT"));
+            vk_cmd_set_scissor_with_count = reinterpret_cast<PFN_vkCmdSetScissorWithCount>(vkGetDeviceProcAddr(vk_device, "vkCmdSetScissorWithCountEXT"));
+            vk_cmd_set_primitive_topology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopology>(vkGetDeviceProcAddr(vk_device, "vkCmdSetPrimitiveTopologyEXT"));
+            vk_cmd_set_cull_mode = reinterpret_cast<PFN_vkCmdSetCullMode>(vkGetDeviceProcAddr(vk_device, "vkCmdSetCullModeEXT"));
+            vk_cmd_set_front_face = reinterpret_cast<PFN_vkCmdSetFrontFace>(vkGetDeviceProcAddr(vk_device, "vkCmdSetFrontFaceEXT"));
+            vk_cmd_set_depth_test_enable = reinterpret_cast<PFN_vkCmdSetDepthTestEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDepthTestEnableEXT"));
+            vk_cmd_set_depth_write_enable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDepthWriteEnableEXT"));
+            vk_cmd_set_depth_compare_op = reinterpret_cast<PFN_vkCmdSetDepthCompareOp>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDepthCompareOpEXT"));
+            vk_cmd_set_depth_bounds_test_enable = reinterpret_cast<PFN_vkCmdSetDepthBoundsTestEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDepthBoundsTestEnableEXT"));
+            vk_cmd_set_stencil_test_enable = reinterpret_cast<PFN_vkCmdSetStencilTestEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetStencilTestEnableEXT"));
+            vk_cmd_set_rasterizer_discard_enable = reinterpret_cast<PFN_vkCmdSetRasterizerDiscardEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetRasterizerDiscardEnableEXT"));
+            vk_cmd_set_depth_bias_enable = reinterpret_cast<PFN_vkCmdSetDepthBiasEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDepthBiasEnableEXT"));
+            vk_cmd_set_primitive_restart_enable = reinterpret_cast<PFN_vkCmdSetPrimitiveRestartEnable>(vkGetDeviceProcAddr(vk_device, "vkCmdSetPrimitiveRestartEnableEXT"));
+            vk_cmd_set_polygon_mode = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetPolygonModeEXT"));
+            vk_cmd_set_rasterization_samples = reinterpret_cast<PFN_vkCmdSetRasterizationSamplesEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetRasterizationSamplesEXT"));
+            vk_cmd_set_sample_mask = reinterpret_cast<PFN_vkCmdSetSampleMaskEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetSampleMaskEXT"));
+            vk_cmd_set_alpha_to_coverage_enable = reinterpret_cast<PFN_vkCmdSetAlphaToCoverageEnableEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetAlphaToCoverageEnableEXT"));
+            vk_cmd_set_alpha_to_one_enable = reinterpret_cast<PFN_vkCmdSetAlphaToOneEnableEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetAlphaToOneEnableEXT"));
+            vk_cmd_set_logic_op_enable = reinterpret_cast<PFN_vkCmdSetLogicOpEnableEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetLogicOpEnableEXT"));
+            vk_cmd_set_depth_clamp_enable = reinterpret_cast<PFN_vkCmdSetDepthClampEnableEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetDepthClampEnableEXT"));
+            vk_cmd_set_color_blend_enable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetColorBlendEnableEXT"));
+            vk_cmd_set_color_blend_equation = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetColorBlendEquationEXT"));
+            vk_cmd_set_color_write_mask = reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetColorWriteMaskEXT"));
+            vk_cmd_set_vertex_input = reinterpret_cast<PFN_vkCmdSetVertexInputEXT>(vkGetDeviceProcAddr(vk_device, "vkCmdSetVertexInputEXT"));
+
+            if(vk_create_shaders == nullptr
+            || vk_destroy_shader == nullptr
+            || vk_cmd_bind_shaders == nullptr
+            || vk_cmd_set_viewport_with_count == nullptr
+            || vk_cmd_set_scissor_with_count == nullptr
+            || vk_cmd_set_primitive_topology == nullptr
+            || vk_cmd_set_cull_mode == nullptr
+            || vk_cmd_set_front_face == nullptr
+            || vk_cmd_set_depth_test_enable == nullptr
+            || vk_cmd_set_depth_write_enable == nullptr
+            || vk_cmd_set_depth_compare_op == nullptr
+            || vk_cmd_set_depth_bounds_test_enable == nullptr
+            || vk_cmd_set_stencil_test_enable == nullptr
+            || vk_cmd_set_rasterizer_discard_enable == nullptr
+            || vk_cmd_set_depth_bias_enable == nullptr
+            || vk_cmd_set_primitive_restart_enable == nullptr
+            || vk_cmd_set_polygon_mode == nullptr
+            || vk_cmd_set_rasterization_samples == nullptr
+            || vk_cmd_set_sample_mask == nullptr
+            || vk_cmd_set_alpha_to_coverage_enable == nullptr
+            || vk_cmd_set_alpha_to_one_enable == nullptr
+            || vk_cmd_set_logic_op_enable == nullptr
+            || vk_cmd_set_depth_clamp_enable == nullptr
+            || vk_cmd_set_color_blend_enable == nullptr
+            || vk_cmd_set_color_blend_equation == nullptr
+            || vk_cmd_set_color_write_mask == nullptr
+            || vk_cmd_set_vertex_input == nullptr)
+            {
+                Core::Logger::warn("shader object entry points missing, feature disabled");
+                shader_object = false;
+            }
+        }
+    }
+
+    bool VulkanDeviceFeatures::isExtensionSupported(const char* extension_name) const
+    {
+        for(const VkExtensionProperties& vk_extension_properties : m_vk_extension_properties)
+        {
+            if(strcmp(vk_extension_properties.extensionName, extension_name) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+namespace Arieo
+{
+    // Optional device capabilities probed before vkCreateDevice, plus the
+    // entry points that have to be fetched with vkGetDeviceProcAddr because
+    // they may come from either core or an extension.
+    class VulkanDeviceFeatures final
+    {
+    public:
+        void queryPhysicalDevice(VkPhysicalDevice vk_phys_device);
+        void postProcessDeviceCreateInfo(VkDeviceCreateInfo& device_create_info, std::vector<const char*>& extension_names);
+        void loadDeviceFunctions(VkDevice vk_device);
+
+        bool isExtensionSupported(const char* extension_name) const;
+    public:
+        std::uint32_t api_version = VK_API_VERSION_1_0;
+
+        bool synchronization2 = false;
+        bool multi_draw_indirect = false;
+        bool draw_indirect_first_instance = false;
+        bool draw_indirect_count = false;
+        bool descriptor_update_template = false;
+        // Update-after-bind, partially bound, non-uniformly indexed descriptor arrays for the bindless heap
+        bool descriptor_indexing = false;
+        // VK_EXT_descriptor_buffer together with buffer device addresses, 1.2+ only
+        bool descriptor_buffer = false;
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptor_buffer_properties{};
+        // VK_EXT_shader_module_identifier, pipelines can be created from a module identifier and the pipeline cache
+        bool shader_module_identifier = false;
+        VkPhysicalDeviceShaderModuleIdentifierPropertiesEXT shader_module_identifier_properties{};
+        // vkCmdBeginRendering without render pass objects, core in 1.3
+        bool dynamic_rendering = false;
+        // VK_EXT_shader_object, stages bound one by one and every fixed-function state set on the command buffer
+        bool shader_object = false;
+        // VK_EXT_graphics_pipeline_library, pipelines linked from separately compiled parts. Parts are built for
+        // dynamic rendering, so it is only enabled together with dynamic_rendering.
+        bool graphics_pipeline_library = false;
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphics_pipeline_library_properties{};
+        // Pipeline state set on the command buffer, see VulkanCommandBuffer::setRasterState. Cull mode, front face,
+        // topology and depth test are in the first set, rasterizer discard and primitive restart in the second,
+        // both core in 1.3. The third one covers polygon mode and color blending.
+        bool extended_dynamic_state = false;
+        bool extended_dynamic_state2 = false;
+        bool extended_dynamic_state3 = false;
+        // VK_EXT_vertex_input_dynamic_state, the vertex layout is set with VulkanCommandBuffer::setVertexInput
+        bool vertex_input_dynamic_state = false;
+
+        PFN_vkCmdPipelineBarrier2 vk_cmd_pipeline_barrier2 = nullptr;
+        PFN_vkCmdSetEvent2 vk_cmd_set_event2 = nullptr;
+        PFN_vkCmdResetEvent2 vk_cmd_reset_event2 = nullptr;
+        PFN_vkCmdWaitEvents2 vk_cmd_wait_events2 = nullptr;
+        PFN_vkCmdDrawIndirectCount vk_cmd_draw_indirect_count = nullptr;
+        PFN_vkCmdDrawIndexedIndirectCount vk_cmd_draw_indexed_indirect_count = nullptr;
+        PFN_vkCreateDescriptorUpdateTemplate vk_create_descriptor_update_template = nullptr;
+        PFN_vkDestroyDescriptorUpdateTemplate vk_destroy_descriptor_update_template = nullptr;
+        PFN_vkUpdateDescriptorSetWithTemplate vk_update_descriptor_set_with_template = nullptr;
+        PFN_vkGetDescriptorSetLayoutSizeEXT vk_get_descriptor_set_layout_size = nullptr;
+        PFN_vkGetDescriptorSetLayoutBindingOffsetEXT vk_get_descriptor_set_layout_binding_offset = nullptr;
+        PFN_vkGetDescriptorEXT vk_get_descriptor = nullptr;
+        PFN_vkCmdBindDescriptorBuffersEXT vk_cmd_bind_descriptor_buffers = nullptr;
+        PFN_vkCmdSetDescriptorBufferOffsetsEXT vk_cmd_set_descriptor_buffer_offsets = nullptr;
+        PFN_vkGetShaderModuleIdentifierEXT vk_get_shader_module_identifier = nullptr;
+        PFN_vkCmdBeginRendering vk_cmd_begin_rendering = nullptr;
+        PFN_vkCmdEndRendering vk_cmd_end_rendering = nullptr;
+        PFN_vkCreateShadersEXT vk_create_shaders = nullptr;
+        PFN_vkDestroyShaderEXT vk_destroy_shader = nullptr;
+        PFN_vkCmdBindShadersEXT vk_cmd_bind_shaders = nullptr;
+        // Dynamic state setters, exposed by VK_EXT_shader_object as well as the extended dynamic state extensions
+        PFN_vkCmdSetViewportWithCount vk_cmd_set_viewport_with_count = nullptr;
+        PFN_vkCmdSetScissorWithCount vk_cmd_set_scissor_with_count = nullptr;
+        PFN_vkCmdSetPrimitiveTopology vk_cmd_set_primitive_topology = nullptr;
+        PFN_vkCmdSetCullMode vk_cmd_set_cull_mode = nullptr;
+        PFN_vkCmdSetFrontFace vk_cmd_set_front_face = nullptr;
+        PFN_vkCmdSetDepthTestEnable vk_cmd_set_depth_test_enable = nullptr;
+        PFN_vkCmdSetDepthWriteEnable vk_cmd_set_depth_write_enable = nullptr;
+        PFN_vkCmdSetDepthCompareOp vk_cmd_set_depth_compare_op = nullptr;
+        PFN_vkCmdSetDepthBoundsTestEnable vk_cmd_set_depth_bounds_test_enable = nullptr;
+        PFN_vkCmdSetStencilTestEnable vk_cmd_set_stencil_test_enable = nullptr;
+        PFN_vkCmdSetRasterizerDiscardEnable vk_cmd_set_rasterizer_discard_enable = nullptr;
+        PFN_vkCmdSetDepthBiasEnable vk_cmd_set_depth_bias_enable = nullptr;
+        PFN_vkCmdSetPrimitiveRestartEnable vk_cmd_set_primitive_restart_enable = nullptr;
+        PFN_vkCmdSetPolygonModeEXT vk_cmd_set_polygon_mode = nullptr;
+        PFN_vkCmdSetRasterizationSamplesEXT vk_cmd_set_rasterization_samples = nullptr;
+        PFN_vkCmdSetSampleMaskEXT vk_cmd_set_sample_mask = nullptr;
+        PFN_vkCmdSetAlphaToCoverageEnableEXT vk_cmd_set_alpha_to_coverage_enable = nullptr;
+        PFN_vkCmdSetAlphaToOneEnableEXT vk_cmd_set_alpha_to_one_enable = nullptr;
+        PFN_vkCmdSetLogicOpEnableEXT vk_cmd_set_logic_op_enable = nullptr;
+        PFN_vkCmdSetDepthClampEnableEXT vk_cmd_set_depth_clamp_enable = nullptr;
+        PFN_vkCmdSetColorBlendEnableEXT vk_cmd_set_color_blend_enable = nullptr;
+        PFN_vkCmdSetColorBlendEquationEXT vk_cmd_set_color_blend_equation = nullptr;
+        PFN_vkCmdSetColorWriteMaskEXT vk_cmd_set_color_write_mask = nullptr;
+        PFN_vkCmdSetVertexInputEXT vk_cmd_set_vertex_input = nullptr;
+
+        // Core features enabled on the device, some of them add state that shader objects have to set
+        const VkPhysicalDeviceFeatures& getEnabledCoreFeatures() const
+        {
+            return m_vk_enabled_core_features;
+        }
+    private:
+        std::vector<VkExtensionProperties> m_vk_extension_properties;
+
+        // Structures chained into VkDeviceCreateInfo, they have to stay alive until vkCreateDevice returns.
+        VkPhysicalDeviceFeatures m_vk_enabled_core_features{};
+        VkPhysicalDeviceVulkan12Features m_vk_enabled_vulkan12_features{};
+        VkPhysicalDeviceSynchronization2Features m_vk_enabled_synchronization2_features{};
+        VkPhysicalDeviceDescriptorIndexingFeatures m_vk_enabled_descriptor_indexing_features{};
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT m_vk_enabled_descriptor_buffer_features{};
+        VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT m_vk_enabled_shader_module_identifier_features{};
+        VkPhysicalDevicePipelineCreationCacheControlFeatures m_vk_enabled_pipeline_creation_cache_control_features{};
+        VkPhysicalDeviceDynamicRenderingFeatures m_vk_enabled_dynamic_rendering_features{};
+        VkPhysicalDeviceShaderObjectFeaturesEXT m_vk_enabled_shader_object_features{};
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT m_vk_enabled_graphics_pipeline_library_features{};
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT m_vk_enabled_extended_dynamic_state_features{};
+        VkPhysicalDeviceExtendedDynamicState2FeaturesEXT m_vk_enabled_extended_dynamic_state2_features{};
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT m_vk_enabled_extended_dynamic_state3_features{};
+        VkPhysicalDeviceVertexInputDynamicStateFeaturesEXT m_vk_enabled_vertex_input_dynamic_state_features{};
+    };
+}
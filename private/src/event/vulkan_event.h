@@ -0,0 +1,26 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+namespace Arieo
+{
+    class VulkanEvent final
+    {
+    public:
+        VulkanEvent(VkDevice& vk_device, VkEvent&& vk_event)
+            : m_vk_device(vk_device),
+            m_vk_event(std::move(vk_event))
+        {
+
+        }
+    private:
+        friend class VulkanDevice;
+        friend class VulkanCommandBuffer;
+
+        VkDevice& m_vk_device;
+        VkEvent m_vk_event;
+    };
+}
+
+
+
+
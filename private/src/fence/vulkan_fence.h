@@ -26,6 +26,10 @@ namespace Arieo
     private:
         friend class VulkanDevice;
         friend class VulkanRenderCommandQueue;
+        friend class VulkanReadbackManager;
+        friend class VulkanFrameCommandPools;
+        friend class VulkanDescriptorAllocator;
+        friend class VulkanPipelineLibrary;
 
         VkDevice& m_vk_device;
         VkFence m_vk_fence;
@@ -2,15 +2,26 @@
 #pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
+#include <vector>
 namespace Arieo
 {
+    class VulkanImageView;
+
+    // The layout the render pass leaves the attachment in, recorded into the image's layout tracker on endRenderPass.
+    struct VulkanFramebufferAttachment
+    {
+        VulkanImageView* vulkan_image_view;
+        VkImageLayout vk_final_layout;
+    };
+
     class VulkanFramebuffer final
         : public Interface::RHI::IFramebuffer
     {
     public:
-        VulkanFramebuffer(VkFramebuffer&& vk_framebuffer)
+        VulkanFramebuffer(VkFramebuffer&& vk_framebuffer, std::vector<VulkanFramebufferAttachment>&& attachments)
             :
-            m_vk_framebuffer(std::move(vk_framebuffer))
+            m_vk_framebuffer(std::move(vk_framebuffer)),
+            m_attachments(std::move(attachments))
         {
 
         }
@@ -20,6 +31,7 @@ namespace Arieo
         friend class VulkanPresentCommandQueue;
 
         VkFramebuffer m_vk_framebuffer;
+        std::vector<VulkanFramebufferAttachment> m_attachments;
     };
 }
 
@@ -3,25 +3,114 @@
 #include <vulkan.h>
 
 #include <vk_mem_alloc.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include "../common/vulkan_utility.h"
 namespace Arieo
 {
+    struct VulkanImageCreateInfo
+    {
+        std::uint32_t width = 1;
+        std::uint32_t height = 1;
+        std::uint32_t depth = 1;
+        std::uint32_t mip_levels = 1;
+        std::uint32_t array_layers = 1;
+        VkImageType image_type = VK_IMAGE_TYPE_2D;
+        // Requires a 2D image with a multiple of 6 array layers.
+        bool is_cube = false;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+        Interface::RHI::Format format = Interface::RHI::Format::UNKNOWN;
+        Interface::RHI::ImageAspectFlags aspect = Interface::RHI::ImageAspectFlags::COLOR_BIT;
+        Interface::RHI::ImageTiling tiling = Interface::RHI::ImageTiling::OPTIMAL;
+        Interface::RHI::ImageUsageFlags usage = Interface::RHI::ImageUsageFlags::SAMPLED_BIT;
+        Interface::RHI::MemoryUsage memory_usage = Interface::RHI::MemoryUsage::AUTO;
+
+        // Additional formats views may reinterpret the image as, they must be size-compatible with format.
+        std::vector<VkFormat> view_formats;
+    };
+
+    struct VulkanBufferImageCopyRegion
+    {
+        VkDeviceSize buffer_offset = 0;
+        // Row pitch and slice height of the buffer data in texels, 0 means tightly packed.
+        std::uint32_t buffer_row_length = 0;
+        std::uint32_t buffer_image_height = 0;
+
+        VkOffset3D image_offset = {0, 0, 0};
+        // 0 in any dimension means the rest of the mip level from image_offset.
+        VkExtent3D image_extent = {0, 0, 0};
+        std::uint32_t mip_level = 0;
+        std::uint32_t base_array_layer = 0;
+        std::uint32_t layer_count = 1;
+    };
+
+    struct VulkanImageViewKey
+    {
+        VkFormat format;
+        VkImageViewType view_type;
+        VkImageSubresourceRange subresource_range;
+
+        bool operator==(const VulkanImageViewKey& other) const
+        {
+            return format == other.format
+                && view_type == other.view_type
+                && subresource_range.aspectMask == other.subresource_range.aspectMask
+                && subresource_range.baseMipLevel == other.subresource_range.baseMipLevel
+                && subresource_range.levelCount == other.subresource_range.levelCount
+                && subresource_range.baseArrayLayer == other.subresource_range.baseArrayLayer
+                && subresource_range.layerCount == other.subresource_range.layerCount;
+        }
+    };
+
+    struct VulkanImageViewKeyHash
+    {
+        size_t operator()(const VulkanImageViewKey& key) const
+        {
+            size_t hash = std::hash<std::uint32_t>()(key.format);
+            auto combine = [&hash](std::uint32_t value)
+            {
+                hash ^= std::hash<std::uint32_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            };
+            combine(key.view_type);
+            combine(key.subresource_range.aspectMask);
+            combine(key.subresource_range.baseMipLevel);
+            combine(key.subresource_range.levelCount);
+            combine(key.subresource_range.baseArrayLayer);
+            combine(key.subresource_range.layerCount);
+            return hash;
+        }
+    };
+
     class VulkanImage;
     class VulkanImageView final
         : public Interface::RHI::IImageView
     {
     public:
-        VulkanImageView(VulkanImage& vulkan_image, VkImageView&& vk_image_view)
+        VulkanImageView(VulkanImage& vulkan_image, VkImageView&& vk_image_view, const VulkanImageViewKey& view_key)
             : 
             m_vulkan_image(vulkan_image),
-            m_vk_image_view(std::move(vk_image_view))
+            m_vk_image_view(std::move(vk_image_view)),
+            m_vk_format(view_key.format),
+            m_vk_view_type(view_key.view_type),
+            m_vk_subresource_range(view_key.subresource_range)
         {
 
         }
+
+        // Extent of the base mip level of the view.
+        VkExtent3D getExtent() const;
     private:
         friend class VulkanDevice;
         friend class VulkanDescriptorSet;
+        friend class VulkanImage;
+        friend class VulkanCommandBuffer;
         VulkanImage& m_vulkan_image;
         VkImageView m_vk_image_view;
+        VkFormat m_vk_format;
+        VkImageViewType m_vk_view_type;
+        VkImageSubresourceRange m_vk_subresource_range;
     };
 
     class VulkanImageSampler final
@@ -46,15 +135,28 @@ namespace Arieo
         : public Interface::RHI::IImage
     {
     public:
-        VulkanImage(VkImage&& vk_image, VkImageView&& vk_image_view, VkSampler&& vk_sampler, VmaAllocation&& vma_allocation, VmaAllocationInfo&& vma_allocation_info, VkExtent3D image_extent, VkFormat image_format)
+        VulkanImage(
+            VkDevice& vk_device,
+            VkImage&& vk_image, VkSampler&& vk_sampler, 
+            VmaAllocation&& vma_allocation, VmaAllocationInfo&& vma_allocation_info, 
+            VkExtent3D image_extent, VkFormat image_format,
+            std::uint32_t mip_levels, std::uint32_t array_layers, 
+            VkImageViewType image_view_type, VkSampleCountFlagBits samples, VkImageAspectFlags aspect_mask,
+            std::vector<VkFormat>&& view_formats)
             : 
-            // m_vk_device(vk_device),
+            m_vk_device(vk_device),
             m_vma_allocation(std::move(vma_allocation)),
             m_vma_allocation_info(std::move(vma_allocation_info)),
             m_vk_image_extent(image_extent),
             m_vk_image_format(image_format),
+            m_mip_levels(mip_levels),
+            m_array_layers(array_layers),
+            m_vk_image_view_type(image_view_type),
+            m_vk_samples(samples),
+            m_vk_aspect_mask(aspect_mask),
             m_vk_image(std::move(vk_image)),
-            m_vulkan_image_view(*this, std::move(vk_image_view)),
+            m_vk_subresource_layouts(static_cast<size_t>(mip_levels) * array_layers, VK_IMAGE_LAYOUT_UNDEFINED),
+            m_vk_view_formats(std::move(view_formats)),
             m_vulkan_image_sampler(std::move(vk_sampler))
         {
             
@@ -67,29 +169,244 @@ namespace Arieo
 
         Base::Interop::RawRef<Interface::RHI::IImageView> getImageView() override
         {
-            return m_vulkan_image_view.queryInterface<Interface::RHI::IImageView>();
+            return getImageView(getDefaultViewKey());
+        }
+
+        // Views over any subresource range, or reinterpreted with one of the view formats given at creation.
+        // They are created on first request and cached until the image is destroyed.
+        Base::Interop::RawRef<Interface::RHI::IImageView> getImageView(const VkImageSubresourceRange& subresource_range, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED)
+        {
+            VulkanImageViewKey view_key;
+            view_key.format = format == VK_FORMAT_UNDEFINED ? m_vk_image_format : format;
+            view_key.view_type = view_type;
+            view_key.subresource_range = subresource_range;
+            return getImageView(view_key);
+        }
+
+        // Single mip/layer view, e.g. a render target for one shadow cascade or one bloom level.
+        Base::Interop::RawRef<Interface::RHI::IImageView> getImageView(std::uint32_t mip_level, std::uint32_t array_layer)
+        {
+            VulkanImageViewKey view_key;
+            view_key.format = m_vk_image_format;
+            view_key.view_type = m_vk_image_view_type == VK_IMAGE_VIEW_TYPE_3D ? VK_IMAGE_VIEW_TYPE_3D
+                : (m_vk_image_view_type == VK_IMAGE_VIEW_TYPE_1D || m_vk_image_view_type == VK_IMAGE_VIEW_TYPE_1D_ARRAY) ? VK_IMAGE_VIEW_TYPE_1D
+                : VK_IMAGE_VIEW_TYPE_2D;
+            view_key.subresource_range.aspectMask = m_vk_aspect_mask;
+            view_key.subresource_range.baseMipLevel = mip_level;
+            view_key.subresource_range.levelCount = 1;
+            view_key.subresource_range.baseArrayLayer = array_layer;
+            view_key.subresource_range.layerCount = 1;
+            return getImageView(view_key);
         }
 
         Base::Interop::RawRef<Interface::RHI::IImageSampler> getImageSampler() override
         {
             return m_vulkan_image_sampler.queryInterface<Interface::RHI::IImageSampler>();
         }
+
+        VkExtent3D getMipExtent(std::uint32_t mip_level) const
+        {
+            return {
+                std::max(1u, m_vk_image_extent.width >> mip_level),
+                std::max(1u, m_vk_image_extent.height >> mip_level),
+                std::max(1u, m_vk_image_extent.depth >> mip_level)
+            };
+        }
+
+        // Logs an error and returns false when the range is empty or leaves the image's mip levels or array layers.
+        bool isSubresourceRangeValid(std::uint32_t mip_level, std::uint32_t base_array_layer, std::uint32_t layer_count) const
+        {
+            if(mip_level >= m_mip_levels
+            || layer_count == 0
+            || base_array_layer >= m_array_layers
+            || layer_count > m_array_layers - base_array_layer)
+            {
+                Core::Logger::error("Image subresource mip {} layers {}+{} is out of range, the image has {} mip levels and {} array layers",
+                    mip_level, base_array_layer, layer_count, m_mip_levels, m_array_layers);
+                return false;
+            }
+            return true;
+        }
+
+        // Extent a copy region covers, zero dimensions resolved to the rest of the mip level. Only meaningful for
+        // regions isCopyRegionValid accepts.
+        VkExtent3D getCopyExtent(const VulkanBufferImageCopyRegion& region) const
+        {
+            VkExtent3D mip_extent = getMipExtent(region.mip_level);
+            return {
+                region.image_extent.width != 0 ? region.image_extent.width : mip_extent.width - static_cast<std::uint32_t>(region.image_offset.x),
+                region.image_extent.height != 0 ? region.image_extent.height : mip_extent.height - static_cast<std::uint32_t>(region.image_offset.y),
+                region.image_extent.depth != 0 ? region.image_extent.depth : mip_extent.depth - static_cast<std::uint32_t>(region.image_offset.z)
+            };
+        }
+
+        // Logs an error and returns false when the subresources are out of range or the offset and extent leave the
+        // mip level. The one check behind every buffer/image copy.
+        bool isCopyRegionValid(const VulkanBufferImageCopyRegion& region) const
+        {
+            if(isSubresourceRangeValid(region.mip_level, region.base_array_layer, region.layer_count) == false)
+            {
+                return false;
+            }
+            VkExtent3D mip_extent = getMipExtent(region.mip_level);
+            auto is_axis_valid = [](std::int32_t offset, std::uint32_t extent, std::uint32_t mip_size)
+            {
+                // 0 extends to the end of the mip level, which needs the offset inside it
+                std::int64_t end = static_cast<std::int64_t>(offset) + (extent != 0 ? extent : 1);
+                return offset >= 0 && end <= static_cast<std::int64_t>(mip_size);
+            };
+            if(is_axis_valid(region.image_offset.x, region.image_extent.width, mip_extent.width) == false
+            || is_axis_valid(region.image_offset.y, region.image_extent.height, mip_extent.height) == false
+            || is_axis_valid(region.image_offset.z, region.image_extent.depth, mip_extent.depth) == false)
+            {
+                Core::Logger::error("Copy region {},{},{} + {}x{}x{} leaves mip {} of extent {}x{}x{}",
+                    region.image_offset.x, region.image_offset.y, region.image_offset.z,
+                    region.image_extent.width, region.image_extent.height, region.image_extent.depth,
+                    region.mip_level, mip_extent.width, mip_extent.height, mip_extent.depth);
+                return false;
+            }
+            return true;
+        }
+
+        // Layouts as last recorded by the VulkanCommandBuffer copy helpers, render passes and beginRendering, in
+        // recording order. Out of range subresources read as undefined.
+        VkImageLayout getSubresourceLayout(std::uint32_t mip_level, std::uint32_t array_layer) const
+        {
+            if(isSubresourceRangeValid(mip_level, array_layer, 1) == false)
+            {
+                return VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+            return m_vk_subresource_layouts[static_cast<size_t>(array_layer) * m_mip_levels + mip_level];
+        }
+
+        void setSubresourceLayout(std::uint32_t mip_level, std::uint32_t array_layer, VkImageLayout vk_image_layout)
+        {
+            if(isSubresourceRangeValid(mip_level, array_layer, 1) == false)
+            {
+                return;
+            }
+            m_vk_subresource_layouts[static_cast<size_t>(array_layer) * m_mip_levels + mip_level] = vk_image_layout;
+        }
+
+        // Remaining level and layer counts are resolved against the image.
+        void setSubresourceRangeLayout(const VkImageSubresourceRange& subresource_range, VkImageLayout vk_image_layout)
+        {
+            std::uint32_t level_count = subresource_range.levelCount == VK_REMAINING_MIP_LEVELS ? m_mip_levels - subresource_range.baseMipLevel : subresource_range.levelCount;
+            std::uint32_t layer_count = subresource_range.layerCount == VK_REMAINING_ARRAY_LAYERS ? m_array_layers - subresource_range.baseArrayLayer : subresource_range.layerCount;
+            for(std::uint32_t mip_level = subresource_range.baseMipLevel; mip_level < subresource_range.baseMipLevel + level_count; mip_level++)
+            {
+                for(std::uint32_t array_layer = subresource_range.baseArrayLayer; array_layer < subresource_range.baseArrayLayer + layer_count; array_layer++)
+                {
+                    setSubresourceLayout(mip_level, array_layer, vk_image_layout);
+                }
+            }
+        }
+
+        // Texture and sampler index in the bindless heap, UINT32_MAX when not registered.
+        std::uint32_t getBindlessIndex() const
+        {
+            return m_bindless_index;
+        }
     private:
         friend class VulkanDevice;
         friend class VulkanCommandBuffer;
         friend class VulkanDescriptorSet;
+        friend class VulkanBarrierBatch;
+        friend class VulkanReadbackManager;
+        friend class VulkanDescriptorSetResources;
+
+        VulkanImageViewKey getDefaultViewKey() const
+        {
+            VulkanImageViewKey view_key;
+            view_key.format = m_vk_image_format;
+            view_key.view_type = m_vk_image_view_type;
+            view_key.subresource_range.aspectMask = m_vk_aspect_mask;
+            view_key.subresource_range.baseMipLevel = 0;
+            view_key.subresource_range.levelCount = m_mip_levels;
+            view_key.subresource_range.baseArrayLayer = 0;
+            view_key.subresource_range.layerCount = m_array_layers;
+            return view_key;
+        }
+
+        Base::Interop::RawRef<Interface::RHI::IImageView> getImageView(const VulkanImageViewKey& view_key)
+        {
+            std::lock_guard<std::mutex> lock(m_image_view_mutex);
+            auto found_iter = m_image_view_map.find(view_key);
+            if(found_iter != m_image_view_map.end())
+            {
+                return found_iter->second;
+            }
+
+            if(view_key.format != m_vk_image_format
+            && std::find(m_vk_view_formats.begin(), m_vk_view_formats.end(), view_key.format) == m_vk_view_formats.end())
+            {
+                Core::Logger::error("Image view format {} was not declared as a view format of the image", (std::uint32_t)view_key.format);
+                return nullptr;
+            }
+
+            VkImageViewCreateInfo view_info{};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = m_vk_image;
+            view_info.viewType = view_key.view_type;
+            view_info.format = view_key.format;
+            view_info.subresourceRange = view_key.subresource_range;
+
+            VkImageView vk_image_view;
+            VkResult result = vkCreateImageView(m_vk_device, &view_info, nullptr, &vk_image_view);
+            if(result != VK_SUCCESS)
+            {
+                Core::Logger::error("ImageView create failed: {}", VulkanUtility::covertVkResultToString(result));
+                return nullptr;
+            }
+
+            return addImageView(std::move(vk_image_view), view_key);
+        }
+
+        // Adopts an externally created view, used for swapchain images.
+        Base::Interop::RawRef<Interface::RHI::IImageView> addImageView(VkImageView&& vk_image_view, const VulkanImageViewKey& view_key)
+        {
+            Base::Interop::RawRef<Interface::RHI::IImageView> image_view = Base::Interop::RawRef<Interface::RHI::IImageView>::createAs<VulkanImageView>(*this, std::move(vk_image_view), view_key);
+            m_image_view_map.emplace(view_key, image_view);
+            return image_view;
+        }
+
+        void destroyImageViews()
+        {
+            std::lock_guard<std::mutex> lock(m_image_view_mutex);
+            for(auto& [view_key, image_view] : m_image_view_map)
+            {
+                vkDestroyImageView(m_vk_device, image_view.castToInstance<VulkanImageView>()->m_vk_image_view, nullptr);
+                Base::Interop::RawRef<Interface::RHI::IImageView>::destroyAs<VulkanImageView>(std::move(image_view));
+            }
+            m_image_view_map.clear();
+        }
 
-        // VkDevice& m_vk_device;
+        VkDevice& m_vk_device;
         VmaAllocation m_vma_allocation;
         VmaAllocationInfo m_vma_allocation_info;
 
         VkExtent3D m_vk_image_extent;
         VkFormat m_vk_image_format;
+        std::uint32_t m_mip_levels;
+        std::uint32_t m_array_layers;
+        VkImageViewType m_vk_image_view_type;
+        VkSampleCountFlagBits m_vk_samples;
+        VkImageAspectFlags m_vk_aspect_mask;
         VkImage m_vk_image;
-        
-        Base::Interop::Instance<VulkanImageView> m_vulkan_image_view;
+
+        std::vector<VkImageLayout> m_vk_subresource_layouts;
+        std::vector<VkFormat> m_vk_view_formats;
+
+        std::mutex m_image_view_mutex;
+        std::unordered_map<VulkanImageViewKey, Base::Interop::RawRef<Interface::RHI::IImageView>, VulkanImageViewKeyHash> m_image_view_map;
         Base::Interop::Instance<VulkanImageSampler> m_vulkan_image_sampler;
+        std::uint32_t m_bindless_index = UINT32_MAX;
     };
+
+    inline VkExtent3D VulkanImageView::getExtent() const
+    {
+        return m_vulkan_image.getMipExtent(m_vk_subresource_range.baseMipLevel);
+    }
 }
 
 
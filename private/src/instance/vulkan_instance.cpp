@@ -23,7 +23,7 @@ namespace Arieo
             .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
             .pEngineName = "Arieo Engine",
             .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-            .apiVersion = VK_API_VERSION_1_0
+            .apiVersion = VK_API_VERSION_1_3
         };
 
         std::vector<const char*> extension_names;
@@ -260,6 +260,9 @@ namespace Arieo
 
         VkPhysicalDevice vk_selected_phys_device = vk_phys_devices[hardware_index];
 
+        VulkanDeviceFeatures vulkan_device_features;
+        vulkan_device_features.queryPhysicalDevice(vk_selected_phys_device);
+
         // Create logical device
         VkDevice vk_device;
         // Find graphics and present queue families
@@ -376,6 +379,7 @@ namespace Arieo
             device_create_info.pQueueCreateInfos = queue_create_info_array.data();
             device_create_info.pEnabledFeatures = &device_features;
 
+            vulkan_device_features.postProcessDeviceCreateInfo(device_create_info, device_extensions);
             postProcessDeviceCreateInfo(device_create_info, device_extensions);
 
             device_create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
@@ -392,6 +396,8 @@ namespace Arieo
             {
                 Core::Logger::trace("Vulkan CreateDevice ok");
             }
+
+            vulkan_device_features.loadDeviceFunctions(vk_device);
         }
 
         VkQueue graphics_queue;
@@ -407,6 +413,12 @@ namespace Arieo
             allocator_info.physicalDevice = vk_selected_phys_device;
             allocator_info.device = vk_device;
             allocator_info.instance = m_vk_instance;
+            if(vulkan_device_features.descriptor_buffer)
+            {
+                // Descriptor buffers and the buffers they point at need device addresses
+                allocator_info.vulkanApiVersion = VK_API_VERSION_1_2;
+                allocator_info.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+            }
 
             VkResult result = vmaCreateAllocator(&allocator_info, &vma_allocator);
             if(result != VK_SUCCESS)
@@ -420,14 +432,28 @@ namespace Arieo
             }
         }
 
+        VkPipelineCache vk_pipeline_cache;
+        {
+            VkPipelineCacheCreateInfo pipeline_cache_info{};
+            pipeline_cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            VkResult result = vkCreatePipelineCache(vk_device, &pipeline_cache_info, nullptr, &vk_pipeline_cache);
+            if(result != VK_SUCCESS)
+            {
+                Core::Logger::error("Vulkan pipeline cache create failed: {}", VulkanUtility::covertVkResultToString(result));
+                return nullptr;
+            }
+        }
+
         return Base::Interop::RawRef<Interface::RHI::IRenderDevice>::createAs<VulkanDevice>(
             std::move(vk_selected_phys_device),
             std::move(vk_device),
             std::move(vma_allocator),
+            std::move(vulkan_device_features),
             graphics_queue_family_index,
             present_queue_family_index, 
             std::move(graphics_queue), 
-            std::move(present_queue)
+            std::move(present_queue),
+            std::move(vk_pipeline_cache)
         );
     }
 
@@ -435,7 +461,11 @@ namespace Arieo
     {
         VulkanDevice* vulkan_device = device.castToInstance<VulkanDevice>();
 
+        vulkan_device->m_descriptor_set_cache.clear();
+        vulkan_device->destroyBindlessHeap();
+        vulkan_device->destroyShaderOptimizer();
         vmaDestroyAllocator(vulkan_device->m_vma_allocator);
+        vkDestroyPipelineCache(vulkan_device->m_vk_device, vulkan_device->m_vk_pipeline_cache, nullptr);
 
         vkDestroyDevice(vulkan_device->m_vk_device, nullptr);
         Base::Interop::RawRef<Interface::RHI::IRenderDevice>::destroyAs<VulkanDevice>(std::move(device));
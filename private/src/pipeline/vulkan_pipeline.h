@@ -1,32 +1,262 @@
 #pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 namespace Arieo
 {
+    class VulkanPipelineLibrary;
+
+    // Specialization constant values of one shader stage, kept sorted by constant id.
+    // Values must match the declared type size: 4 bytes for bool, int, uint and float, 8 for 64 bit types.
+    struct VulkanSpecialization
+    {
+        std::vector<VkSpecializationMapEntry> map_entries;
+        std::vector<std::uint8_t> data;
+
+        template<typename T>
+        VulkanSpecialization& set(std::uint32_t constant_id, T value)
+        {
+            static_assert(std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "Specialization constants are 32 or 64 bit scalars");
+            auto entry_iter = std::lower_bound(map_entries.begin(), map_entries.end(), constant_id,
+                [](const VkSpecializationMapEntry& map_entry, std::uint32_t id) { return map_entry.constantID < id; });
+            if(entry_iter != map_entries.end() && entry_iter->constantID == constant_id)
+            {
+                if(entry_iter->size == sizeof(T))
+                {
+                    std::memcpy(data.data() + entry_iter->offset, &value, sizeof(T));
+                    return *this;
+                }
+                // Size changed, the old value is dropped and the later offsets move down
+                std::uint32_t removed_offset = entry_iter->offset;
+                std::uint32_t removed_size = static_cast<std::uint32_t>(entry_iter->size);
+                data.erase(data.begin() + removed_offset, data.begin() + removed_offset + removed_size);
+                entry_iter = map_entries.erase(entry_iter);
+                for(VkSpecializationMapEntry& map_entry : map_entries)
+                {
+                    if(map_entry.offset > removed_offset)
+                    {
+                        map_entry.offset -= removed_size;
+                    }
+                }
+            }
+
+            VkSpecializationMapEntry map_entry{};
+            map_entry.constantID = constant_id;
+            map_entry.offset = static_cast<std::uint32_t>(data.size());
+            map_entry.size = sizeof(T);
+            data.resize(data.size() + sizeof(T));
+            std::memcpy(data.data() + map_entry.offset, &value, sizeof(T));
+            map_entries.insert(entry_iter, map_entry);
+            return *this;
+        }
+
+        VulkanSpecialization& set(std::uint32_t constant_id, bool value)
+        {
+            return set(constant_id, static_cast<VkBool32>(value ? VK_TRUE : VK_FALSE));
+        }
+
+        bool empty() const
+        {
+            return map_entries.empty();
+        }
+
+        // Points into this object, it has to outlive the pipeline creation.
+        VkSpecializationInfo getInfo() const
+        {
+            VkSpecializationInfo specialization_info{};
+            specialization_info.mapEntryCount = static_cast<std::uint32_t>(map_entries.size());
+            specialization_info.pMapEntries = map_entries.data();
+            specialization_info.dataSize = data.size();
+            specialization_info.pData = data.data();
+            return specialization_info;
+        }
+
+        // Appends the ids and values, independent of the order they were set in.
+        void appendKey(std::vector<std::uint8_t>& key) const
+        {
+            std::uint32_t entry_count = static_cast<std::uint32_t>(map_entries.size());
+            key.insert(key.end(), reinterpret_cast<const std::uint8_t*>(&entry_count), reinterpret_cast<const std::uint8_t*>(&entry_count + 1));
+            for(const VkSpecializationMapEntry& map_entry : map_entries)
+            {
+                std::uint32_t entry_key[2] = {map_entry.constantID, static_cast<std::uint32_t>(map_entry.size)};
+                key.insert(key.end(), reinterpret_cast<const std::uint8_t*>(entry_key), reinterpret_cast<const std::uint8_t*>(entry_key + 2));
+                key.insert(key.end(), data.begin() + map_entry.offset, data.begin() + map_entry.offset + map_entry.size);
+            }
+        }
+    };
+
+    // Vertex input of a pipeline, any number of buffers bound per vertex or per instance.
+    // Attributes may use packed formats such as R16G16B16A16_SFLOAT, A2B10G10R10_SNORM_PACK32 or R8G8B8A8_UNORM.
+    struct VulkanVertexLayout
+    {
+        std::vector<VkVertexInputBindingDescription> bindings;
+        std::vector<VkVertexInputAttributeDescription> attributes;
+
+        VulkanVertexLayout& addBinding(std::uint32_t binding, std::uint32_t stride, VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX)
+        {
+            VkVertexInputBindingDescription binding_desc{};
+            binding_desc.binding = binding;
+            binding_desc.stride = stride;
+            binding_desc.inputRate = input_rate;
+            bindings.emplace_back(binding_desc);
+            return *this;
+        }
+
+        VulkanVertexLayout& addAttribute(std::uint32_t location, std::uint32_t binding, VkFormat format, std::uint32_t offset)
+        {
+            VkVertexInputAttributeDescription attribute_desc{};
+            attribute_desc.location = location;
+            attribute_desc.binding = binding;
+            attribute_desc.format = format;
+            attribute_desc.offset = offset;
+            attributes.emplace_back(attribute_desc);
+            return *this;
+        }
+    };
+
+    // Fixed-function state of one color and one depth attachment. Set on the command buffer for shader object
+    // pipelines; pipelines bake it except for the parts the device's extended dynamic state features cover, those
+    // are recorded at bind time and can be changed afterwards, see VulkanCommandBuffer::setRasterState.
+    struct VulkanRasterState
+    {
+        VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cull_mode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        bool rasterizer_discard_enable = false;
+        // Needs a strip or fan topology, or the primitiveTopologyListRestart feature
+        bool primitive_restart_enable = false;
+
+        bool depth_test_enable = true;
+        bool depth_write_enable = true;
+        VkCompareOp depth_compare_op = VK_COMPARE_OP_LESS;
+
+        bool blend_enable = false;
+        VkColorBlendEquationEXT blend_equation{
+            VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+            VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD
+        };
+        VkColorComponentFlags color_write_mask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        bool operator==(const VulkanRasterState& other) const
+        {
+            return polygon_mode == other.polygon_mode
+                && cull_mode == other.cull_mode
+                && front_face == other.front_face
+                && rasterizer_discard_enable == other.rasterizer_discard_enable
+                && primitive_restart_enable == other.primitive_restart_enable
+                && depth_test_enable == other.depth_test_enable
+                && depth_write_enable == other.depth_write_enable
+                && depth_compare_op == other.depth_compare_op
+                && blend_enable == other.blend_enable
+                && std::memcmp(&blend_equation, &other.blend_equation, sizeof(VkColorBlendEquationEXT)) == 0
+                && color_write_mask == other.color_write_mask;
+        }
+    };
+
+    struct VulkanGraphicsPipelineDesc
+    {
+        Base::Interop::RawRef<Interface::RHI::IShader> vert_shader;
+        Base::Interop::RawRef<Interface::RHI::IShader> frag_shader;
+        Base::Interop::RawRef<Interface::RHI::IImageView> target_color_attachment;
+        Base::Interop::RawRef<Interface::RHI::IImageView> target_depth_attachment;
+
+        VulkanVertexLayout vertex_layout;
+        // Constants folded into the stages at pipeline creation, see VulkanDevice::getPipelineVariant
+        VulkanSpecialization vert_specialization;
+        VulkanSpecialization frag_specialization;
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VulkanRasterState raster_state;
+
+        // Offsets and sizes must be multiples of 4, the total must fit maxPushConstantsSize (at least 128 bytes).
+        std::vector<VkPushConstantRange> push_constant_ranges;
+
+        // Bindings per descriptor set index, e.g. set 0 per frame, set 1 per material, set 2 per draw.
+        // *_DYNAMIC buffer types take their offsets at bind time. Left empty, the sets are reflected from the
+        // shaders, as are empty push_constant_ranges and an empty vertex_layout (one interleaved buffer at binding 0).
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> descriptor_set_layouts;
+
+        // Appends the device's bindless heap set after descriptor_set_layouts, see VulkanDevice::enableBindlessHeap.
+        bool use_bindless_heap = false;
+
+        // Sets come from a VulkanDescriptorBufferPool instead of descriptor pools. Needs the descriptor_buffer
+        // feature, no *_DYNAMIC bindings and no bindless heap.
+        bool use_descriptor_buffer = false;
+
+        // Creates one VkShaderEXT per stage instead of a VkPipeline. Needs the shader_object feature, draws have
+        // to be recorded between VulkanCommandBuffer::beginRendering and endRendering instead of a render pass.
+        bool use_shader_objects = false;
+
+        // Builds the pipeline from graphics pipeline library parts cached in this library, then relinks it with
+        // link time optimization in the background. Needs the graphics_pipeline_library feature, draws have to be
+        // recorded between VulkanCommandBuffer::beginRendering and endRendering. Ignored with use_shader_objects.
+        VulkanPipelineLibrary* pipeline_library = nullptr;
+    };
+
     class VulkanPipeline final
         : public Interface::RHI::IPipeline
     {
     public:
         friend class VulkanDevice;
-        VulkanPipeline(VkPipeline&& vk_pipeline, VkPipelineLayout&& vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout, VkRenderPass&& vk_render_pass, VkExtent3D vk_framebuffer_extent)
+        VulkanPipeline(VkPipeline&& vk_pipeline, VkPipelineLayout&& vk_pipeline_layout, std::vector<VkDescriptorSetLayout>&& vk_descriptor_set_layouts, VkRenderPass&& vk_render_pass, VkExtent3D vk_framebuffer_extent, std::vector<VkPushConstantRange> vk_push_constant_ranges, std::vector<std::vector<VkDescriptorSetLayoutBinding>> vk_descriptor_set_bindings, std::uint32_t bindless_set_index = UINT32_MAX, bool is_descriptor_buffer = false)
             : m_vk_pipeline(std::move(vk_pipeline)), 
             m_vk_pipeline_layout(std::move(vk_pipeline_layout)),
             m_vk_render_pass(std::move(vk_render_pass)),
             m_vk_framebuffer_extent(vk_framebuffer_extent),
-            m_vk_descriptor_set_layout(std::move(vk_descriptor_set_layout))
+            m_vk_descriptor_set_layouts(std::move(vk_descriptor_set_layouts)),
+            m_vk_push_constant_ranges(std::move(vk_push_constant_ranges)),
+            m_vk_descriptor_set_bindings(std::move(vk_descriptor_set_bindings)),
+            m_bindless_set_index(bindless_set_index),
+            m_is_descriptor_buffer(is_descriptor_buffer)
         {
 
         }
+
+        // Set index of the bindless heap, UINT32_MAX when the pipeline does not use it.
+        std::uint32_t getBindlessSetIndex() const
+        {
+            return m_bindless_set_index;
+        }
+
+        // No VkPipeline: the stages are bound as shader objects and the state is set on the command buffer.
+        bool isShaderObject() const
+        {
+            return m_vk_shaders[0] != VK_NULL_HANDLE;
+        }
     private:
         friend class VulkanDevice;
         friend class VulkanCommandBuffer;
         friend class VulkanDescriptorPool;
+        friend class VulkanDescriptorAllocator;
+        friend class VulkanDescriptorSetCache;
+        friend class VulkanDescriptorBufferPool;
+        friend class VulkanPipelineLibrary;
 
         VkPipeline m_vk_pipeline;
         VkPipelineLayout m_vk_pipeline_layout;
         VkRenderPass m_vk_render_pass;
+        // Render pass pipelines only: final layout of each framebuffer attachment
+        std::vector<VkImageLayout> m_vk_attachment_final_layouts;
         VkExtent3D m_vk_framebuffer_extent;
-        VkDescriptorSetLayout m_vk_descriptor_set_layout;
+        std::vector<VkDescriptorSetLayout> m_vk_descriptor_set_layouts;
+        std::vector<VkPushConstantRange> m_vk_push_constant_ranges;
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> m_vk_descriptor_set_bindings;
+        // The heap owns that set layout, the pipeline does not destroy it
+        std::uint32_t m_bindless_set_index;
+        bool m_is_descriptor_buffer;
+
+        // Shader object pipelines only: vertex and fragment shader, references in the device shader object cache
+        std::array<VkShaderEXT, 2> m_vk_shaders{};
+        // State recorded when binding, all of it for shader objects, the dynamic parts for pipelines
+        VkPrimitiveTopology m_vk_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VulkanRasterState m_raster_state;
+        VulkanVertexLayout m_vertex_layout;
+
+        // Set while an optimized link of this pipeline is pending, see VulkanPipelineLibrary::beginFrame
+        VulkanPipelineLibrary* m_pipeline_library = nullptr;
     };
 }
 
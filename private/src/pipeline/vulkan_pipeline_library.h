@@ -0,0 +1,297 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "vulkan_pipeline.h"
+#include "vulkan_pipeline_variants.h"
+#include "../fence/vulkan_fence.h"
+#include "../common/vulkan_utility.h"
+
+namespace Arieo
+{
+    // VK_EXT_graphics_pipeline_library parts shared by the pipelines created with this library set in their desc.
+    // Vertex input, pre-rasterization, fragment shader and fragment output are compiled once per distinct state
+    // and fast-linked into pipelines. Each pipeline is then relinked with link time optimization on a background
+    // thread, beginFrame swaps the optimized pipeline in and retires the fast-linked one once the GPU is done.
+    // Pipelines created through a library use dynamic rendering, record them between beginRendering and
+    // endRendering. Destroy the library after its pipelines.
+    class VulkanPipelineLibrary final
+    {
+    public:
+        enum PartType
+        {
+            VERTEX_INPUT,
+            PRE_RASTERIZATION,
+            FRAGMENT_SHADER,
+            FRAGMENT_OUTPUT,
+            PART_TYPE_COUNT
+        };
+
+        // frame_count should match the frames in flight, at least 1: beginFrame cycles through the frame slots.
+        VulkanPipelineLibrary(VkDevice& vk_device, std::uint32_t frame_count)
+            : m_vk_device(vk_device),
+            m_frame_slots(frame_count)
+        {
+            assert(frame_count > 0);
+            m_worker_thread = std::thread(&VulkanPipelineLibrary::runWorker, this);
+        }
+
+        ~VulkanPipelineLibrary()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_task_mutex);
+                m_is_stopping = true;
+            }
+            m_task_condition.notify_all();
+            m_worker_thread.join();
+
+            // Optimized pipelines nobody picked up, their fast-linked pipelines belong to the pipeline objects
+            for(OptimizeJob& optimize_job : m_optimize_jobs)
+            {
+                VkPipeline vk_optimized_pipeline = optimize_job.optimized_pipeline.get();
+                if(vk_optimized_pipeline != VK_NULL_HANDLE)
+                {
+                    vkDestroyPipeline(m_vk_device, vk_optimized_pipeline, nullptr);
+                }
+                optimize_job.vulkan_pipeline->m_pipeline_library = nullptr;
+            }
+            for(FrameSlot& frame_slot : m_frame_slots)
+            {
+                for(VkPipeline vk_retired_pipeline : frame_slot.vk_retired_pipelines)
+                {
+                    vkDestroyPipeline(m_vk_device, vk_retired_pipeline, nullptr);
+                }
+            }
+            for(auto& part_map : m_part_maps)
+            {
+                for(auto& [key, vk_part_pipeline] : part_map)
+                {
+                    vkDestroyPipeline(m_vk_device, vk_part_pipeline, nullptr);
+                }
+            }
+        }
+
+        // frame_fence is the fence this frame will be submitted with, one fence per frame in flight. Call this before
+        // the fence is reset: the slot waits for the fence of its previous frame, a reset fence would never signal.
+        // Call it while no command buffer is recording with the library's pipelines, their VkPipeline may change here.
+        void beginFrame(Base::Interop::RawRef<Interface::RHI::IFence> frame_fence)
+        {
+            m_frame_index = (m_frame_index + 1) % m_frame_slots.size();
+            FrameSlot& frame_slot = m_frame_slots[m_frame_index];
+            if(frame_slot.vk_fence != VK_NULL_HANDLE)
+            {
+                vkWaitForFences(m_vk_device, 1, &frame_slot.vk_fence, VK_TRUE, UINT64_MAX);
+            }
+            for(VkPipeline vk_retired_pipeline : frame_slot.vk_retired_pipelines)
+            {
+                vkDestroyPipeline(m_vk_device, vk_retired_pipeline, nullptr);
+            }
+            frame_slot.vk_retired_pipelines.clear();
+            frame_slot.vk_fence = frame_fence.castToInstance<VulkanFence>()->m_vk_fence;
+
+            // Earlier frames may still use the fast-linked pipelines, they go with this frame's fence
+            std::lock_guard<std::mutex> lock(m_task_mutex);
+            for(auto job_iter = m_optimize_jobs.begin(); job_iter != m_optimize_jobs.end();)
+            {
+                if(job_iter->optimized_pipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    ++job_iter;
+                    continue;
+                }
+                VkPipeline vk_optimized_pipeline = job_iter->optimized_pipeline.get();
+                if(vk_optimized_pipeline != VK_NULL_HANDLE)
+                {
+                    frame_slot.vk_retired_pipelines.emplace_back(job_iter->vulkan_pipeline->m_vk_pipeline);
+                    job_iter->vulkan_pipeline->m_vk_pipeline = vk_optimized_pipeline;
+                    m_optimized_count++;
+                }
+                job_iter->vulkan_pipeline->m_pipeline_library = nullptr;
+                job_iter = m_optimize_jobs.erase(job_iter);
+            }
+        }
+
+        size_t getPartCount(PartType part_type)
+        {
+            std::lock_guard<std::mutex> lock(m_part_mutex);
+            return m_part_maps[part_type].size();
+        }
+
+        size_t getPendingOptimizeCount()
+        {
+            std::lock_guard<std::mutex> lock(m_task_mutex);
+            return m_optimize_jobs.size();
+        }
+
+        std::uint64_t getHitCount() const { return m_hit_count; }
+        std::uint64_t getMissCount() const { return m_miss_count; }
+        std::uint64_t getOptimizedCount() const { return m_optimized_count; }
+    private:
+        friend class VulkanDevice;
+
+        struct OptimizeJob
+        {
+            VulkanPipeline* vulkan_pipeline;
+            std::future<VkPipeline> optimized_pipeline;
+        };
+
+        struct QueuedTask
+        {
+            VulkanPipeline* vulkan_pipeline;
+            std::packaged_task<VkPipeline()> task;
+        };
+
+        struct FrameSlot
+        {
+            std::vector<VkPipeline> vk_retired_pipelines;
+            VkFence vk_fence = VK_NULL_HANDLE;
+        };
+
+        // Only for scalars and Vulkan structures without padding
+        template<typename T>
+        static void appendKey(std::vector<std::uint8_t>& key, const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Key values are copied bytewise");
+            key.insert(key.end(), reinterpret_cast<const std::uint8_t*>(&value), reinterpret_cast<const std::uint8_t*>(&value + 1));
+        }
+
+        static std::uint32_t getTopologyClass(VkPrimitiveTopology vk_topology)
+        {
+            switch(vk_topology)
+            {
+            case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+                return 0;
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+                return 1;
+            case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+                return 3;
+            default:
+                return 2;
+            }
+        }
+
+        // Fast link by default, vk_pipeline_create_flags adds VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT for
+        // the optimized one. Called from the worker thread as well, the pipeline cache is internally synchronized.
+        static VkPipeline linkParts(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkPipelineLayout vk_pipeline_layout, const std::array<VkPipeline, PART_TYPE_COUNT>& vk_part_pipelines, VkPipelineCreateFlags vk_pipeline_create_flags)
+        {
+            VkPipelineLibraryCreateInfoKHR library_info{};
+            library_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+            library_info.libraryCount = static_cast<uint32_t>(vk_part_pipelines.size());
+            library_info.pLibraries = vk_part_pipelines.data();
+
+            VkGraphicsPipelineCreateInfo pipeline_create_info{};
+            pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipeline_create_info.pNext = &library_info;
+            pipeline_create_info.flags = vk_pipeline_create_flags;
+            pipeline_create_info.layout = vk_pipeline_layout;
+            pipeline_create_info.basePipelineIndex = -1;
+
+            VkPipeline vk_pipeline = VK_NULL_HANDLE;
+            VkResult result = vkCreateGraphicsPipelines(vk_device, vk_pipeline_cache, 1, &pipeline_create_info, nullptr, &vk_pipeline);
+            if(result != VK_SUCCESS)
+            {
+                Core::Logger::error("Link pipeline library parts failed: {}", VulkanUtility::covertVkResultToString(result));
+                return VK_NULL_HANDLE;
+            }
+            return vk_pipeline;
+        }
+
+        void runWorker()
+        {
+            while(true)
+            {
+                std::packaged_task<VkPipeline()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_task_mutex);
+                    m_task_condition.wait(lock, [this]() { return m_is_stopping || m_tasks.empty() == false; });
+                    if(m_tasks.empty())
+                    {
+                        return;
+                    }
+                    task = std::move(m_tasks.front().task);
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        void queueOptimize(VulkanPipeline* vulkan_pipeline, std::packaged_task<VkPipeline()>&& task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_task_mutex);
+                m_optimize_jobs.emplace_back(OptimizeJob{vulkan_pipeline, task.get_future()});
+                m_tasks.emplace_back(QueuedTask{vulkan_pipeline, std::move(task)});
+                vulkan_pipeline->m_pipeline_library = this;
+            }
+            m_task_condition.notify_one();
+        }
+
+        // The pipeline is being destroyed: a job that has not started is dropped, a running one is waited for.
+        // Returns the optimized pipeline, if any, to destroy.
+        VkPipeline cancelOptimize(VulkanPipeline* vulkan_pipeline)
+        {
+            std::future<VkPipeline> optimized_pipeline;
+            {
+                std::lock_guard<std::mutex> lock(m_task_mutex);
+                auto job_iter = std::find_if(m_optimize_jobs.begin(), m_optimize_jobs.end(),
+                    [vulkan_pipeline](const OptimizeJob& optimize_job) { return optimize_job.vulkan_pipeline == vulkan_pipeline; });
+                if(job_iter == m_optimize_jobs.end())
+                {
+                    vulkan_pipeline->m_pipeline_library = nullptr;
+                    return VK_NULL_HANDLE;
+                }
+                optimized_pipeline = std::move(job_iter->optimized_pipeline);
+                m_optimize_jobs.erase(job_iter);
+
+                vulkan_pipeline->m_pipeline_library = nullptr;
+                auto task_iter = std::find_if(m_tasks.begin(), m_tasks.end(),
+                    [vulkan_pipeline](const QueuedTask& queued_task) { return queued_task.vulkan_pipeline == vulkan_pipeline; });
+                if(task_iter != m_tasks.end())
+                {
+                    m_tasks.erase(task_iter);
+                    return VK_NULL_HANDLE;
+                }
+            }
+            return optimized_pipeline.get();
+        }
+
+        VkDevice& m_vk_device;
+
+        std::mutex m_part_mutex;
+        std::array<std::unordered_map<std::vector<std::uint8_t>, VkPipeline, VulkanSpecializationKeyHash>, PART_TYPE_COUNT> m_part_maps;
+
+        std::thread m_worker_thread;
+        std::mutex m_task_mutex;
+        std::condition_variable m_task_condition;
+        // Tasks the worker has not started, a task leaves the queue when it starts
+        std::deque<QueuedTask> m_tasks;
+        std::vector<OptimizeJob> m_optimize_jobs;
+        bool m_is_stopping = false;
+
+        std::vector<FrameSlot> m_frame_slots;
+        size_t m_frame_index = static_cast<size_t>(-1);
+
+        // Counted under m_part_mutex, atomic so the getters can read them from any thread
+        std::atomic<std::uint64_t> m_hit_count{0};
+        std::atomic<std::uint64_t> m_miss_count{0};
+        std::uint64_t m_optimized_count = 0;
+    };
+}
+
+
+
+
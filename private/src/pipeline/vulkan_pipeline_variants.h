@@ -0,0 +1,70 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <mutex>
+#include <unordered_map>
+#include "vulkan_pipeline.h"
+
+namespace Arieo
+{
+    struct VulkanSpecializationKeyHash
+    {
+        size_t operator()(const std::vector<std::uint8_t>& key) const
+        {
+            std::uint64_t hash = 14695981039346656037ull;
+            for(std::uint8_t key_byte : key)
+            {
+                hash ^= key_byte;
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    // Pipelines of one base description, one per set of specialization constants. Variants are created on first
+    // use through VulkanDevice::getPipelineVariant and live until the variant set is destroyed. Thread safe.
+    class VulkanPipelineVariants final
+    {
+    public:
+        VulkanPipelineVariants(const VulkanGraphicsPipelineDesc& base_desc)
+            : m_base_desc(base_desc)
+        {
+
+        }
+
+        const VulkanGraphicsPipelineDesc& getBaseDesc() const
+        {
+            return m_base_desc;
+        }
+
+        size_t getSize()
+        {
+            std::lock_guard<std::mutex> lock(m_variant_mutex);
+            return m_pipeline_map.size();
+        }
+
+        std::uint64_t getHitCount() const { return m_hit_count; }
+        std::uint64_t getMissCount() const { return m_miss_count; }
+    private:
+        friend class VulkanDevice;
+
+        static std::vector<std::uint8_t> getKey(const VulkanSpecialization& vert_specialization, const VulkanSpecialization& frag_specialization)
+        {
+            std::vector<std::uint8_t> key;
+            vert_specialization.appendKey(key);
+            frag_specialization.appendKey(key);
+            return key;
+        }
+
+        VulkanGraphicsPipelineDesc m_base_desc;
+        std::mutex m_variant_mutex;
+        std::unordered_map<std::vector<std::uint8_t>, Base::Interop::RawRef<Interface::RHI::IPipeline>, VulkanSpecializationKeyHash> m_pipeline_map;
+
+        std::uint64_t m_hit_count = 0;
+        std::uint64_t m_miss_count = 0;
+    };
+}
+
+
+
+
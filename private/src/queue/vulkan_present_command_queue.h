@@ -1,6 +1,7 @@
 #pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
+#include "../device/vulkan_device_features.h"
 namespace Arieo
 {
     class VulkanPresentCommandQueue final
@@ -8,9 +9,10 @@ namespace Arieo
     {
     public:
         friend class VulkanDevice;
-        VulkanPresentCommandQueue(VkDevice& vk_device, std::uint32_t queue_family_index, VkQueue&& vk_queue)
+        VulkanPresentCommandQueue(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, std::uint32_t queue_family_index, VkQueue&& vk_queue)
             : m_queue_family_index(queue_family_index),
             m_vk_device(vk_device), 
+            m_vulkan_device_features(vulkan_device_features),
             m_vk_queue(std::move(vk_queue))
         {
          
@@ -30,7 +32,7 @@ namespace Arieo
                 return nullptr;
             }
 
-            return Base::Interop::RawRef<Interface::RHI::ICommandPool>::createAs<VulkanCommandPool>(m_vk_device, std::move(vk_command_pool));
+            return Base::Interop::RawRef<Interface::RHI::ICommandPool>::createAs<VulkanCommandPool>(m_vk_device, m_vulkan_device_features, std::move(vk_command_pool));
         }
 
         void destroyCommandPool(Base::Interop::RawRef<Interface::RHI::ICommandPool> command_pool) override
@@ -54,6 +56,7 @@ namespace Arieo
     private:
         std::uint32_t m_queue_family_index;
         VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
         VkQueue m_vk_queue;
     };
 }
@@ -14,6 +14,11 @@ namespace Arieo
         VulkanSemaphore* vulkan_wait_semaphore = wait_semaphore.castToInstance<VulkanSemaphore>();
         VulkanSemaphore* vulkan_signal_semaphore = signal_semaphore.castToInstance<VulkanSemaphore>();
         VulkanFence* vulkan_fence = fence.castToInstance<VulkanFence>();
+        if(vulkan_command_buffer->m_vk_command_buffer_level != VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+        {
+            Core::Logger::error("secondary command buffers cannot be submitted, execute them from a primary");
+            return;
+        }
 
         VkSubmitInfo submit_info{};
         submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -43,6 +48,11 @@ namespace Arieo
     {
         VkSubmitInfo submit_info{};
         VulkanCommandBuffer* vulkan_command_buffer = command_buffer.castToInstance<VulkanCommandBuffer>();
+        if(vulkan_command_buffer->m_vk_command_buffer_level != VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+        {
+            Core::Logger::error("secondary command buffers cannot be submitted, execute them from a primary");
+            return;
+        }
         submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submit_info.commandBufferCount = 1;
         submit_info.pCommandBuffers = &vulkan_command_buffer->m_vk_command_buffer;
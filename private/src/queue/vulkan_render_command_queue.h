@@ -2,6 +2,8 @@
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
 #include "../command/vulkan_command.h"
+#include "../command/vulkan_thread_command_pools.h"
+#include "../command/vulkan_frame_command_pools.h"
 namespace Arieo
 {
     class VulkanRenderCommandQueue final
@@ -9,9 +11,10 @@ namespace Arieo
     {
     public:
         friend class VulkanDevice;
-        VulkanRenderCommandQueue(VkDevice& vk_device, std::uint32_t queue_family_index, VkQueue&& vk_queue)
+        VulkanRenderCommandQueue(VkDevice& vk_device, VulkanDeviceFeatures& vulkan_device_features, std::uint32_t queue_family_index, VkQueue&& vk_queue)
             : m_queue_family_index(queue_family_index),
             m_vk_device(vk_device), 
+            m_vulkan_device_features(vulkan_device_features),
             m_vk_queue(std::move(vk_queue))
         {
         }
@@ -30,7 +33,7 @@ namespace Arieo
                 return nullptr;
             }
 
-            return Base::Interop::RawRef<Interface::RHI::ICommandPool>::createAs<VulkanCommandPool>(m_vk_device, std::move(vk_command_pool));
+            return Base::Interop::RawRef<Interface::RHI::ICommandPool>::createAs<VulkanCommandPool>(m_vk_device, m_vulkan_device_features, std::move(vk_command_pool));
         }
 
         void destroyCommandPool(Base::Interop::RawRef<Interface::RHI::ICommandPool> command_pool) override
@@ -41,6 +44,67 @@ namespace Arieo
             return Base::Interop::RawRef<Interface::RHI::ICommandPool>::destroyAs<VulkanCommandPool>(std::move(command_pool));
         }
 
+        VulkanThreadCommandPools* createThreadCommandPools()
+        {
+            return Base::newT<VulkanThreadCommandPools>(m_vk_device, m_vulkan_device_features, m_queue_family_index);
+        }
+
+        void destroyThreadCommandPools(VulkanThreadCommandPools* thread_command_pools)
+        {
+            Base::deleteT(thread_command_pools);
+        }
+
+        // frame_count should match the frames in flight, command buffers are allocated command_buffer_batch_size at a time.
+        // Both are at least 1.
+        VulkanFrameCommandPools* createFrameCommandPools(std::uint32_t frame_count, std::uint32_t command_buffer_batch_size)
+        {
+            frame_count = std::max(frame_count, 1u);
+            command_buffer_batch_size = std::max(command_buffer_batch_size, 1u);
+            std::vector<VulkanFrameCommandPools::FramePool> frame_pools(frame_count);
+            for(std::uint32_t frame_index = 0; frame_index < frame_count; frame_index++)
+            {
+                // Transient pools are recycled as a whole, buffers are never reset individually
+                VkCommandPoolCreateInfo pool_info{};
+                pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                pool_info.queueFamilyIndex = m_queue_family_index;
+
+                VkCommandPool vk_command_pool;
+                if (vkCreateCommandPool(m_vk_device, &pool_info, nullptr, &vk_command_pool) != VK_SUCCESS) 
+                {
+                    Core::Logger::error("failed to create frame command pool");
+                    for(std::uint32_t created_index = 0; created_index < frame_index; created_index++)
+                    {
+                        destroyCommandPool(frame_pools[created_index].command_pool);
+                    }
+                    return nullptr;
+                }
+
+                frame_pools[frame_index].command_pool = Base::Interop::RawRef<Interface::RHI::ICommandPool>::createAs<VulkanCommandPool>(m_vk_device, m_vulkan_device_features, std::move(vk_command_pool));
+                frame_pools[frame_index].primary_command_buffers = frame_pools[frame_index].command_pool.castToInstance<VulkanCommandPool>()->allocateCommandBuffers(command_buffer_batch_size, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+            }
+
+            return Base::newT<VulkanFrameCommandPools>(m_vk_device, command_buffer_batch_size, std::move(frame_pools));
+        }
+
+        void destroyFrameCommandPools(VulkanFrameCommandPools* frame_command_pools)
+        {
+            for(VulkanFrameCommandPools::FramePool& frame_pool : frame_command_pools->m_frame_pools)
+            {
+                // Destroying the pool frees its command buffers
+                for(Base::Interop::RawRef<Interface::RHI::ICommandBuffer>& command_buffer : frame_pool.primary_command_buffers)
+                {
+                    Base::Interop::RawRef<Interface::RHI::ICommandBuffer>::destroyAs<VulkanCommandBuffer>(std::move(command_buffer));
+                }
+                for(Base::Interop::RawRef<Interface::RHI::ICommandBuffer>& command_buffer : frame_pool.secondary_command_buffers)
+                {
+                    Base::Interop::RawRef<Interface::RHI::ICommandBuffer>::destroyAs<VulkanCommandBuffer>(std::move(command_buffer));
+                }
+                destroyCommandPool(frame_pool.command_pool);
+            }
+            Base::deleteT(frame_command_pools);
+        }
+
         void waitIdle() override
         {
             vkQueueWaitIdle(m_vk_queue);
@@ -51,6 +115,7 @@ namespace Arieo
     private:
         std::uint32_t m_queue_family_index;
         VkDevice& m_vk_device;
+        VulkanDeviceFeatures& m_vulkan_device_features;
         VkQueue m_vk_queue;
     };
 }
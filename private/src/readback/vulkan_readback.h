@@ -0,0 +1,212 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <numeric>
+#include "../buffer/vulkan_buffer.h"
+#include "../image/vulkan_image.h"
+#include "../fence/vulkan_fence.h"
+#include "../command/vulkan_command.h"
+#include <vk_mem_alloc.h>
+namespace Arieo
+{
+    // Handle of a pending readback, the data becomes readable once the fence of its frame has signaled.
+    struct VulkanReadbackTicket
+    {
+        // 0 marks an invalid ticket, frame serials start at 1.
+        std::uint64_t frame_serial = 0;
+        std::uint32_t frame_slot = 0;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+
+        bool isValid() const
+        {
+            return frame_serial != 0;
+        }
+    };
+
+    // One persistently mapped, host cached staging buffer per frame in flight.
+    struct VulkanReadbackFrame
+    {
+        Base::Interop::RawRef<Interface::RHI::IBuffer> staging_buffer;
+        std::uint8_t* mapped_ptr = nullptr;
+        VkDeviceSize capacity = 0;
+        VkDeviceSize used_size = 0;
+        std::uint64_t frame_serial = 0;
+        VkFence vk_fence = VK_NULL_HANDLE;
+    };
+
+    // Copies GPU data into a ring of staging buffers so it can be read on the host some frames later
+    // without waiting on the GPU. Tickets stay readable until their frame slot is reused.
+    class VulkanReadbackManager final
+    {
+    public:
+        VulkanReadbackManager(VkDevice& vk_device, VmaAllocator& vma_allocator, std::vector<VulkanReadbackFrame>&& readback_frames)
+            : m_vk_device(vk_device),
+            m_vma_allocator(vma_allocator),
+            m_readback_frames(std::move(readback_frames))
+        {
+
+        }
+
+        // frame_fence is the fence this frame will be submitted with, one fence per frame in flight. Call this before
+        // the fence is reset: the slot waits for the fence of its previous frame, a reset fence would never signal.
+        // Tickets of the slot's previous frame expire here.
+        void beginFrame(Base::Interop::RawRef<Interface::RHI::IFence> frame_fence)
+        {
+            m_frame_serial++;
+            VulkanReadbackFrame& readback_frame = m_readback_frames[m_frame_serial % m_readback_frames.size()];
+            if(readback_frame.vk_fence != VK_NULL_HANDLE)
+            {
+                vkWaitForFences(m_vk_device, 1, &readback_frame.vk_fence, VK_TRUE, UINT64_MAX);
+            }
+
+            readback_frame.used_size = 0;
+            readback_frame.frame_serial = m_frame_serial;
+            readback_frame.vk_fence = frame_fence.castToInstance<VulkanFence>()->m_vk_fence;
+        }
+
+        VulkanReadbackTicket readBuffer(Base::Interop::RawRef<Interface::RHI::ICommandBuffer> command_buffer, Base::Interop::RawRef<Interface::RHI::IBuffer> buffer, VkDeviceSize offset, VkDeviceSize size)
+        {
+            VulkanReadbackTicket ticket = allocate(size, 4);
+            if(ticket.isValid() == false)
+            {
+                return ticket;
+            }
+
+            VulkanCommandBuffer* vulkan_command_buffer = command_buffer.castToInstance<VulkanCommandBuffer>();
+            VulkanReadbackFrame& readback_frame = m_readback_frames[ticket.frame_slot];
+
+            VkBufferCopy copy_region{};
+            copy_region.srcOffset = offset;
+            copy_region.dstOffset = ticket.offset;
+            copy_region.size = size;
+            vkCmdCopyBuffer(
+                vulkan_command_buffer->m_vk_command_buffer,
+                buffer.castToInstance<VulkanBuffer>()->m_vk_buffer,
+                readback_frame.staging_buffer.castToInstance<VulkanBuffer>()->m_vk_buffer,
+                1,
+                &copy_region
+            );
+
+            recordHostBarrier(vulkan_command_buffer, ticket);
+            return ticket;
+        }
+
+        // Reads one region of an image, the data is tightly packed in the ticket. Invalid regions return an invalid
+        // ticket without reserving space.
+        VulkanReadbackTicket readImage(Base::Interop::RawRef<Interface::RHI::ICommandBuffer> command_buffer, Base::Interop::RawRef<Interface::RHI::IImage> image, const VulkanBufferImageCopyRegion& region)
+        {
+            VulkanImage* vulkan_image = image.castToInstance<VulkanImage>();
+            std::uint32_t texel_size = VulkanUtility::getFormatTexelSize(vulkan_image->m_vk_image_format);
+            if(texel_size == 0)
+            {
+                Core::Logger::error("Readback of image format {} is not supported", (std::uint32_t)vulkan_image->m_vk_image_format);
+                return VulkanReadbackTicket{};
+            }
+
+            // Same check copyImageToBuffer runs, done first so a rejected copy holds no ring space
+            if(vulkan_image->isCopyRegionValid(region) == false)
+            {
+                return VulkanReadbackTicket{};
+            }
+            VkExtent3D copy_extent = vulkan_image->getCopyExtent(region);
+            VkDeviceSize copy_size = static_cast<VkDeviceSize>(copy_extent.width) * copy_extent.height * copy_extent.depth * region.layer_count * texel_size;
+
+            // Buffer offsets of image copies must be a multiple of both 4 and the texel size
+            VulkanReadbackTicket ticket = allocate(copy_size, std::lcm<VkDeviceSize>(4, texel_size));
+            if(ticket.isValid() == false)
+            {
+                return ticket;
+            }
+
+            VulkanCommandBuffer* vulkan_command_buffer = command_buffer.castToInstance<VulkanCommandBuffer>();
+            VulkanBufferImageCopyRegion packed_region = region;
+            packed_region.buffer_offset = ticket.offset;
+            packed_region.buffer_row_length = 0;
+            packed_region.buffer_image_height = 0;
+            vulkan_command_buffer->copyImageToBuffer(image, m_readback_frames[ticket.frame_slot].staging_buffer, &packed_region, 1);
+
+            recordHostBarrier(vulkan_command_buffer, ticket);
+            return ticket;
+        }
+
+        bool isReady(const VulkanReadbackTicket& ticket) const
+        {
+            if(isExpired(ticket))
+            {
+                return false;
+            }
+            return vkGetFenceStatus(m_vk_device, m_readback_frames[ticket.frame_slot].vk_fence) == VK_SUCCESS;
+        }
+
+        // The frame slot of the ticket has been reused, its data is gone.
+        bool isExpired(const VulkanReadbackTicket& ticket) const
+        {
+            return ticket.isValid() == false
+                || m_readback_frames[ticket.frame_slot].frame_serial != ticket.frame_serial;
+        }
+
+        // Returns nullptr until the ticket is ready. The pointer stays valid until the frame slot is reused.
+        const void* getData(const VulkanReadbackTicket& ticket)
+        {
+            if(isReady(ticket) == false)
+            {
+                return nullptr;
+            }
+
+            VulkanReadbackFrame& readback_frame = m_readback_frames[ticket.frame_slot];
+            // Host cached memory is not necessarily coherent
+            vmaInvalidateAllocation(m_vma_allocator, readback_frame.staging_buffer.castToInstance<VulkanBuffer>()->m_vma_allocation, ticket.offset, ticket.size);
+            return readback_frame.mapped_ptr + ticket.offset;
+        }
+    private:
+        friend class VulkanDevice;
+
+        VulkanReadbackTicket allocate(VkDeviceSize size, VkDeviceSize alignment)
+        {
+            if(m_frame_serial == 0)
+            {
+                Core::Logger::error("Readback requested before beginFrame");
+                return VulkanReadbackTicket{};
+            }
+
+            std::uint32_t frame_slot = static_cast<std::uint32_t>(m_frame_serial % m_readback_frames.size());
+            VulkanReadbackFrame& readback_frame = m_readback_frames[frame_slot];
+
+            VkDeviceSize offset = (readback_frame.used_size + alignment - 1) / alignment * alignment;
+            if(size == 0 || offset + size > readback_frame.capacity)
+            {
+                Core::Logger::error("Readback of {} bytes does not fit the frame staging buffer ({} of {} bytes used)", size, readback_frame.used_size, readback_frame.capacity);
+                return VulkanReadbackTicket{};
+            }
+            readback_frame.used_size = offset + size;
+
+            VulkanReadbackTicket ticket;
+            ticket.frame_serial = m_frame_serial;
+            ticket.frame_slot = frame_slot;
+            ticket.offset = offset;
+            ticket.size = size;
+            return ticket;
+        }
+
+        void recordHostBarrier(VulkanCommandBuffer* vulkan_command_buffer, const VulkanReadbackTicket& ticket)
+        {
+            VulkanBarrierBatch barrier_batch;
+            barrier_batch.addBufferBarrier(
+                m_readback_frames[ticket.frame_slot].staging_buffer, ticket.offset, ticket.size,
+                VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT
+            );
+            vulkan_command_buffer->pipelineBarrier(barrier_batch);
+        }
+
+        VkDevice& m_vk_device;
+        VmaAllocator& m_vma_allocator;
+        std::vector<VulkanReadbackFrame> m_readback_frames;
+        std::uint64_t m_frame_serial = 0;
+    };
+}
+
+
+
+
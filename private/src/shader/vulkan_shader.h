@@ -1,7 +1,8 @@
-
 #pragma once
 #include "interface/rhi/rhi.h"
 #include <vulkan.h>
+#include "vulkan_shader_reflection.h"
+#include "../common/vulkan_utility.h"
 
 namespace Arieo
 {
@@ -10,13 +11,37 @@ namespace Arieo
     {
     public:
         friend class VulkanDevice;
-        VulkanShader(VkShaderModule&& vk_shader)
-            : m_vk_shader_module(std::move(vk_shader))
+        friend class VulkanShaderModuleCache;
+        VulkanShader(VkShaderModule&& vk_shader, VulkanShaderReflection&& reflection)
+            : m_vk_shader_module(std::move(vk_shader)),
+            m_reflection(std::move(reflection))
+        {
+
+        }
+
+        // Bindings, push constants, vertex inputs and specialization constants declared by the SPIR-V.
+        const VulkanShaderReflection& getReflection() const
         {
+            return m_reflection;
+        }
 
+        // Driver identifier of the module, empty without shader_module_identifier. Persist it together with the
+        // pipeline cache data to recreate the shader later with VulkanDevice::createShaderFromIdentifier.
+        const std::vector<std::uint8_t>& getModuleIdentifier() const
+        {
+            return m_module_identifier;
         }
     private:
+        // VK_NULL_HANDLE for shaders created from an identifier alone
         VkShaderModule m_vk_shader_module;
+        VulkanShaderReflection m_reflection;
+        std::vector<std::uint8_t> m_module_identifier;
+        // SPIR-V kept for vkCreateShadersEXT, empty unless the device had shader objects enabled at creation
+        std::vector<std::uint32_t> m_code;
+
+        // Key in the shader module cache, the digest of the supplied SPIR-V. False for shaders created from an identifier.
+        VulkanUtility::Digest m_code_digest{};
+        bool m_is_cached = false;
     };
 }
 
@@ -0,0 +1,172 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "vulkan_shader.h"
+
+namespace Arieo
+{
+    // Reference counted shader modules keyed by a SHA-256 digest of their SPIR-V. Loading the same blob again returns
+    // the shader already created for it, the module is destroyed with the last reference. Thread safe.
+    class VulkanShaderModuleCache final
+    {
+    public:
+        // Takes a reference on the cached shader, nullptr on a miss.
+        Base::Interop::RawRef<Interface::RHI::IShader> acquire(const VulkanUtility::Digest& code_digest)
+        {
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto found_iter = m_shader_map.find(code_digest);
+            if(found_iter == m_shader_map.end())
+            {
+                m_miss_count++;
+                return nullptr;
+            }
+            m_hit_count++;
+            found_iter->second.ref_count++;
+            return found_iter->second.shader;
+        }
+
+        // Returns the shader to use: the given one, or the one another thread cached first for the same code.
+        // In the latter case the given shader is not referenced by the cache and has to be destroyed by the caller.
+        Base::Interop::RawRef<Interface::RHI::IShader> add(Base::Interop::RawRef<Interface::RHI::IShader> shader)
+        {
+            VulkanShader* vulkan_shader = shader.castToInstance<VulkanShader>();
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto [found_iter, is_inserted] = m_shader_map.try_emplace(vulkan_shader->m_code_digest, Entry{shader, 1});
+            if(is_inserted)
+            {
+                return shader;
+            }
+            found_iter->second.ref_count++;
+            return found_iter->second.shader;
+        }
+
+        // Drops a reference, true when it was the last one and the shader has to be destroyed.
+        bool release(Base::Interop::RawRef<Interface::RHI::IShader> shader)
+        {
+            VulkanShader* vulkan_shader = shader.castToInstance<VulkanShader>();
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto found_iter = m_shader_map.find(vulkan_shader->m_code_digest);
+            if(found_iter == m_shader_map.end() || found_iter->second.shader.castToInstance<VulkanShader>() != vulkan_shader)
+            {
+                return true;
+            }
+            if(--found_iter->second.ref_count > 0)
+            {
+                return false;
+            }
+            m_shader_map.erase(found_iter);
+            return true;
+        }
+
+        std::uint64_t getHitCount() const { return m_hit_count; }
+        std::uint64_t getMissCount() const { return m_miss_count; }
+        size_t getSize() const { return m_shader_map.size(); }
+    private:
+        struct Entry
+        {
+            Base::Interop::RawRef<Interface::RHI::IShader> shader;
+            std::uint32_t ref_count;
+        };
+
+        std::mutex m_cache_mutex;
+        std::unordered_map<VulkanUtility::Digest, Entry, VulkanUtility::DigestHash> m_shader_map;
+
+        std::uint64_t m_hit_count = 0;
+        std::uint64_t m_miss_count = 0;
+    };
+
+    // Reference counted shader objects keyed by everything vkCreateShadersEXT is given for a stage: code, entry
+    // point, specialization, set layouts and push constant ranges. Pipelines built from the same stage share one
+    // VkShaderEXT, it is destroyed with the last reference. Thread safe.
+    class VulkanShaderObjectCache final
+    {
+    public:
+        // Takes a reference on the cached shader object, VK_NULL_HANDLE on a miss.
+        VkShaderEXT acquire(const std::vector<std::uint8_t>& key)
+        {
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto found_iter = m_shader_map.find(key);
+            if(found_iter == m_shader_map.end())
+            {
+                m_miss_count++;
+                return VK_NULL_HANDLE;
+            }
+            m_hit_count++;
+            found_iter->second.ref_count++;
+            return found_iter->second.vk_shader;
+        }
+
+        // Returns the shader object to use: the given one, or the one another thread cached first for the same key.
+        // In the latter case the given one is not referenced by the cache and has to be destroyed by the caller.
+        VkShaderEXT add(std::vector<std::uint8_t>&& key, VkShaderEXT vk_shader)
+        {
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto [found_iter, is_inserted] = m_shader_map.try_emplace(std::move(key), Entry{vk_shader, 1});
+            if(is_inserted)
+            {
+                m_key_map.emplace(vk_shader, &found_iter->first);
+                return vk_shader;
+            }
+            found_iter->second.ref_count++;
+            return found_iter->second.vk_shader;
+        }
+
+        // Drops a reference, true when it was the last one and the shader object has to be destroyed.
+        bool release(VkShaderEXT vk_shader)
+        {
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto key_iter = m_key_map.find(vk_shader);
+            if(key_iter == m_key_map.end())
+            {
+                return true;
+            }
+            auto found_iter = m_shader_map.find(*key_iter->second);
+            if(--found_iter->second.ref_count > 0)
+            {
+                return false;
+            }
+            m_key_map.erase(key_iter);
+            m_shader_map.erase(found_iter);
+            return true;
+        }
+
+        std::uint64_t getHitCount() const { return m_hit_count; }
+        std::uint64_t getMissCount() const { return m_miss_count; }
+        size_t getSize() const { return m_shader_map.size(); }
+    private:
+        struct KeyHash
+        {
+            size_t operator()(const std::vector<std::uint8_t>& key) const
+            {
+                std::uint64_t hash = 14695981039346656037ull;
+                for(std::uint8_t key_byte : key)
+                {
+                    hash ^= key_byte;
+                    hash *= 1099511628211ull;
+                }
+                return static_cast<size_t>(hash);
+            }
+        };
+
+        struct Entry
+        {
+            VkShaderEXT vk_shader;
+            std::uint32_t ref_count;
+        };
+
+        std::mutex m_cache_mutex;
+        std::unordered_map<std::vector<std::uint8_t>, Entry, KeyHash> m_shader_map;
+        // Key of each cached shader object, points into m_shader_map
+        std::unordered_map<VkShaderEXT, const std::vector<std::uint8_t>*> m_key_map;
+
+        std::uint64_t m_hit_count = 0;
+        std::uint64_t m_miss_count = 0;
+    };
+}
+
+
+
+
@@ -0,0 +1,433 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include <vulkan.h>
+#include <vulkan_core.h>
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+// The Vulkan SDK ships the shaderc headers, linking shaderc is opt-in so the headers alone do not enable it
+#if defined(ARIEO_VULKAN_ENABLE_SHADERC) && defined(__has_include)
+#if __has_include(<shaderc/shaderc.hpp>)
+#include <shaderc/shaderc.hpp>
+#define ARIEO_VULKAN_HAS_SHADERC 1
+#endif
+#endif
+
+#include "../vulkan_rhi.h"
+
+namespace Arieo
+{
+    namespace
+    {
+        // Bump when the cache file layout or the compile options change meaning
+        constexpr std::uint32_t SHADER_CACHE_MAGIC = 0x56505341;
+        constexpr std::uint32_t SHADER_CACHE_VERSION = 2;
+
+        constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+        constexpr size_t SPIRV_HEADER_WORD_COUNT = 5;
+
+        template<typename T>
+        void appendKey(std::string& key, const T& value)
+        {
+            key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void appendKeyString(std::string& key, const std::string& text)
+        {
+            // The length keeps "ab" + "c" apart from "a" + "bc"
+            appendKey(key, static_cast<std::uint64_t>(text.size()));
+            key.append(text);
+        }
+
+        bool readFile(const std::string& path, std::string& content)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if(file.is_open() == false)
+            {
+                return false;
+            }
+            std::ostringstream content_stream;
+            content_stream << file.rdbuf();
+            content = content_stream.str();
+            return true;
+        }
+
+        template<typename T>
+        bool readValue(std::ifstream& file, T& value)
+        {
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        template<typename T>
+        void writeValue(std::ofstream& file, const T& value)
+        {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+#if defined(ARIEO_VULKAN_HAS_SHADERC)
+        shaderc_shader_kind getShaderKind(VkShaderStageFlagBits stage)
+        {
+            switch(stage)
+            {
+            case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return shaderc_tess_control_shader;
+            case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: return shaderc_tess_evaluation_shader;
+            case VK_SHADER_STAGE_GEOMETRY_BIT: return shaderc_geometry_shader;
+            case VK_SHADER_STAGE_FRAGMENT_BIT: return shaderc_fragment_shader;
+            case VK_SHADER_STAGE_COMPUTE_BIT: return shaderc_compute_shader;
+            default: return shaderc_vertex_shader;
+            }
+        }
+
+        // Resolves #include "..." next to the including file first, then in the include directories.
+        // Every resolved file is recorded with its content digest for cache validation.
+        class ShaderIncluder final
+            : public shaderc::CompileOptions::IncluderInterface
+        {
+        public:
+            ShaderIncluder(const std::vector<std::string>& include_directories, std::vector<std::pair<std::string, VulkanUtility::Digest>>& dependencies)
+                : m_include_directories(include_directories),
+                m_dependencies(dependencies)
+            {
+
+            }
+
+            shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type include_type, const char* requesting_source, size_t) override
+            {
+                IncludeData* include_data = new IncludeData();
+
+                std::vector<std::filesystem::path> candidate_paths;
+                if(include_type == shaderc_include_type_relative)
+                {
+                    candidate_paths.emplace_back(std::filesystem::path(requesting_source).parent_path() / requested_source);
+                }
+                for(const std::string& include_directory : m_include_directories)
+                {
+                    candidate_paths.emplace_back(std::filesystem::path(include_directory) / requested_source);
+                }
+
+                for(const std::filesystem::path& candidate_path : candidate_paths)
+                {
+                    if(readFile(candidate_path.string(), include_data->content))
+                    {
+                        include_data->source_name = candidate_path.lexically_normal().string();
+                        m_dependencies.emplace_back(include_data->source_name, VulkanUtility::computeDigest(include_data->content.data(), include_data->content.size()));
+                        break;
+                    }
+                }
+                if(include_data->source_name.empty())
+                {
+                    // An empty name tells shaderc the include failed, the content is the error message
+                    include_data->content = std::string("Cannot find include file ") + requested_source;
+                }
+
+                include_data->result.source_name = include_data->source_name.data();
+                include_data->result.source_name_length = include_data->source_name.size();
+                include_data->result.content = include_data->content.data();
+                include_data->result.content_length = include_data->content.size();
+                include_data->result.user_data = include_data;
+                return &include_data->result;
+            }
+
+            void ReleaseInclude(shaderc_include_result* include_result) override
+            {
+                delete static_cast<IncludeData*>(include_result->user_data);
+            }
+        private:
+            struct IncludeData
+            {
+                shaderc_include_result result{};
+                std::string source_name;
+                std::string content;
+            };
+
+            const std::vector<std::string>& m_include_directories;
+            std::vector<std::pair<std::string, VulkanUtility::Digest>>& m_dependencies;
+        };
+#endif
+    }
+
+    VulkanShaderCompiler::VulkanShaderCompiler(const std::string& cache_directory, const std::vector<std::string>& include_directories, std::uint32_t thread_count)
+        : m_cache_directory(cache_directory),
+        m_include_directories(include_directories)
+    {
+        if(m_cache_directory.empty() == false)
+        {
+            std::error_code error_code;
+            std::filesystem::create_directories(m_cache_directory, error_code);
+            if(error_code)
+            {
+                Core::Logger::warn("Shader cache directory {} is not usable: {}", m_cache_directory, error_code.message());
+                m_cache_directory.clear();
+            }
+        }
+
+        if(thread_count == 0)
+        {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for(std::uint32_t thread_index = 0; thread_index < thread_count; thread_index++)
+        {
+            m_worker_threads.emplace_back(&VulkanShaderCompiler::runWorker, this);
+        }
+    }
+
+    VulkanShaderCompiler::~VulkanShaderCompiler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_task_mutex);
+            m_is_stopping = true;
+        }
+        m_task_condition.notify_all();
+        // Workers finish the queued tasks before leaving, so every future gets its result
+        for(std::thread& worker_thread : m_worker_threads)
+        {
+            worker_thread.join();
+        }
+    }
+
+    bool VulkanShaderCompiler::isCompilerAvailable()
+    {
+#if defined(ARIEO_VULKAN_HAS_SHADERC)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    VulkanShaderCompileResult VulkanShaderCompiler::compile(const VulkanShaderSource& shader_source)
+    {
+        VulkanShaderCompileResult result;
+
+        std::string cache_path;
+        std::string cache_key;
+        if(m_cache_directory.empty() == false)
+        {
+            std::vector<std::pair<std::string, std::string>> sorted_defines = shader_source.defines;
+            std::sort(sorted_defines.begin(), sorted_defines.end());
+
+            // shaderc comes with the Vulkan SDK, the SDK version stands for the compiler build. It is part of the key
+            // even without shaderc so cache-only builds of the same SDK read the entries.
+            appendKey(cache_key, SHADER_CACHE_VERSION);
+            appendKey(cache_key, static_cast<std::uint32_t>(VK_HEADER_VERSION_COMPLETE));
+            appendKey(cache_key, shader_source.language);
+            appendKey(cache_key, shader_source.stage);
+            appendKey(cache_key, shader_source.optimize);
+            appendKeyString(cache_key, shader_source.entry_point);
+            appendKeyString(cache_key, shader_source.name);
+            appendKeyString(cache_key, shader_source.source);
+            appendKey(cache_key, static_cast<std::uint64_t>(sorted_defines.size()));
+            for(const auto& [define_name, define_value] : sorted_defines)
+            {
+                appendKeyString(cache_key, define_name);
+                appendKeyString(cache_key, define_value);
+            }
+            appendKey(cache_key, static_cast<std::uint64_t>(m_include_directories.size()));
+            for(const std::string& include_directory : m_include_directories)
+            {
+                appendKeyString(cache_key, include_directory);
+            }
+
+            // The file name only spreads the entries, the stored key decides a hit
+            VulkanUtility::Digest key_digest = VulkanUtility::computeDigest(cache_key.data(), cache_key.size());
+            char key_name[17];
+            std::snprintf(key_name, sizeof(key_name), "%016llx", static_cast<unsigned long long>(VulkanUtility::DigestHash()(key_digest)));
+            cache_path = (std::filesystem::path(m_cache_directory) / (std::string(key_name) + ".spvcache")).string();
+            if(loadCacheEntry(cache_path, cache_key, result))
+            {
+                return result;
+            }
+        }
+
+#if defined(ARIEO_VULKAN_HAS_SHADERC)
+        std::vector<std::pair<std::string, VulkanUtility::Digest>> dependencies;
+
+        shaderc::CompileOptions compile_options;
+        compile_options.SetSourceLanguage(shader_source.language == VulkanShaderLanguage::HLSL ? shaderc_source_language_hlsl : shaderc_source_language_glsl);
+        compile_options.SetOptimizationLevel(shader_source.optimize ? shaderc_optimization_level_performance : shaderc_optimization_level_zero);
+        for(const auto& [define_name, define_value] : shader_source.defines)
+        {
+            compile_options.AddMacroDefinition(define_name, define_value);
+        }
+        compile_options.SetIncluder(std::make_unique<ShaderIncluder>(m_include_directories, dependencies));
+
+        // shaderc compilers are safe to share between threads, one per call keeps it simple
+        shaderc::Compiler compiler;
+        shaderc::SpvCompilationResult compilation_result = compiler.CompileGlslToSpv(
+            shader_source.source,
+            getShaderKind(shader_source.stage),
+            shader_source.name.c_str(),
+            shader_source.entry_point.c_str(),
+            compile_options
+        );
+        result.log = compilation_result.GetErrorMessage();
+        if(compilation_result.GetCompilationStatus() != shaderc_compilation_status_success)
+        {
+            return result;
+        }
+
+        result.is_success = true;
+        result.spirv.assign(compilation_result.cbegin(), compilation_result.cend());
+        if(cache_path.empty() == false)
+        {
+            saveCacheEntry(cache_path, cache_key, dependencies, result.spirv);
+        }
+#else
+        result.log = "Shader " + shader_source.name + " is not in the shader cache and the module was built without a shader compiler";
+#endif
+        return result;
+    }
+
+    std::future<VulkanShaderCompileResult> VulkanShaderCompiler::compileAsync(VulkanShaderSource shader_source)
+    {
+        std::packaged_task<VulkanShaderCompileResult()> task(
+            [this, shader_source = std::move(shader_source)]()
+            {
+                return compile(shader_source);
+            });
+        std::future<VulkanShaderCompileResult> result_future = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_task_mutex);
+            m_tasks.emplace_back(std::move(task));
+        }
+        m_task_condition.notify_one();
+        return result_future;
+    }
+
+    void VulkanShaderCompiler::runWorker()
+    {
+        while(true)
+        {
+            std::packaged_task<VulkanShaderCompileResult()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_task_mutex);
+                m_task_condition.wait(lock, [this]() { return m_is_stopping || m_tasks.empty() == false; });
+                if(m_tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    // Layout: magic, version, key size, key, dependency count, per dependency (path length, path, content digest),
+    // SPIR-V word count, SPIR-V words.
+    bool VulkanShaderCompiler::loadCacheEntry(const std::string& cache_path, const std::string& cache_key, VulkanShaderCompileResult& result) const
+    {
+        std::ifstream file(cache_path, std::ios::binary | std::ios::ate);
+        if(file.is_open() == false)
+        {
+            return false;
+        }
+        const std::uint64_t file_size = static_cast<std::uint64_t>(file.tellg());
+        file.seekg(0);
+        // Sizes read from the file are checked against what is left of it before anything is allocated
+        auto get_remaining_size = [&file, file_size]() -> std::uint64_t
+        {
+            std::uint64_t position = static_cast<std::uint64_t>(file.tellg());
+            return position <= file_size ? file_size - position : 0;
+        };
+
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::uint64_t key_size = 0;
+        if(readValue(file, magic) == false || magic != SHADER_CACHE_MAGIC
+        || readValue(file, version) == false || version != SHADER_CACHE_VERSION
+        || readValue(file, key_size) == false || key_size != cache_key.size() || key_size > get_remaining_size())
+        {
+            return false;
+        }
+
+        // The file name is a truncated hash, the key itself tells colliding entries apart
+        std::string stored_key(cache_key.size(), '\0');
+        std::uint32_t dependency_count = 0;
+        if(file.read(stored_key.data(), stored_key.size()).fail()
+        || stored_key != cache_key
+        || readValue(file, dependency_count) == false)
+        {
+            return false;
+        }
+
+        // Any changed or missing include makes the entry stale
+        for(std::uint32_t dependency_index = 0; dependency_index < dependency_count; dependency_index++)
+        {
+            std::uint32_t path_length = 0;
+            VulkanUtility::Digest content_digest{};
+            if(readValue(file, path_length) == false || path_length > get_remaining_size())
+            {
+                return false;
+            }
+            std::string dependency_path(path_length, '\0');
+            std::string content;
+            if(file.read(dependency_path.data(), path_length).fail()
+            || readValue(file, content_digest) == false
+            || readFile(dependency_path, content) == false
+            || VulkanUtility::computeDigest(content.data(), content.size()) != content_digest)
+            {
+                return false;
+            }
+        }
+
+        std::uint32_t word_count = 0;
+        if(readValue(file, word_count) == false
+        || word_count < SPIRV_HEADER_WORD_COUNT
+        || static_cast<std::uint64_t>(word_count) * sizeof(std::uint32_t) != get_remaining_size())
+        {
+            Core::Logger::warn("Shader cache entry {} is corrupted", cache_path);
+            return false;
+        }
+        result.spirv.resize(word_count);
+        if(file.read(reinterpret_cast<char*>(result.spirv.data()), word_count * sizeof(std::uint32_t)).fail()
+        || result.spirv[0] != SPIRV_MAGIC)
+        {
+            Core::Logger::warn("Shader cache entry {} does not hold SPIR-V", cache_path);
+            result.spirv.clear();
+            return false;
+        }
+        result.is_success = true;
+        result.is_cache_hit = true;
+        return true;
+    }
+
+    void VulkanShaderCompiler::saveCacheEntry(const std::string& cache_path, const std::string& cache_key, const std::vector<std::pair<std::string, VulkanUtility::Digest>>& dependencies, const std::vector<std::uint32_t>& spirv) const
+    {
+        // Written aside and renamed into place, readers in other threads or processes never see half an entry
+        std::ostringstream temp_suffix;
+        temp_suffix << ".tmp" << std::this_thread::get_id();
+        std::string temp_path = cache_path + temp_suffix.str();
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if(file.is_open() == false)
+            {
+                Core::Logger::warn("Cannot write shader cache entry {}", temp_path);
+                return;
+            }
+            writeValue(file, SHADER_CACHE_MAGIC);
+            writeValue(file, SHADER_CACHE_VERSION);
+            writeValue(file, static_cast<std::uint64_t>(cache_key.size()));
+            file.write(cache_key.data(), cache_key.size());
+            writeValue(file, static_cast<std::uint32_t>(dependencies.size()));
+            for(const auto& [dependency_path, content_digest] : dependencies)
+            {
+                writeValue(file, static_cast<std::uint32_t>(dependency_path.size()));
+                file.write(dependency_path.data(), dependency_path.size());
+                writeValue(file, content_digest);
+            }
+            writeValue(file, static_cast<std::uint32_t>(spirv.size()));
+            file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(std::uint32_t));
+        }
+
+        std::error_code error_code;
+        std::filesystem::rename(temp_path, cache_path, error_code);
+        if(error_code)
+        {
+            std::filesystem::remove(temp_path, error_code);
+        }
+    }
+}
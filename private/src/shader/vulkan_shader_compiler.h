@@ -0,0 +1,77 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../common/vulkan_utility.h"
+
+namespace Arieo
+{
+    enum class VulkanShaderLanguage
+    {
+        GLSL,
+        HLSL
+    };
+
+    struct VulkanShaderSource
+    {
+        std::string source;
+        // File name used for error messages and to resolve #include "..." relative to it
+        std::string name;
+        VulkanShaderLanguage language = VulkanShaderLanguage::GLSL;
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        std::string entry_point = "main";
+        std::vector<std::pair<std::string, std::string>> defines;
+        bool optimize = true;
+    };
+
+    struct VulkanShaderCompileResult
+    {
+        bool is_success = false;
+        bool is_cache_hit = false;
+        std::vector<std::uint32_t> spirv;
+        // Compiler errors and warnings
+        std::string log;
+    };
+
+    // GLSL / HLSL to SPIR-V front-end for createShader. Results are cached on disk under the source, defines, options
+    // and Vulkan SDK version, which an entry stores in full and compares on load. An entry also records the included
+    // files and is dropped when one of them changes. Compiling needs the ARIEO_VULKAN_ENABLE_SHADERC CMake option,
+    // without it only cached entries can be served. compile and compileAsync may be called from any thread.
+    class VulkanShaderCompiler final
+    {
+    public:
+        // An empty cache_directory disables the disk cache, thread_count 0 uses one thread per core.
+        VulkanShaderCompiler(const std::string& cache_directory, const std::vector<std::string>& include_directories, std::uint32_t thread_count);
+        ~VulkanShaderCompiler();
+
+        static bool isCompilerAvailable();
+
+        VulkanShaderCompileResult compile(const VulkanShaderSource& shader_source);
+        // Runs on the compiler's thread pool.
+        std::future<VulkanShaderCompileResult> compileAsync(VulkanShaderSource shader_source);
+    private:
+        void runWorker();
+
+        bool loadCacheEntry(const std::string& cache_path, const std::string& cache_key, VulkanShaderCompileResult& result) const;
+        void saveCacheEntry(const std::string& cache_path, const std::string& cache_key, const std::vector<std::pair<std::string, VulkanUtility::Digest>>& dependencies, const std::vector<std::uint32_t>& spirv) const;
+
+        std::string m_cache_directory;
+        std::vector<std::string> m_include_directories;
+
+        std::vector<std::thread> m_worker_threads;
+        std::mutex m_task_mutex;
+        std::condition_variable m_task_condition;
+        std::deque<std::packaged_task<VulkanShaderCompileResult()>> m_tasks;
+        bool m_is_stopping = false;
+    };
+}
+
+
+
+
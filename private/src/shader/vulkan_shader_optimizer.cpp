@@ -0,0 +1,325 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include <vulkan.h>
+#include <vulkan_core.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// Like shaderc, the spirv-tools headers come with the Vulkan SDK, linking the library is opt-in
+#if defined(ARIEO_VULKAN_ENABLE_SPIRV_TOOLS) && defined(__has_include)
+#if __has_include(<spirv-tools/optimizer.hpp>)
+#include <spirv-tools/optimizer.hpp>
+#define ARIEO_VULKAN_HAS_SPIRV_TOOLS 1
+#endif
+#endif
+
+#include "../vulkan_rhi.h"
+
+namespace Arieo
+{
+    namespace
+    {
+        constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+        constexpr size_t SPIRV_HEADER_WORD_COUNT = 5;
+
+        constexpr std::uint32_t OPTIMIZER_CACHE_MAGIC = 0x4f505341;
+        // Bump when the passes change, old entries are then ignored
+        constexpr std::uint32_t OPTIMIZER_CACHE_VERSION = 2;
+
+        // Debug instructions dropped by the built-in strip
+        constexpr std::uint32_t OP_SOURCE_CONTINUED = 2;
+        constexpr std::uint32_t OP_SOURCE = 3;
+        constexpr std::uint32_t OP_SOURCE_EXTENSION = 4;
+        constexpr std::uint32_t OP_NAME = 5;
+        constexpr std::uint32_t OP_MEMBER_NAME = 6;
+        constexpr std::uint32_t OP_STRING = 7;
+        constexpr std::uint32_t OP_LINE = 8;
+        constexpr std::uint32_t OP_EXT_INST_IMPORT = 11;
+        constexpr std::uint32_t OP_NO_LINE = 317;
+        constexpr std::uint32_t OP_MODULE_PROCESSED = 330;
+
+#if defined(ARIEO_VULKAN_HAS_SPIRV_TOOLS)
+        // Picks the most permissive Vulkan environment accepting the module's SPIR-V version
+        spv_target_env getTargetEnv(std::uint32_t spirv_version)
+        {
+            std::uint32_t spirv_minor = (spirv_version >> 8) & 0xff;
+            if(spirv_minor >= 6) return SPV_ENV_VULKAN_1_3;
+            if(spirv_minor == 5) return SPV_ENV_VULKAN_1_2;
+            if(spirv_minor == 4) return SPV_ENV_VULKAN_1_1_SPIRV_1_4;
+            if(spirv_minor >= 1) return SPV_ENV_VULKAN_1_1;
+            return SPV_ENV_VULKAN_1_0;
+        }
+#endif
+    }
+
+    VulkanShaderOptimizer::VulkanShaderOptimizer(bool strip_debug_info, bool optimize_performance, const std::string& cache_directory)
+        : m_strip_debug_info(strip_debug_info),
+        m_optimize_performance(optimize_performance),
+        m_cache_directory(cache_directory)
+    {
+        if(m_optimize_performance && isOptimizerAvailable() == false)
+        {
+            Core::Logger::warn("Built without spirv-tools, shaders only get their debug info stripped");
+        }
+        if(m_cache_directory.empty() == false)
+        {
+            std::error_code error_code;
+            std::filesystem::create_directories(m_cache_directory, error_code);
+            if(error_code)
+            {
+                Core::Logger::warn("Shader optimizer cache directory {} is not usable: {}", m_cache_directory, error_code.message());
+                m_cache_directory.clear();
+            }
+        }
+    }
+
+    bool VulkanShaderOptimizer::isOptimizerAvailable()
+    {
+#if defined(ARIEO_VULKAN_HAS_SPIRV_TOOLS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool VulkanShaderOptimizer::optimize(const void* code, size_t code_size, std::vector<std::uint32_t>& optimized_code)
+    {
+        const std::uint32_t* code_words = static_cast<const std::uint32_t*>(code);
+        if(code_size % sizeof(std::uint32_t) != 0
+        || code_size < SPIRV_HEADER_WORD_COUNT * sizeof(std::uint32_t)
+        || code_words[0] != SPIRV_MAGIC)
+        {
+            return false;
+        }
+
+        VulkanUtility::Digest code_digest = VulkanUtility::computeDigest(code, code_size);
+        {
+            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            auto found_iter = m_code_map.find(code_digest);
+            if(found_iter != m_code_map.end())
+            {
+                m_hit_count++;
+                optimized_code = found_iter->second;
+                return optimized_code.empty() == false;
+            }
+            m_miss_count++;
+        }
+
+        // An empty result means "use the input", it is cached as well so failures are not retried
+        std::vector<std::uint32_t> result_code;
+        std::string cache_path = getCachePath(code_digest);
+        if(cache_path.empty() || loadCacheEntry(cache_path, code_size, code_digest, result_code) == false)
+        {
+            if(runPasses(code_words, code_size / sizeof(std::uint32_t), result_code) == false)
+            {
+                result_code.clear();
+            }
+            if(cache_path.empty() == false)
+            {
+                saveCacheEntry(cache_path, code_size, code_digest, result_code);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        if(result_code.empty() == false && result_code.size() * sizeof(std::uint32_t) < code_size)
+        {
+            m_saved_byte_count += code_size - result_code.size() * sizeof(std::uint32_t);
+        }
+        m_code_map.try_emplace(code_digest, result_code);
+        optimized_code = std::move(result_code);
+        return optimized_code.empty() == false;
+    }
+
+    bool VulkanShaderOptimizer::runPasses(const std::uint32_t* code, size_t word_count, std::vector<std::uint32_t>& optimized_code) const
+    {
+        if(m_strip_debug_info == false && m_optimize_performance == false)
+        {
+            return false;
+        }
+
+#if defined(ARIEO_VULKAN_HAS_SPIRV_TOOLS)
+        spvtools::Optimizer optimizer(getTargetEnv(code[1]));
+        optimizer.SetMessageConsumer(
+            [](spv_message_level_t level, const char*, const spv_position_t&, const char* message)
+            {
+                if(level <= SPV_MSG_ERROR)
+                {
+                    Core::Logger::warn("spirv-opt: {}", message);
+                }
+            });
+        if(m_optimize_performance)
+        {
+            optimizer.RegisterPerformancePasses();
+        }
+        if(m_strip_debug_info)
+        {
+            optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+            optimizer.RegisterPass(spvtools::CreateStripNonSemanticInfoPass());
+        }
+        // The optimizer validates its input, invalid modules are passed through untouched
+        return optimizer.Run(code, word_count, &optimized_code);
+#else
+        return m_strip_debug_info && stripDebugInfo(code, word_count, optimized_code);
+#endif
+    }
+
+    bool VulkanShaderOptimizer::stripDebugInfo(const std::uint32_t* code, size_t word_count, std::vector<std::uint32_t>& optimized_code)
+    {
+        // NonSemantic debug info references OpString ids, the strings stay when such a set is imported
+        bool keep_strings = false;
+        for(size_t word_index = SPIRV_HEADER_WORD_COUNT; word_index < word_count;)
+        {
+            std::uint32_t instruction_word_count = code[word_index] >> 16;
+            if(instruction_word_count == 0 || word_index + instruction_word_count > word_count)
+            {
+                return false;
+            }
+            if((code[word_index] & 0xffff) == OP_EXT_INST_IMPORT && instruction_word_count > 2)
+            {
+                const char* import_name = reinterpret_cast<const char*>(code + word_index + 2);
+                size_t max_name_size = (instruction_word_count - 2) * sizeof(std::uint32_t);
+                if(strnlen(import_name, max_name_size) >= 12 && std::strncmp(import_name, "NonSemantic.", 12) == 0)
+                {
+                    keep_strings = true;
+                }
+            }
+            word_index += instruction_word_count;
+        }
+
+        optimized_code.assign(code, code + SPIRV_HEADER_WORD_COUNT);
+        optimized_code.reserve(word_count);
+        for(size_t word_index = SPIRV_HEADER_WORD_COUNT; word_index < word_count;)
+        {
+            std::uint32_t opcode = code[word_index] & 0xffff;
+            std::uint32_t instruction_word_count = code[word_index] >> 16;
+            bool is_debug = opcode == OP_SOURCE_CONTINUED || opcode == OP_SOURCE || opcode == OP_SOURCE_EXTENSION
+                || opcode == OP_NAME || opcode == OP_MEMBER_NAME || opcode == OP_LINE || opcode == OP_NO_LINE
+                || opcode == OP_MODULE_PROCESSED || (opcode == OP_STRING && keep_strings == false);
+            if(is_debug == false)
+            {
+                optimized_code.insert(optimized_code.end(), code + word_index, code + word_index + instruction_word_count);
+            }
+            word_index += instruction_word_count;
+        }
+        return optimized_code.size() < word_count;
+    }
+
+    std::string VulkanShaderOptimizer::getCachePath(const VulkanUtility::Digest& code_digest) const
+    {
+        if(m_cache_directory.empty())
+        {
+            return std::string();
+        }
+
+        // The options and the pass set are part of the key, entries of other configurations never match
+        std::uint32_t key_words[] = {
+            OPTIMIZER_CACHE_VERSION,
+            m_strip_debug_info ? 1u : 0u,
+            m_optimize_performance ? 1u : 0u,
+            isOptimizerAvailable() ? 1u : 0u
+        };
+        std::uint64_t key_hash = VulkanUtility::DigestHash()(code_digest);
+        for(std::uint32_t key_word : key_words)
+        {
+            key_hash ^= key_word;
+            key_hash *= 1099511628211ull;
+        }
+#if defined(ARIEO_VULKAN_HAS_SPIRV_TOOLS)
+        // Passes of another spirv-tools release may emit different code
+        for(const char* version_char = spvSoftwareVersionString(); *version_char != '\0'; version_char++)
+        {
+            key_hash ^= static_cast<std::uint8_t>(*version_char);
+            key_hash *= 1099511628211ull;
+        }
+#endif
+
+        char key_name[17];
+        std::snprintf(key_name, sizeof(key_name), "%016llx", static_cast<unsigned long long>(key_hash));
+        return (std::filesystem::path(m_cache_directory) / (std::string(key_name) + ".spvopt")).string();
+    }
+
+    // Layout: magic, version, input size, output word count, input digest, output words. The file name is only a
+    // 64-bit hash, the stored digest tells colliding inputs apart.
+    bool VulkanShaderOptimizer::loadCacheEntry(const std::string& cache_path, size_t code_size, const VulkanUtility::Digest& code_digest, std::vector<std::uint32_t>& optimized_code) const
+    {
+        std::ifstream file(cache_path, std::ios::binary | std::ios::ate);
+        if(file.is_open() == false)
+        {
+            return false;
+        }
+        std::streamoff file_size = file.tellg();
+        file.seekg(0);
+
+        std::uint32_t header[4] = {};
+        VulkanUtility::Digest stored_digest{};
+        if(file.read(reinterpret_cast<char*>(header), sizeof(header)).fail()
+        || header[0] != OPTIMIZER_CACHE_MAGIC
+        || header[1] != OPTIMIZER_CACHE_VERSION
+        || header[2] != code_size
+        || file.read(reinterpret_cast<char*>(stored_digest.data()), stored_digest.size()).fail()
+        || stored_digest != code_digest)
+        {
+            return false;
+        }
+
+        // A truncated or corrupted file must not size the allocation
+        std::uint64_t payload_size = static_cast<std::uint64_t>(header[3]) * sizeof(std::uint32_t);
+        if(payload_size != static_cast<std::uint64_t>(file_size) - sizeof(header) - stored_digest.size())
+        {
+            Core::Logger::warn("Shader optimizer cache entry {} is corrupted", cache_path);
+            return false;
+        }
+        optimized_code.resize(header[3]);
+        if(file.read(reinterpret_cast<char*>(optimized_code.data()), payload_size).fail())
+        {
+            optimized_code.clear();
+            return false;
+        }
+
+        // An empty entry records "use the input", anything else has to be a SPIR-V module
+        if(optimized_code.empty() == false
+        && (optimized_code.size() < SPIRV_HEADER_WORD_COUNT || optimized_code[0] != SPIRV_MAGIC))
+        {
+            Core::Logger::warn("Shader optimizer cache entry {} is not SPIR-V", cache_path);
+            optimized_code.clear();
+            return false;
+        }
+        return true;
+    }
+
+    void VulkanShaderOptimizer::saveCacheEntry(const std::string& cache_path, size_t code_size, const VulkanUtility::Digest& code_digest, const std::vector<std::uint32_t>& optimized_code) const
+    {
+        std::ostringstream temp_suffix;
+        temp_suffix << ".tmp" << std::this_thread::get_id();
+        std::string temp_path = cache_path + temp_suffix.str();
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if(file.is_open() == false)
+            {
+                Core::Logger::warn("Cannot write shader optimizer cache entry {}", temp_path);
+                return;
+            }
+            std::uint32_t header[4] = {
+                OPTIMIZER_CACHE_MAGIC,
+                OPTIMIZER_CACHE_VERSION,
+                static_cast<std::uint32_t>(code_size),
+                static_cast<std::uint32_t>(optimized_code.size())
+            };
+            file.write(reinterpret_cast<const char*>(header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(code_digest.data()), code_digest.size());
+            file.write(reinterpret_cast<const char*>(optimized_code.data()), optimized_code.size() * sizeof(std::uint32_t));
+        }
+
+        std::error_code error_code;
+        std::filesystem::rename(temp_path, cache_path, error_code);
+        if(error_code)
+        {
+            std::filesystem::remove(temp_path, error_code);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../common/vulkan_utility.h"
+
+namespace Arieo
+{
+    // Load-time SPIR-V rewrite run by createShader before the module is created. With spirv-tools
+    // (ARIEO_VULKAN_ENABLE_SPIRV_TOOLS CMake option) it runs the spirv-opt performance passes (dead code elimination,
+    // constant folding, ...) and strips debug info, without it only the debug info strip is done. Results are cached
+    // in memory and optionally on disk by the SHA-256 of the input and the spirv-tools version. Thread safe.
+    class VulkanShaderOptimizer final
+    {
+    public:
+        // An empty cache_directory keeps the cache in memory only.
+        VulkanShaderOptimizer(bool strip_debug_info, bool optimize_performance, const std::string& cache_directory);
+
+        static bool isOptimizerAvailable();
+
+        // Returns false when the code has to be used as is, e.g. nothing to do or an optimizer error.
+        bool optimize(const void* code, size_t code_size, std::vector<std::uint32_t>& optimized_code);
+
+        std::uint64_t getHitCount() const { return m_hit_count; }
+        std::uint64_t getMissCount() const { return m_miss_count; }
+        // Bytes removed from all modules optimized so far, cache hits excluded
+        std::uint64_t getSavedByteCount() const { return m_saved_byte_count; }
+    private:
+        bool runPasses(const std::uint32_t* code, size_t word_count, std::vector<std::uint32_t>& optimized_code) const;
+        static bool stripDebugInfo(const std::uint32_t* code, size_t word_count, std::vector<std::uint32_t>& optimized_code);
+
+        std::string getCachePath(const VulkanUtility::Digest& code_digest) const;
+        bool loadCacheEntry(const std::string& cache_path, size_t code_size, const VulkanUtility::Digest& code_digest, std::vector<std::uint32_t>& optimized_code) const;
+        void saveCacheEntry(const std::string& cache_path, size_t code_size, const VulkanUtility::Digest& code_digest, const std::vector<std::uint32_t>& optimized_code) const;
+
+        bool m_strip_debug_info;
+        bool m_optimize_performance;
+        std::string m_cache_directory;
+
+        std::mutex m_cache_mutex;
+        // Optimized code by input digest, empty when the input is used as is
+        std::unordered_map<VulkanUtility::Digest, std::vector<std::uint32_t>, VulkanUtility::DigestHash> m_code_map;
+
+        std::uint64_t m_hit_count = 0;
+        std::uint64_t m_miss_count = 0;
+        std::uint64_t m_saved_byte_count = 0;
+    };
+}
+
+
+
+
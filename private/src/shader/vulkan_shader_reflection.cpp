@@ -0,0 +1,585 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include <vulkan.h>
+#include <vulkan_core.h>
+#include <algorithm>
+#include <cstring>
+
+#include "../vulkan_rhi.h"
+
+namespace Arieo
+{
+    namespace
+    {
+        constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+        constexpr size_t SPIRV_HEADER_WORD_COUNT = 5;
+
+        // Opcodes
+        constexpr std::uint32_t OP_ENTRY_POINT = 15;
+        constexpr std::uint32_t OP_TYPE_BOOL = 20;
+        constexpr std::uint32_t OP_TYPE_INT = 21;
+        constexpr std::uint32_t OP_TYPE_FLOAT = 22;
+        constexpr std::uint32_t OP_TYPE_VECTOR = 23;
+        constexpr std::uint32_t OP_TYPE_MATRIX = 24;
+        constexpr std::uint32_t OP_TYPE_IMAGE = 25;
+        constexpr std::uint32_t OP_TYPE_SAMPLER = 26;
+        constexpr std::uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+        constexpr std::uint32_t OP_TYPE_ARRAY = 28;
+        constexpr std::uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+        constexpr std::uint32_t OP_TYPE_STRUCT = 30;
+        constexpr std::uint32_t OP_TYPE_POINTER = 32;
+        constexpr std::uint32_t OP_CONSTANT = 43;
+        constexpr std::uint32_t OP_SPEC_CONSTANT_TRUE = 48;
+        constexpr std::uint32_t OP_SPEC_CONSTANT_FALSE = 49;
+        constexpr std::uint32_t OP_SPEC_CONSTANT = 50;
+        constexpr std::uint32_t OP_VARIABLE = 59;
+        constexpr std::uint32_t OP_DECORATE = 71;
+        constexpr std::uint32_t OP_MEMBER_DECORATE = 72;
+        constexpr std::uint32_t OP_TYPE_ACCELERATION_STRUCTURE = 5341;
+
+        // Decorations
+        constexpr std::uint32_t DECORATION_SPEC_ID = 1;
+        constexpr std::uint32_t DECORATION_BLOCK = 2;
+        constexpr std::uint32_t DECORATION_BUFFER_BLOCK = 3;
+        constexpr std::uint32_t DECORATION_ARRAY_STRIDE = 6;
+        constexpr std::uint32_t DECORATION_MATRIX_STRIDE = 7;
+        constexpr std::uint32_t DECORATION_BUILT_IN = 11;
+        constexpr std::uint32_t DECORATION_LOCATION = 30;
+        constexpr std::uint32_t DECORATION_BINDING = 33;
+        constexpr std::uint32_t DECORATION_DESCRIPTOR_SET = 34;
+        constexpr std::uint32_t DECORATION_OFFSET = 35;
+
+        // Storage classes
+        constexpr std::uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+        constexpr std::uint32_t STORAGE_CLASS_INPUT = 1;
+        constexpr std::uint32_t STORAGE_CLASS_UNIFORM = 2;
+        constexpr std::uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+        constexpr std::uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+        // Image dimensions
+        constexpr std::uint32_t DIM_BUFFER = 5;
+        constexpr std::uint32_t DIM_SUBPASS_DATA = 6;
+
+        constexpr std::uint32_t NOT_DECORATED = UINT32_MAX;
+
+        // Guards against malformed modules: the SPIR-V limit on struct members, a nesting depth no real type
+        // reaches (self-referencing types stop here) and a bound on the locations a vertex input can span
+        constexpr std::uint32_t MAX_STRUCT_MEMBER_COUNT = 16383;
+        constexpr std::uint32_t MAX_TYPE_DEPTH = 64;
+        constexpr std::uint32_t MAX_VERTEX_INPUT_LOCATION = 1024;
+
+        struct SpirvMember
+        {
+            std::uint32_t offset = 0;
+            std::uint32_t matrix_stride = 0;
+            bool is_builtin = false;
+        };
+
+        // Everything known about one result id. operands point into the code and start after the result id.
+        struct SpirvId
+        {
+            std::uint32_t opcode = 0;
+            std::uint32_t type_id = 0;
+            const std::uint32_t* operands = nullptr;
+            std::uint32_t operand_count = 0;
+
+            std::uint32_t descriptor_set = 0;
+            std::uint32_t binding = NOT_DECORATED;
+            std::uint32_t location = NOT_DECORATED;
+            std::uint32_t spec_id = NOT_DECORATED;
+            std::uint32_t array_stride = 0;
+            bool is_block = false;
+            bool is_buffer_block = false;
+            bool is_builtin = false;
+            std::vector<SpirvMember> members;
+        };
+
+        class SpirvModule
+        {
+        public:
+            bool parse(const std::uint32_t* code, size_t word_count, VulkanShaderReflection& reflection)
+            {
+                // Every id is the result of an instruction of at least two words, a larger bound is corrupt
+                if(word_count < SPIRV_HEADER_WORD_COUNT || code[0] != SPIRV_MAGIC || code[3] > word_count)
+                {
+                    return false;
+                }
+                m_ids.resize(code[3]);
+
+                bool has_entry_point = false;
+                const std::uint32_t* word = code + SPIRV_HEADER_WORD_COUNT;
+                const std::uint32_t* code_end = code + word_count;
+                while(word < code_end)
+                {
+                    std::uint32_t instruction_word_count = word[0] >> 16;
+                    std::uint32_t opcode = word[0] & 0xffff;
+                    if(instruction_word_count == 0 || word + instruction_word_count > code_end)
+                    {
+                        return false;
+                    }
+
+                    switch(opcode)
+                    {
+                    case OP_ENTRY_POINT:
+                        // Only the first entry point is reflected, the name is a nul terminated string of words
+                        if(has_entry_point == false && instruction_word_count > 3)
+                        {
+                            has_entry_point = true;
+                            reflection.stage = getStage(word[1]);
+                            const char* name = reinterpret_cast<const char*>(word + 3);
+                            reflection.entry_point.assign(name, strnlen(name, (instruction_word_count - 3) * sizeof(std::uint32_t)));
+                        }
+                        break;
+                    case OP_DECORATE:
+                        if(instruction_word_count >= 3 && isValidId(word[1]))
+                        {
+                            decorate(m_ids[word[1]], word[2], instruction_word_count > 3 ? word[3] : 0);
+                        }
+                        break;
+                    case OP_MEMBER_DECORATE:
+                        if(instruction_word_count >= 4 && isValidId(word[1]) && word[2] < MAX_STRUCT_MEMBER_COUNT)
+                        {
+                            decorateMember(m_ids[word[1]], word[2], word[3], instruction_word_count > 4 ? word[4] : 0);
+                        }
+                        break;
+                    case OP_TYPE_BOOL:
+                    case OP_TYPE_INT:
+                    case OP_TYPE_FLOAT:
+                    case OP_TYPE_VECTOR:
+                    case OP_TYPE_MATRIX:
+                    case OP_TYPE_IMAGE:
+                    case OP_TYPE_SAMPLER:
+                    case OP_TYPE_SAMPLED_IMAGE:
+                    case OP_TYPE_ARRAY:
+                    case OP_TYPE_RUNTIME_ARRAY:
+                    case OP_TYPE_STRUCT:
+                    case OP_TYPE_POINTER:
+                    case OP_TYPE_ACCELERATION_STRUCTURE:
+                        if(instruction_word_count >= 2 && isValidId(word[1]))
+                        {
+                            SpirvId& id = m_ids[word[1]];
+                            id.opcode = opcode;
+                            id.operands = word + 2;
+                            id.operand_count = instruction_word_count - 2;
+                        }
+                        break;
+                    case OP_CONSTANT:
+                    case OP_SPEC_CONSTANT_TRUE:
+                    case OP_SPEC_CONSTANT_FALSE:
+                    case OP_SPEC_CONSTANT:
+                    case OP_VARIABLE:
+                        if(instruction_word_count >= 3 && isValidId(word[2]))
+                        {
+                            SpirvId& id = m_ids[word[2]];
+                            id.opcode = opcode;
+                            id.type_id = word[1];
+                            id.operands = word + 3;
+                            id.operand_count = instruction_word_count - 3;
+                        }
+                        break;
+                    default:
+                        break;
+                    }
+                    word += instruction_word_count;
+                }
+                if(has_entry_point == false)
+                {
+                    return false;
+                }
+
+                for(std::uint32_t id_index = 0; id_index < m_ids.size(); id_index++)
+                {
+                    const SpirvId& id = m_ids[id_index];
+                    if(id.opcode == OP_VARIABLE && id.operand_count >= 1)
+                    {
+                        reflectVariable(id, reflection);
+                    }
+                    else if(id.spec_id != NOT_DECORATED
+                        && (id.opcode == OP_SPEC_CONSTANT || id.opcode == OP_SPEC_CONSTANT_TRUE || id.opcode == OP_SPEC_CONSTANT_FALSE))
+                    {
+                        VulkanShaderReflection::SpecializationConstant specialization_constant;
+                        specialization_constant.constant_id = id.spec_id;
+                        specialization_constant.size = getTypeSize(id.type_id, 0, 0);
+                        if(id.opcode == OP_SPEC_CONSTANT)
+                        {
+                            specialization_constant.default_value = getConstantValue(id_index);
+                        }
+                        else
+                        {
+                            specialization_constant.default_value = id.opcode == OP_SPEC_CONSTANT_TRUE ? 1 : 0;
+                        }
+                        reflection.specialization_constants.emplace_back(specialization_constant);
+                    }
+                }
+                return true;
+            }
+        private:
+            static VkShaderStageFlagBits getStage(std::uint32_t execution_model)
+            {
+                switch(execution_model)
+                {
+                case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+                case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+                case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+                case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+                case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+                case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+                default: return VK_SHADER_STAGE_ALL;
+                }
+            }
+
+            bool isValidId(std::uint32_t id) const
+            {
+                return id < m_ids.size();
+            }
+
+            static void decorate(SpirvId& id, std::uint32_t decoration, std::uint32_t literal)
+            {
+                switch(decoration)
+                {
+                case DECORATION_SPEC_ID: id.spec_id = literal; break;
+                case DECORATION_BLOCK: id.is_block = true; break;
+                case DECORATION_BUFFER_BLOCK: id.is_buffer_block = true; break;
+                case DECORATION_ARRAY_STRIDE: id.array_stride = literal; break;
+                case DECORATION_BUILT_IN: id.is_builtin = true; break;
+                case DECORATION_LOCATION: id.location = literal; break;
+                case DECORATION_BINDING: id.binding = literal; break;
+                case DECORATION_DESCRIPTOR_SET: id.descriptor_set = literal; break;
+                default: break;
+                }
+            }
+
+            static void decorateMember(SpirvId& id, std::uint32_t member_index, std::uint32_t decoration, std::uint32_t literal)
+            {
+                if(id.members.size() <= member_index)
+                {
+                    id.members.resize(member_index + 1);
+                }
+                switch(decoration)
+                {
+                case DECORATION_OFFSET: id.members[member_index].offset = literal; break;
+                case DECORATION_MATRIX_STRIDE: id.members[member_index].matrix_stride = literal; break;
+                case DECORATION_BUILT_IN: id.members[member_index].is_builtin = true; break;
+                default: break;
+                }
+            }
+
+            const SpirvId* getId(std::uint32_t id) const
+            {
+                return isValidId(id) ? &m_ids[id] : nullptr;
+            }
+
+            std::uint64_t getConstantValue(std::uint32_t constant_id) const
+            {
+                const SpirvId* constant = getId(constant_id);
+                if(constant == nullptr || constant->operand_count == 0)
+                {
+                    return 0;
+                }
+                std::uint64_t value = constant->operands[0];
+                if(constant->operand_count > 1)
+                {
+                    value |= static_cast<std::uint64_t>(constant->operands[1]) << 32;
+                }
+                return value;
+            }
+
+            // Size in bytes with explicit layout decorations, 0 for opaque and runtime sized types.
+            std::uint32_t getTypeSize(std::uint32_t type_id, std::uint32_t matrix_stride, std::uint32_t depth) const
+            {
+                const SpirvId* type = getId(type_id);
+                if(type == nullptr || depth >= MAX_TYPE_DEPTH)
+                {
+                    return 0;
+                }
+                switch(type->opcode)
+                {
+                case OP_TYPE_BOOL:
+                    return sizeof(VkBool32);
+                case OP_TYPE_INT:
+                case OP_TYPE_FLOAT:
+                    return type->operand_count >= 1 ? type->operands[0] / 8 : 0;
+                case OP_TYPE_VECTOR:
+                    return type->operand_count >= 2 ? getTypeSize(type->operands[0], 0, depth + 1) * type->operands[1] : 0;
+                case OP_TYPE_MATRIX:
+                    if(type->operand_count < 2)
+                    {
+                        return 0;
+                    }
+                    return (matrix_stride != 0 ? matrix_stride : getTypeSize(type->operands[0], 0, depth + 1)) * type->operands[1];
+                case OP_TYPE_ARRAY:
+                {
+                    if(type->operand_count < 2)
+                    {
+                        return 0;
+                    }
+                    std::uint32_t element_size = type->array_stride != 0 ? type->array_stride : getTypeSize(type->operands[0], matrix_stride, depth + 1);
+                    return element_size * static_cast<std::uint32_t>(getConstantValue(type->operands[1]));
+                }
+                case OP_TYPE_STRUCT:
+                {
+                    std::uint32_t struct_size = 0;
+                    for(std::uint32_t member_index = 0; member_index < type->operand_count; member_index++)
+                    {
+                        SpirvMember member = member_index < type->members.size() ? type->members[member_index] : SpirvMember{};
+                        struct_size = std::max(struct_size, member.offset + getTypeSize(type->operands[member_index], member.matrix_stride, depth + 1));
+                    }
+                    return struct_size;
+                }
+                default:
+                    return 0;
+                }
+            }
+
+            static VkFormat getVertexFormat(std::uint32_t component_opcode, std::uint32_t width, bool is_signed, std::uint32_t component_count)
+            {
+                static constexpr VkFormat float16_formats[] = {VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT};
+                static constexpr VkFormat float32_formats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+                static constexpr VkFormat float64_formats[] = {VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+                static constexpr VkFormat sint8_formats[] = {VK_FORMAT_R8_SINT, VK_FORMAT_R8G8_SINT, VK_FORMAT_R8G8B8_SINT, VK_FORMAT_R8G8B8A8_SINT};
+                static constexpr VkFormat uint8_formats[] = {VK_FORMAT_R8_UINT, VK_FORMAT_R8G8_UINT, VK_FORMAT_R8G8B8_UINT, VK_FORMAT_R8G8B8A8_UINT};
+                static constexpr VkFormat sint16_formats[] = {VK_FORMAT_R16_SINT, VK_FORMAT_R16G16_SINT, VK_FORMAT_R16G16B16_SINT, VK_FORMAT_R16G16B16A16_SINT};
+                static constexpr VkFormat uint16_formats[] = {VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT, VK_FORMAT_R16G16B16_UINT, VK_FORMAT_R16G16B16A16_UINT};
+                static constexpr VkFormat sint32_formats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+                static constexpr VkFormat uint32_formats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+                if(component_count == 0 || component_count > 4)
+                {
+                    return VK_FORMAT_UNDEFINED;
+                }
+                const VkFormat* formats = nullptr;
+                if(component_opcode == OP_TYPE_FLOAT)
+                {
+                    formats = width == 16 ? float16_formats : width == 64 ? float64_formats : float32_formats;
+                }
+                else if(component_opcode == OP_TYPE_INT)
+                {
+                    switch(width)
+                    {
+                    case 8: formats = is_signed ? sint8_formats : uint8_formats; break;
+                    case 16: formats = is_signed ? sint16_formats : uint16_formats; break;
+                    default: formats = is_signed ? sint32_formats : uint32_formats; break;
+                    }
+                }
+                return formats != nullptr ? formats[component_count - 1] : VK_FORMAT_UNDEFINED;
+            }
+
+            // Scalars and vectors take one location, matrices one per column, arrays one per element.
+            void addVertexInputs(std::uint32_t type_id, std::uint64_t location, VulkanShaderReflection& reflection, std::uint32_t depth) const
+            {
+                const SpirvId* type = getId(type_id);
+                if(type == nullptr || depth >= MAX_TYPE_DEPTH || location >= MAX_VERTEX_INPUT_LOCATION)
+                {
+                    return;
+                }
+                if(type->opcode == OP_TYPE_ARRAY && type->operand_count >= 2)
+                {
+                    std::uint64_t element_count = getConstantValue(type->operands[1]);
+                    std::uint64_t element_location_count = std::max<std::uint64_t>(getLocationCount(type->operands[0], depth + 1), 1);
+                    for(std::uint64_t element_index = 0; element_index < element_count && location + element_index * element_location_count < MAX_VERTEX_INPUT_LOCATION; element_index++)
+                    {
+                        addVertexInputs(type->operands[0], location + element_index * element_location_count, reflection, depth + 1);
+                    }
+                    return;
+                }
+                if(type->opcode == OP_TYPE_MATRIX && type->operand_count >= 2)
+                {
+                    for(std::uint32_t column_index = 0; column_index < type->operands[1] && location + column_index < MAX_VERTEX_INPUT_LOCATION; column_index++)
+                    {
+                        addVertexInputs(type->operands[0], location + column_index, reflection, depth + 1);
+                    }
+                    return;
+                }
+
+                std::uint32_t component_type_id = type_id;
+                std::uint32_t component_count = 1;
+                if(type->opcode == OP_TYPE_VECTOR && type->operand_count >= 2)
+                {
+                    component_type_id = type->operands[0];
+                    component_count = type->operands[1];
+                }
+                const SpirvId* component_type = getId(component_type_id);
+                if(component_type == nullptr || component_type->operand_count == 0)
+                {
+                    return;
+                }
+
+                VulkanShaderReflection::VertexInput vertex_input;
+                vertex_input.location = static_cast<std::uint32_t>(location);
+                vertex_input.format = getVertexFormat(
+                    component_type->opcode,
+                    component_type->operands[0],
+                    component_type->opcode == OP_TYPE_INT && component_type->operand_count >= 2 && component_type->operands[1] != 0,
+                    component_count
+                );
+                vertex_input.size = getTypeSize(type_id, 0, depth);
+                reflection.vertex_inputs.emplace_back(vertex_input);
+            }
+
+            std::uint32_t getLocationCount(std::uint32_t type_id, std::uint32_t depth) const
+            {
+                const SpirvId* type = getId(type_id);
+                if(depth >= MAX_TYPE_DEPTH)
+                {
+                    return 1;
+                }
+                if(type != nullptr && type->opcode == OP_TYPE_MATRIX && type->operand_count >= 2)
+                {
+                    return type->operands[1];
+                }
+                if(type != nullptr && type->opcode == OP_TYPE_ARRAY && type->operand_count >= 2)
+                {
+                    return getLocationCount(type->operands[0], depth + 1) * static_cast<std::uint32_t>(getConstantValue(type->operands[1]));
+                }
+                return 1;
+            }
+
+            VkDescriptorType getDescriptorType(const SpirvId& type, std::uint32_t storage_class) const
+            {
+                switch(type.opcode)
+                {
+                case OP_TYPE_STRUCT:
+                    if(storage_class == STORAGE_CLASS_STORAGE_BUFFER || type.is_buffer_block)
+                    {
+                        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    }
+                    return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                case OP_TYPE_IMAGE:
+                {
+                    if(type.operand_count < 6)
+                    {
+                        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+                    }
+                    std::uint32_t dim = type.operands[1];
+                    bool is_storage = type.operands[5] == 2;
+                    if(dim == DIM_SUBPASS_DATA)
+                    {
+                        return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                    }
+                    if(dim == DIM_BUFFER)
+                    {
+                        return is_storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                    }
+                    return is_storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                }
+                case OP_TYPE_SAMPLER:
+                    return VK_DESCRIPTOR_TYPE_SAMPLER;
+                case OP_TYPE_SAMPLED_IMAGE:
+                    return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                case OP_TYPE_ACCELERATION_STRUCTURE:
+                    return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                default:
+                    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+                }
+            }
+
+            void reflectVariable(const SpirvId& variable, VulkanShaderReflection& reflection) const
+            {
+                // OpTypePointer operands are the storage class and the pointee type
+                const SpirvId* pointer_type = getId(variable.type_id);
+                if(pointer_type == nullptr || pointer_type->opcode != OP_TYPE_POINTER || pointer_type->operand_count < 2)
+                {
+                    return;
+                }
+                std::uint32_t storage_class = variable.operands[0];
+                std::uint32_t type_id = pointer_type->operands[1];
+
+                if(storage_class == STORAGE_CLASS_PUSH_CONSTANT)
+                {
+                    const SpirvId* block_type = getId(type_id);
+                    if(block_type == nullptr || block_type->opcode != OP_TYPE_STRUCT || block_type->members.empty())
+                    {
+                        return;
+                    }
+                    std::uint32_t offset = UINT32_MAX;
+                    for(const SpirvMember& member : block_type->members)
+                    {
+                        offset = std::min(offset, member.offset);
+                    }
+                    VkPushConstantRange push_constant_range{};
+                    push_constant_range.stageFlags = reflection.stage;
+                    push_constant_range.offset = offset;
+                    push_constant_range.size = getTypeSize(type_id, 0, 0) - offset;
+                    reflection.push_constant_ranges.emplace_back(push_constant_range);
+                    return;
+                }
+
+                if(storage_class == STORAGE_CLASS_INPUT)
+                {
+                    if(reflection.stage == VK_SHADER_STAGE_VERTEX_BIT && variable.location != NOT_DECORATED && variable.is_builtin == false)
+                    {
+                        addVertexInputs(type_id, variable.location, reflection, 0);
+                    }
+                    return;
+                }
+
+                if(variable.binding == NOT_DECORATED
+                || (storage_class != STORAGE_CLASS_UNIFORM_CONSTANT && storage_class != STORAGE_CLASS_UNIFORM && storage_class != STORAGE_CLASS_STORAGE_BUFFER))
+                {
+                    return;
+                }
+
+                // Arrays of descriptors become the descriptor count
+                std::uint32_t descriptor_count = 1;
+                const SpirvId* type = getId(type_id);
+                std::uint32_t depth = 0;
+                while(type != nullptr && (type->opcode == OP_TYPE_ARRAY || type->opcode == OP_TYPE_RUNTIME_ARRAY) && type->operand_count >= 1)
+                {
+                    if(++depth >= MAX_TYPE_DEPTH)
+                    {
+                        return;
+                    }
+                    descriptor_count = type->opcode == OP_TYPE_ARRAY && type->operand_count >= 2
+                        ? descriptor_count * static_cast<std::uint32_t>(getConstantValue(type->operands[1]))
+                        : 0;
+                    type = getId(type->operands[0]);
+                }
+                if(type == nullptr)
+                {
+                    return;
+                }
+
+                VkDescriptorType vk_descriptor_type = getDescriptorType(*type, storage_class);
+                if(vk_descriptor_type == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+                {
+                    return;
+                }
+
+                VulkanShaderReflection::DescriptorBinding descriptor_binding;
+                descriptor_binding.set = variable.descriptor_set;
+                descriptor_binding.vk_binding.binding = variable.binding;
+                descriptor_binding.vk_binding.descriptorType = vk_descriptor_type;
+                descriptor_binding.vk_binding.descriptorCount = descriptor_count;
+                descriptor_binding.vk_binding.stageFlags = reflection.stage;
+                reflection.descriptor_bindings.emplace_back(descriptor_binding);
+            }
+
+            std::vector<SpirvId> m_ids;
+        };
+    }
+
+    VulkanShaderReflection VulkanShaderReflector::reflect(const void* code, size_t code_size)
+    {
+        VulkanShaderReflection reflection;
+        SpirvModule spirv_module;
+        if(code_size % sizeof(std::uint32_t) != 0
+        || spirv_module.parse(static_cast<const std::uint32_t*>(code), code_size / sizeof(std::uint32_t), reflection) == false)
+        {
+            return VulkanShaderReflection{};
+        }
+
+        std::sort(reflection.descriptor_bindings.begin(), reflection.descriptor_bindings.end(),
+            [](const VulkanShaderReflection::DescriptorBinding& a, const VulkanShaderReflection::DescriptorBinding& b)
+            {
+                return a.set != b.set ? a.set < b.set : a.vk_binding.binding < b.vk_binding.binding;
+            });
+        std::sort(reflection.vertex_inputs.begin(), reflection.vertex_inputs.end(),
+            [](const VulkanShaderReflection::VertexInput& a, const VulkanShaderReflection::VertexInput& b) { return a.location < b.location; });
+        std::sort(reflection.specialization_constants.begin(), reflection.specialization_constants.end(),
+            [](const VulkanShaderReflection::SpecializationConstant& a, const VulkanShaderReflection::SpecializationConstant& b) { return a.constant_id < b.constant_id; });
+
+        reflection.is_valid = true;
+        return reflection;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "interface/rhi/rhi.h"
+#include <vulkan.h>
+#include <string>
+#include <vector>
+
+namespace Arieo
+{
+    // Interface of one shader entry point as declared in its SPIR-V.
+    struct VulkanShaderReflection
+    {
+        struct DescriptorBinding
+        {
+            std::uint32_t set = 0;
+            // stageFlags is the stage of this shader, descriptorCount is 0 for runtime sized arrays
+            VkDescriptorSetLayoutBinding vk_binding{};
+        };
+
+        struct VertexInput
+        {
+            std::uint32_t location = 0;
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            std::uint32_t size = 0;
+        };
+
+        struct SpecializationConstant
+        {
+            std::uint32_t constant_id = 0;
+            // 4 for bool (VkBool32), 8 for 64 bit types
+            std::uint32_t size = 0;
+            std::uint64_t default_value = 0;
+        };
+
+        bool is_valid = false;
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+        std::string entry_point = "main";
+
+        // Sorted by set then binding
+        std::vector<DescriptorBinding> descriptor_bindings;
+        std::vector<VkPushConstantRange> push_constant_ranges;
+        // Vertex shaders only, sorted by location. Matrices and arrays take one location per column or element.
+        std::vector<VertexInput> vertex_inputs;
+        // Sorted by constant_id
+        std::vector<SpecializationConstant> specialization_constants;
+
+        std::uint32_t getDescriptorSetCount() const
+        {
+            return descriptor_bindings.empty() ? 0 : descriptor_bindings.back().set + 1;
+        }
+    };
+
+    // Minimal SPIR-V parser, reads decorations, types and global variables and nothing else.
+    class VulkanShaderReflector
+    {
+    public:
+        // is_valid stays false when the code is not well formed SPIR-V.
+        static VulkanShaderReflection reflect(const void* code, size_t code_size);
+    };
+}
+
+
+
+
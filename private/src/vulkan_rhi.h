@@ -2,21 +2,39 @@
 
 #include "enums/vulkan_enums.h"
 #include "instance/vulkan_instance.h"
+#include "device/vulkan_device_features.h"
 #include "device/vulkan_device.h"
 #include "framebuffer/vulkan_framebuffer.h"
 #include "surface/vulkan_surface.h"
 #include "common/vulkan_utility.h"
 #include "queue/vulkan_present_command_queue.h"
 #include "image/vulkan_image.h"
+#include "shader/vulkan_shader_reflection.h"
 #include "shader/vulkan_shader.h"
+#include "shader/vulkan_shader_cache.h"
+#include "shader/vulkan_shader_compiler.h"
+#include "shader/vulkan_shader_optimizer.h"
 #include "pipeline/vulkan_pipeline.h"
+#include "pipeline/vulkan_pipeline_variants.h"
+#include "pipeline/vulkan_pipeline_library.h"
 #include "fence/vulkan_fence.h"
 #include "semaphore/vulkan_semaphore.h"
 #include "swapchain/vulkan_swapchain.h"
 #include "queue/vulkan_render_command_queue.h"
+#include "event/vulkan_event.h"
+#include "command/vulkan_barrier_batch.h"
+#include "command/vulkan_command_state.h"
 #include "command/vulkan_command.h"
+#include "command/vulkan_thread_command_pools.h"
+#include "command/vulkan_frame_command_pools.h"
 #include "buffer/vulkan_buffer.h"
 #include "descriptor/vulkan_descriptor.h"
+#include "descriptor/vulkan_descriptor_allocator.h"
+#include "descriptor/vulkan_descriptor_cache.h"
+#include "descriptor/vulkan_descriptor_writer.h"
+#include "descriptor/vulkan_bindless_heap.h"
+#include "descriptor/vulkan_descriptor_buffer.h"
+#include "readback/vulkan_readback.h"
 
 
 